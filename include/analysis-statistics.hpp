@@ -0,0 +1,238 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __PERCOLATION_ANALYSIS_STATISTICS_H__
+#define __PERCOLATION_ANALYSIS_STATISTICS_H__
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Statistics are only collected if the library is built with PERCOLATION_STATISTICS defined
+ * (cmake option PERCOLATION_ENABLE_STATISTICS). Otherwise all code within PERCOLATION_STAT() is removed by the preprocessor.
+ */
+#ifdef PERCOLATION_STATISTICS
+#define PERCOLATION_STAT(statement) statement
+#else
+#define PERCOLATION_STAT(statement)
+#endif
+
+namespace percolation
+{
+    /**
+     * @brief Check whether the library collects statistics at all
+     * 
+     * @return true The library has been built with PERCOLATION_STATISTICS
+     * @return false Statistics objects passed to the library are never filled
+     */
+    constexpr bool statistics_enabled()
+    {
+#ifdef PERCOLATION_STATISTICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Timings and counters of the conversion and analysis of graphs
+     * 
+     * All values are added up over all calls the object is registered for, call reset() to look at single frames.
+     * Times are wall times in seconds.
+     */
+    struct AnalysisStatistics
+    {
+        // Phases of MolecularGraph::fill_percolation_graph() and get_percolation_graph()
+        double normalization_time = 0.0;
+        double translation_time = 0.0;
+        double graph_build_time = 0.0;
+
+        // Phases of PercolationGraph::get_component_percolation_info() and get_component_labels()
+        double adjacency_time = 0.0;
+        double labeling_time = 0.0;
+        double analysis_time = 0.0;
+        double result_time = 0.0;
+
+        size_t num_bonds_converted = 0;
+
+        /**
+         * @brief Vertices taken from the bfs queue and edges examined from them
+         */
+        size_t vertices_visited = 0;
+        size_t edges_visited = 0;
+
+        size_t queue_pushes = 0;
+
+        /**
+         * @brief Largest number of vertices waiting in a bfs queue at the same time
+         */
+        size_t peak_queue_length = 0;
+
+        /**
+         * @brief Number of cycle translations checked for linear independence
+         */
+        size_t independence_checks = 0;
+
+        /**
+         * @brief Number of work buffers that had to be (re)allocated, stays 0 once reused workspaces are large enough
+         */
+        size_t allocations = 0;
+
+        size_t num_components = 0;
+
+        /**
+         * @brief Entry b counts the components with 2^b to 2^(b+1)-1 vertices
+         */
+        std::vector<size_t> component_size_histogram;
+
+        void reset()
+        {
+            *this = AnalysisStatistics();
+        }
+
+        void add_component_size(size_t size)
+        {
+            size_t bin = 0;
+            while (size >> (bin + 1))
+            {
+                bin++;
+            }
+            if (component_size_histogram.size() <= bin)
+            {
+                component_size_histogram.resize(bin + 1, 0);
+            }
+            component_size_histogram[bin]++;
+        }
+    };
+
+    /**
+     * @brief Counters of a single bfs, which are summed up into AnalysisStatistics after the (possibly parallel) analysis
+     */
+    struct BfsCounters
+    {
+        size_t vertices_visited = 0;
+        size_t edges_visited = 0;
+        size_t queue_pushes = 0;
+        size_t peak_queue_length = 0;
+        size_t independence_checks = 0;
+
+        void add_to(AnalysisStatistics &statistics) const
+        {
+            statistics.vertices_visited += vertices_visited;
+            statistics.edges_visited += edges_visited;
+            statistics.queue_pushes += queue_pushes;
+            statistics.peak_queue_length = (peak_queue_length > statistics.peak_queue_length ? peak_queue_length : statistics.peak_queue_length);
+            statistics.independence_checks += independence_checks;
+        }
+    };
+
+    /**
+     * @brief Measures consecutive phases of a function, does nothing without statistics object
+     */
+    class PhaseClock
+    {
+    public:
+        explicit PhaseClock(AnalysisStatistics *statistics) : statistics(statistics)
+        {
+            if (statistics != nullptr)
+            {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        /**
+         * @brief Add the time since the end of the previous phase to the given phase
+         * 
+         * @param phase Pointer to the member of AnalysisStatistics for the phase
+         */
+        void stop(double AnalysisStatistics::*phase)
+        {
+            if (statistics != nullptr)
+            {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                statistics->*phase += std::chrono::duration<double>(now - start).count();
+                start = now;
+            }
+        }
+
+    protected:
+        AnalysisStatistics *statistics;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * @brief Detects which of a set of buffers have been reallocated
+     */
+    class BufferWatch
+    {
+    public:
+        template <typename Vector>
+        void add(const Vector &buffer)
+        {
+            if (num_buffers < max_buffers)
+            {
+                buffers[num_buffers] = &buffer;
+                get_data[num_buffers] = &buffer_data<Vector>;
+                old_data[num_buffers] = buffer.data();
+                num_buffers++;
+            }
+        }
+
+        /**
+         * @brief Get the number of buffers whose storage changed since they have been added
+         * 
+         * @return size_t 
+         */
+        size_t count_allocations() const
+        {
+            size_t num_allocations = 0;
+            for (size_t b = 0; b < num_buffers; b++)
+            {
+                num_allocations += (get_data[b](buffers[b]) != old_data[b] ? 1 : 0);
+            }
+            return num_allocations;
+        }
+
+    protected:
+        static const size_t max_buffers = 16;
+
+        template <typename Vector>
+        static const void *buffer_data(const void *buffer)
+        {
+            return static_cast<const Vector *>(buffer)->data();
+        }
+
+        size_t num_buffers = 0;
+        const void *buffers[max_buffers];
+        const void *(*get_data[max_buffers])(const void *);
+        const void *old_data[max_buffers];
+    };
+}
+
+#endif
\ No newline at end of file
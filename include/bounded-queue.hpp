@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __PERCOLATION_BOUNDED_QUEUE_H__
+#define __PERCOLATION_BOUNDED_QUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace percolation
+{
+    /**
+     * @brief Blocking queue of limited capacity to pass work between the threads of a pipeline
+     * 
+     * Producers block while the queue is full and consumers block while it is empty. Once the queue is closed, 
+     * nothing can be added anymore and consumers receive the remaining elements before pop() fails.
+     * 
+     * @tparam T The type of the elements, needs to be movable
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        /**
+         * @brief Construct a new queue
+         * 
+         * @param capacity The maximum number of elements in the queue, at least 1
+         */
+        explicit BoundedQueue(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+        /**
+         * @brief Add an element, waiting while the queue is full
+         * 
+         * @param value 
+         * @return true 
+         * @return false The queue has been closed and the element was not added
+         */
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return closed || items.size() < capacity; });
+            if (closed)
+            {
+                return false;
+            }
+            items.push_back(std::move(value));
+            lock.unlock();
+            not_empty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Remove the oldest element, waiting while the queue is empty and not closed
+         * 
+         * @param value Output of the element
+         * @return true 
+         * @return false The queue has been closed and is empty
+         */
+        bool pop(T &value)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+            if (items.empty())
+            {
+                return false;
+            }
+            value = std::move(items.front());
+            items.pop_front();
+            lock.unlock();
+            not_full.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Close the queue and wake up all waiting threads
+         */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+            }
+            not_full.notify_all();
+            not_empty.notify_all();
+        }
+
+    protected:
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+        std::deque<T> items;
+        size_t capacity;
+        bool closed = false;
+    };
+}
+
+#endif
\ No newline at end of file
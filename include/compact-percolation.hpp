@@ -0,0 +1,356 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __COMPACT_PERCOLATION_H__
+#define __COMPACT_PERCOLATION_H__
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "percolation-detection.hpp"
+
+namespace percolation
+{
+    /**
+     * @brief Translation vector with all entries packed into one unsigned integer
+     * 
+     * Every axis takes Bits bits in two's complement. With the default of 2 bits, the entries -1, 0 and 1 of bonds between
+     * neighboring periodic cells fit, so a 3d translation takes a single byte.
+     * 
+     * @tparam Dim The vector space dimension
+     * @tparam Bits The number of bits per entry
+     */
+    template <size_t Dim, unsigned Bits>
+    struct BasicPackedTranslation
+    {
+        static_assert(Bits >= 2 && Dim * Bits <= 64, "The packed entries need to fit into 64 bits");
+
+        using storage_type = typename std::conditional<Dim * Bits <= 8, uint8_t,
+                                                       typename std::conditional<Dim * Bits <= 16, uint16_t,
+                                                                                 typename std::conditional<Dim * Bits <= 32, uint32_t, uint64_t>::type>::type>::type;
+
+        static constexpr int64_t min_entry = -(int64_t(1) << (Bits - 1));
+        static constexpr int64_t max_entry = (int64_t(1) << (Bits - 1)) - 1;
+
+        storage_type bits = 0;
+
+        /**
+         * @brief Pack a translation vector
+         * 
+         * @tparam Coord 
+         * @param trans The translation to be packed
+         * @param packed Output of the packed translation
+         * @return true The translation has been packed
+         * @return false An entry is outside of [min_entry, max_entry], @p packed is left unchanged
+         */
+        template <typename Coord>
+        static bool pack(const BasicTranslationVector<Dim, Coord> &trans, BasicPackedTranslation &packed)
+        {
+            const uint64_t mask = (uint64_t(1) << Bits) - 1;
+            uint64_t res = 0;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                // Compared in 64 bit, as the limits may not fit into Coord
+                int64_t entry = int64_t(trans.vec[i]);
+                if (entry < min_entry || entry > max_entry)
+                {
+                    return false;
+                }
+                res |= (uint64_t(entry) & mask) << (i * Bits);
+            }
+            packed.bits = storage_type(res);
+            return true;
+        }
+
+        /**
+         * @brief Get the translation vector back
+         * 
+         * @tparam Coord 
+         * @return BasicTranslationVector<Dim, Coord> 
+         */
+        template <typename Coord>
+        BasicTranslationVector<Dim, Coord> unpack() const
+        {
+            const uint64_t mask = (uint64_t(1) << Bits) - 1;
+            BasicTranslationVector<Dim, Coord> res;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                int64_t entry = int64_t((uint64_t(bits) >> (i * Bits)) & mask);
+                // Sign extension of the two's complement entry
+                res.vec[i] = Coord(entry > max_entry ? entry - (int64_t(1) << Bits) : entry);
+            }
+            return res;
+        }
+    };
+
+    /**
+     * @brief Weighted union-find with the translation of every vertex relative to its root, sized for very large systems
+     * 
+     * Follows the same scheme as IncrementalPercolationGraph, but stores the parents and basis slots as Index, a rank of one
+     * byte instead of the component size and the offsets to the parents in offset_type. For 32 bit indices in 3d this takes
+     * 21 bytes per vertex instead of the 56 bytes of IncrementalPercolationGraph<3, int8_t>.
+     * The offsets are accumulated in 64 bit and only narrowed for storage. A vertex may therefore be at most 2^31 - 1 cells
+     * away from its root along the merged edges for 32 bit indices, i.e. a chain of over 2^31 bonds winding in the same direction.
+     * 
+     * @tparam Dim The vector space dimension of the periodic system
+     * @tparam Index The unsigned type of the vertex indices
+     */
+    template <size_t Dim, typename Index = uint32_t>
+    class BasicCompactUnionFind
+    {
+    public:
+        using offset_type = typename std::conditional<sizeof(Index) <= 4, int32_t, int64_t>::type;
+        using position_type = typename BasicPercolationGraph<Dim, offset_type>::position_type;
+        using basis_type = typename BasicPercolationGraph<Dim, offset_type>::basis_type;
+
+        /**
+         * @brief Remove all edges and start over with @p num_vertices isolated vertices, keeping the allocated memory
+         * 
+         * @param num_vertices At most one more than the maximum of Index
+         */
+        void reset(size_t num_vertices);
+
+        /**
+         * @brief Merge the components of two vertices or add the lattice vector of the cycle closed by the edge
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans The translation pointing from the base to the head vertex
+         */
+        void add_edge(Index vertex_index_base, Index vertex_index_head, const position_type &edge_trans);
+
+        /**
+         * @brief Get a list of all connected components and their respective percolation information.
+         * 
+         * Same ordering as IncrementalPercolationGraph::get_component_percolation_info(). The basis slots of the roots are
+         * reused for the component numbers, so reset() needs to be called before adding further edges.
+         * 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info();
+
+        /**
+         * @brief Get the number of bytes taken per vertex, not counting the bases of percolating components
+         * 
+         * @return size_t 
+         */
+        static constexpr size_t get_vertex_memory()
+        {
+            return 2 * sizeof(Index) + sizeof(uint8_t) + Dim * sizeof(offset_type);
+        }
+
+    protected:
+        /**
+         * @brief The parent of each vertex in the union-find forest. Roots are their own parent.
+         */
+        std::vector<Index> parent;
+
+        /**
+         * @brief The translation of each vertex relative to its parent
+         */
+        std::vector<BasicTranslationVector<Dim, offset_type>> parent_offset;
+
+        /**
+         * @brief Upper bound of the tree height below a root, which does not exceed log2 of the number of vertices
+         */
+        std::vector<uint8_t> rank;
+
+        /**
+         * @brief Index into lattice_bases of the lattice vectors of a component, only valid for roots
+         */
+        std::vector<Index> basis_index;
+
+        std::vector<basis_type> lattice_bases;
+        std::vector<Index> free_bases;
+
+        size_t num_components = 0;
+
+        /**
+         * @brief Find the root of a vertex and compress the path to it
+         * 
+         * @param vertex_index 
+         * @param position Output of the translation of the vertex relative to the root
+         * @return Index The root of the vertex
+         */
+        Index find_root(Index vertex_index, position_type &position);
+
+        /**
+         * @brief Add a lattice vector to the basis of a component root if it is linearly independent of it
+         * 
+         * @param root 
+         * @param lattice_vector 
+         */
+        void add_lattice_vector(Index root, const position_type &lattice_vector);
+    };
+
+    /**
+     * @brief Memory-saving alternative to PercolationGraph for very large systems
+     * 
+     * Every undirected edge is stored once, as two Index vertex indices and a packed translation in separate arrays. 
+     * For the defaults (32 bit indices, 2 bits per axis) an edge takes 9 bytes in 3d, compared to two half-edges of 32 bytes 
+     * in PercolationGraph.
+     * Without adjacency lists there is no bfs. The analysis instead streams the edge list once through the weighted union-find 
+     * of BasicCompactUnionFind, which needs only one direction per edge. It adds 21 bytes per vertex for the defaults in 3d
+     * (see analysis_graph_type::get_vertex_memory()), and the returned ComponentInfo lists take another 8 bytes per vertex.
+     * 
+     * @tparam Dim The vector space dimension of the periodic system
+     * @tparam TranslationBits The number of bits per entry of the translations, see BasicPackedTranslation
+     * @tparam Index The unsigned type of the vertex indices
+     */
+    template <size_t Dim, unsigned TranslationBits = 2, typename Index = uint32_t>
+    class BasicCompactPercolationGraph
+    {
+    public:
+        using packed_translation_type = BasicPackedTranslation<Dim, TranslationBits>;
+
+        /**
+         * @brief The narrowest coordinate type holding all packed entries, used for the analysis
+         */
+        using coordinate_type = typename std::conditional<TranslationBits <= 8, int8_t,
+                                                          typename std::conditional<TranslationBits <= 32, int32_t, int64_t>::type>::type;
+        using translation_type = BasicTranslationVector<Dim, coordinate_type>;
+        using analysis_graph_type = BasicCompactUnionFind<Dim, Index>;
+
+        /**
+         * @brief Reserve memory for the desired maximum number of vertices.
+         * 
+         * @param num_vertices The maximum number of indices (starting from index zero) to be added.
+         * @return true Memory allocation has been successful
+         * @return false The indices do not fit into Index
+         */
+        bool reserve_vertices(size_t num_vertices);
+
+        /**
+         * @brief Reserve memory for a number of edges, to avoid reallocations while adding them
+         * 
+         * @param num_edges 
+         */
+        void reserve_edges(size_t num_edges);
+
+        /**
+         * @brief Add an undirected edge including its translation vector
+         * 
+         * The translation vector is required to be pointing from the base to the head vertex, same as for PercolationGraph::add_edge().
+         * The inverse edge is implied and not stored.
+         * 
+         * @tparam Coord 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         * @return true The edge has successfully been added.
+         * @return false An index does not fit into Index or an entry of the translation does not fit into TranslationBits bits
+         */
+        template <typename Coord>
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const BasicTranslationVector<Dim, Coord> &edge_trans)
+        {
+            packed_translation_type packed;
+            if (!packed_translation_type::pack(edge_trans, packed))
+            {
+                return false;
+            }
+            size_t max_index = (vertex_index_base > vertex_index_head ? vertex_index_base : vertex_index_head);
+            if (!reserve_vertices(max_index + 1))
+            {
+                return false;
+            }
+            edge_base.push_back(Index(vertex_index_base));
+            edge_head.push_back(Index(vertex_index_head));
+            edge_translation.push_back(packed);
+            return true;
+        }
+
+        /**
+         * @brief Remove all vertices and edges while keeping the allocated memory
+         */
+        void reset();
+
+        size_t get_num_vertices() const;
+        size_t get_num_edges() const;
+
+        /**
+         * @brief Get the number of bytes taken by the stored edges
+         * 
+         * The analysis needs analysis_graph_type::get_vertex_memory() bytes per vertex on top, see get_component_percolation_info().
+         * 
+         * @return size_t 
+         */
+        size_t get_edge_memory() const;
+
+        /**
+         * @brief Get the base, head and translation of a stored edge
+         * 
+         * @param edge_index 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         */
+        void get_edge(size_t edge_index, size_t &vertex_index_base, size_t &vertex_index_head, translation_type &edge_trans) const;
+
+        /**
+         * @brief Get a list of all connected component of the graph and their respective percolation information.
+         * 
+         * Uses the same ordering as PercolationGraph::get_component_percolation_info(), i.e. components are numbered in the order
+         * of their smallest vertex index. The vertices of each component are listed in increasing index order.
+         * Allocates an analysis_graph_type of analysis_graph_type::get_vertex_memory() bytes per vertex.
+         * 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info() const;
+
+        /**
+         * @brief Same as get_component_percolation_info(), but reuses the union-find of @p analysis_graph
+         * 
+         * @param analysis_graph Is reset and filled with the edges of this graph
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info(analysis_graph_type &analysis_graph) const;
+
+    protected:
+        size_t num_vertices = 0;
+
+        std::vector<Index> edge_base;
+        std::vector<Index> edge_head;
+        std::vector<packed_translation_type> edge_translation;
+    };
+
+    using CompactPercolationGraph = BasicCompactPercolationGraph<vector_space_dimension>;
+
+    extern template class BasicCompactUnionFind<2, uint32_t>;
+    extern template class BasicCompactUnionFind<3, uint32_t>;
+    extern template class BasicCompactUnionFind<3, uint64_t>;
+
+    extern template class BasicCompactPercolationGraph<2, 2, uint32_t>;
+    extern template class BasicCompactPercolationGraph<3, 2, uint32_t>;
+    extern template class BasicCompactPercolationGraph<3, 4, uint32_t>;
+    extern template class BasicCompactPercolationGraph<3, 8, uint32_t>;
+    extern template class BasicCompactPercolationGraph<3, 2, uint64_t>;
+}
+
+#endif
\ No newline at end of file
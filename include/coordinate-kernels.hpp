@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __COORDINATE_KERNELS_H__
+#define __COORDINATE_KERNELS_H__
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "vec.hpp"
+
+namespace mol
+{
+    /**
+     * @brief Instruction set used by the batch kernels
+     */
+    enum class KernelLevel
+    {
+        scalar,
+        avx2,
+        avx512
+    };
+
+    /**
+     * @brief Get the best instruction set for the batch kernels that is supported by the compiler and the CPU
+     * 
+     * The CPU is only queried on the first call.
+     * 
+     * @return KernelLevel 
+     */
+    KernelLevel get_supported_kernel_level();
+
+    /**
+     * @brief Transform positions into normalized basis coefficients in structure-of-arrays layout
+     * 
+     * For every position, computes normalize_basis_coefficients(decompose(positions[i], triclinic_basis)) and stores
+     * its components in coeff_x[i], coeff_y[i] and coeff_z[i].
+     * The basis needs to be triclinic as required by MolecularGraph::set_basis().
+     * 
+     * @param positions The positions to transform
+     * @param num_positions 
+     * @param triclinic_basis 
+     * @param coeff_x Output of the first normalized coefficient (size num_positions)
+     * @param coeff_y Output of the second normalized coefficient (size num_positions)
+     * @param coeff_z Output of the third normalized coefficient (size num_positions)
+     * @param level The instruction set to use, needs to be supported by the CPU
+     */
+    void normalize_positions(const vec<double> *positions, size_t num_positions, const std::array<vec<double>, 3> &triclinic_basis,
+                             double *coeff_x, double *coeff_y, double *coeff_z, KernelLevel level = get_supported_kernel_level());
+
+    /**
+     * @brief Wrapper to directly provide the basis as stored by MolecularGraph, which needs to contain three vectors
+     */
+    void normalize_positions(const vec<double> *positions, size_t num_positions, const std::vector<vec<double>> &triclinic_basis,
+                             double *coeff_x, double *coeff_y, double *coeff_z, KernelLevel level = get_supported_kernel_level());
+
+    /**
+     * @brief Compute the pbc translation of bonds from the normalized coefficients of their atoms
+     * 
+     * For every dimension, the translation is -1 if the shortest connection from the base to the head crosses the cell boundary 
+     * downwards, +1 if it crosses it upwards and 0 otherwise, same as in MolecularGraph::get_percolation_graph().
+     * 
+     * @param coeff_x The first normalized coefficient of all atoms, as computed by normalize_positions()
+     * @param coeff_y The second normalized coefficient of all atoms
+     * @param coeff_z The third normalized coefficient of all atoms
+     * @param bond_base The base atom of every bond
+     * @param bond_head The head atom of every bond
+     * @param num_bonds 
+     * @param trans_x Output of the first translation component (size num_bonds)
+     * @param trans_y Output of the second translation component (size num_bonds)
+     * @param trans_z Output of the third translation component (size num_bonds)
+     * @param level The instruction set to use, needs to be supported by the CPU
+     */
+    void compute_bond_translations(const double *coeff_x, const double *coeff_y, const double *coeff_z, const size_t *bond_base, const size_t *bond_head,
+                                   size_t num_bonds, int8_t *trans_x, int8_t *trans_y, int8_t *trans_z, KernelLevel level = get_supported_kernel_level());
+}
+
+#endif
\ No newline at end of file
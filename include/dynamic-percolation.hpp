@@ -0,0 +1,359 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __DYNAMIC_PERCOLATION_H__
+#define __DYNAMIC_PERCOLATION_H__
+
+#include <vector>
+
+#include "percolation-detection.hpp"
+
+namespace percolation
+{
+    /**
+     * @brief Percolation analysis for graphs in which edges are both added and removed
+     * 
+     * Keeps a spanning forest with a translation of every vertex that agrees with the tree edges and, per component, 
+     * a basis of lattice vectors together with the non-tree edges whose cycles produced them (witnesses).
+     * Changes only touch the components they belong to:
+     * - Adding an edge within a component checks its cycle against the basis, adding an edge between two components 
+     *   attaches the smaller tree to the larger one.
+     * - Removing a non-tree edge that is not a witness changes nothing. Removing a witness rebuilds the basis of its 
+     *   component from all of its edges, which is deferred until the next query or addition, so a component that loses 
+     *   several witnesses is only rebuilt once.
+     * - Removing a tree edge searches the two halves of the tree in lockstep from both ends of the edge, the half of an 
+     *   edge's far end that has not been reached yet is found by walking up the tree. The search stops at the first edge 
+     *   between the halves with a zero cycle, which takes over in the tree without changing any position or cycle, or 
+     *   once the smaller half has been exhausted. In that case the smaller half is split off as a new component,
+     *   or shifted by the cycle of an edge that wraps around the periodic system to reconnect it. Only if the cycles of the 
+     *   reconnected component lose a dimension this way, or a split-off half took a witness with it, does the rest of the 
+     *   component need a rebuild of its basis.
+     * The results of all other components stay cached.
+     * 
+     * This is meant for reversible chemistries, where bonds are broken and formed in every frame and the graph of a frame 
+     * is the graph of the previous frame with a small set of changes (see apply_bond_delta()).
+     * 
+     * @tparam Dim The vector space dimension of the periodic system
+     * @tparam Coord The coordinate type of the edge translations
+     */
+    template <size_t Dim, typename Coord>
+    class BasicDynamicPercolationGraph
+    {
+    public:
+        using translation_type = BasicTranslationVector<Dim, Coord>;
+        using edge_data_type = BasicEdgeData<Dim, Coord>;
+        using edge_type = BasicEdge<Dim, Coord>;
+        using position_type = typename BasicPercolationGraph<Dim, Coord>::position_type;
+        using basis_type = typename BasicPercolationGraph<Dim, Coord>::basis_type;
+
+        /**
+         * @brief Reserve memory for the desired maximum number of vertices.
+         * 
+         * Each new vertex starts out as its own component.
+         * 
+         * @param num_vertices The maximum number of indices (starting from index zero) to be added.
+         * @return true Memory allocation has been successful
+         * @return false Memory allocation has failed
+         */
+        bool reserve_vertices(size_t num_vertices);
+
+        /**
+         * @brief Add vertex information to keep track of
+         * 
+         * @param vertex_index The index of the vertex to be annotated
+         * @param vertex_data The data to be associated with the vertex
+         * @return true The vertex data has been added successfully
+         * @return false Something went wrong adding the vertex metadata
+         */
+        bool add_vertex(size_t vertex_index, const VertexData &vertex_data);
+
+        /**
+         * @brief Add an edge and update the component and percolation information
+         * 
+         * The translation vector is required to be pointing from the base to the head vertex, same as for PercolationGraph::add_edge().
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_data 
+         * @return true The edge has successfully been added.
+         * @return false 
+         */
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data);
+
+        /**
+         * @brief Wrapper to directly provide the TranslationVector instead of an EdgeData object
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         * @return true 
+         * @return false 
+         */
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Remove an edge that has previously been added
+         * 
+         * The edge may be given in either direction, i.e. (base, head, t) and (head, base, -t) refer to the same edge.
+         * If the edge has been added multiple times, only one copy is removed.
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_data 
+         * @return true The edge has been removed
+         * @return false The edge is not part of the graph
+         */
+        bool remove_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data);
+
+        /**
+         * @brief Wrapper to directly provide the TranslationVector instead of an EdgeData object
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         * @return true 
+         * @return false 
+         */
+        bool remove_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Apply the changes between two frames
+         * 
+         * All removals are applied first and the invalidated components are updated once, before the additions are applied.
+         * 
+         * @param added The edges formed since the previous frame
+         * @param removed The edges broken since the previous frame
+         * @return true All changes have been applied
+         * @return false Some of the removed edges were not part of the graph, all other changes have been applied
+         */
+        bool apply_bond_delta(const std::vector<edge_type> &added, const std::vector<edge_type> &removed);
+
+        /**
+         * @brief Get the percolation dimension of the component that the vertex belongs to
+         * 
+         * @param vertex_index 
+         * @return size_t The percolation dimension (0 if the vertex is not known)
+         */
+        size_t get_percolation_dim(size_t vertex_index);
+
+        /**
+         * @brief Get the current number of connected components
+         * 
+         * @return size_t 
+         */
+        size_t get_num_components();
+
+        /**
+         * @brief Get a list of all connected components and their respective percolation information.
+         * 
+         * Uses the same ordering as PercolationGraph::get_component_percolation_info(), i.e. components are numbered in the order
+         * of their smallest vertex index. The vertices of each component are listed in increasing index order.
+         * 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info();
+
+    protected:
+        struct AdjacencyEntry
+        {
+            size_t head;
+            edge_data_type data;
+        };
+
+        struct Component
+        {
+            std::vector<size_t> vertices;
+
+            /**
+             * @brief Index into lattices, no_lattice if the component has no non-zero cycle
+             */
+            size_t lattice_index;
+
+            /**
+             * @brief A witness has been removed, the lattice needs to be recomputed
+             */
+            bool needs_lattice = false;
+        };
+
+        struct Lattice
+        {
+            basis_type basis;
+
+            /**
+             * @brief witnesses[i] is the non-tree edge whose cycle produced basis[i]
+             */
+            edge_type witnesses[Dim];
+        };
+
+        /**
+         * @brief Member to keep track of vertex information 
+         */
+        std::vector<VertexData> vertices;
+
+        /**
+         * @brief The edges of every vertex, each edge is stored in both directions and self-loops once
+         */
+        std::vector<std::vector<AdjacencyEntry>> adjacency;
+
+        std::vector<size_t> component_of;
+
+        /**
+         * @brief The parent of every vertex in the spanning forest, roots are their own parent
+         */
+        std::vector<size_t> tree_parent;
+
+        /**
+         * @brief The translation of the tree edge from the parent to the vertex
+         */
+        std::vector<translation_type> tree_translation;
+
+        /**
+         * @brief The translation of every vertex, consistent with the tree edges, i.e. the cycle of every tree edge is zero
+         */
+        std::vector<position_type> positions;
+
+        /**
+         * @brief The index of every vertex in the vertex list of its component
+         */
+        std::vector<size_t> component_slot;
+
+        std::vector<Component> components;
+        std::vector<size_t> free_components;
+        std::vector<Lattice> lattices;
+        std::vector<size_t> free_lattices;
+        size_t num_components = 0;
+
+        /**
+         * @brief Components whose lattice has been invalidated by removals
+         */
+        std::vector<size_t> dirty_components;
+
+        /**
+         * @brief Buffers of the search after removing a tree edge, one queue per half of the tree
+         */
+        std::vector<size_t> visit_stamp;
+        size_t curr_stamp = 0;
+        std::vector<size_t> search_queues[2];
+
+        size_t allocate_component();
+        void release_lattice(Component &component);
+        size_t get_lattice_dim(size_t component_index) const;
+
+        /**
+         * @brief Mark the lattice of a component to be rebuilt by the next update_components()
+         * 
+         * @param component_index 
+         */
+        void invalidate_lattice(size_t component_index);
+
+        /**
+         * @brief Check whether an edge of the vertex is the edge to its parent or one of its children in the spanning forest
+         * 
+         * @param vertex_index 
+         * @param entry 
+         * @return true 
+         * @return false 
+         */
+        bool is_tree_edge(size_t vertex_index, const AdjacencyEntry &entry) const;
+
+        /**
+         * @brief Add the cycle of a non-tree edge to the lattice of a component if it is linearly independent of it
+         * 
+         * @param component_index 
+         * @param witness The non-tree edge
+         */
+        void add_cycle(size_t component_index, const edge_type &witness);
+
+        /**
+         * @brief Attach the tree of the head vertex to the tree of the base vertex via a new edge, rerooting it at the head vertex
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         */
+        void attach_tree(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Cut a tree edge and either reconnect the two halves of the tree by a non-tree edge or split the component
+         * 
+         * @param vertex_index_parent 
+         * @param vertex_index_child 
+         */
+        void remove_tree_edge(size_t vertex_index_parent, size_t vertex_index_child);
+
+        /**
+         * @brief Find out which half of a cut tree a vertex belongs to by walking up to the first vertex marked by the search
+         * 
+         * @param vertex_index 
+         * @param side_stamp The visit stamps of the detached subtree and of the rest of the tree
+         * @return size_t 0 for the detached subtree, 1 for the rest of the tree
+         */
+        size_t find_tree_side(size_t vertex_index, const size_t (&side_stamp)[2]) const;
+
+        /**
+         * @brief Make a non-tree edge between the two halves of a cut tree a tree edge
+         * 
+         * @param vertex_index 
+         * @param entry The edge from the vertex to the other half
+         * @param vertex_detached Whether the vertex is part of the subtree that has been cut off
+         */
+        void reconnect_tree(size_t vertex_index, const AdjacencyEntry &entry, bool vertex_detached);
+
+        /**
+         * @brief Move a part without edges to the rest of its component into a new component
+         * 
+         * @param component_index 
+         * @param piece The vertices of the part
+         * @param piece_stamp The visit stamp of the vertices of the part
+         */
+        void split_component(size_t component_index, const std::vector<size_t> &piece, size_t piece_stamp);
+
+        /**
+         * @brief Recompute the lattice of a component from the cycles of its non-tree edges
+         * 
+         * @param component_index 
+         */
+        void rebuild_lattice(size_t component_index);
+
+        /**
+         * @brief Process all invalidated components
+         */
+        void update_components();
+    };
+
+    using DynamicPercolationGraph = BasicDynamicPercolationGraph<vector_space_dimension, translation_coordinate_type>;
+
+    extern template class BasicDynamicPercolationGraph<2, int8_t>;
+    extern template class BasicDynamicPercolationGraph<2, int32_t>;
+    extern template class BasicDynamicPercolationGraph<2, int64_t>;
+    extern template class BasicDynamicPercolationGraph<3, int8_t>;
+    extern template class BasicDynamicPercolationGraph<3, int32_t>;
+    extern template class BasicDynamicPercolationGraph<3, int64_t>;
+}
+
+#endif
\ No newline at end of file
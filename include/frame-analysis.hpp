@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __FRAME_ANALYSIS_H__
+#define __FRAME_ANALYSIS_H__
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "molecular-graph.hpp"
+
+namespace mol
+{
+    /**
+     * @brief Callback to fill the molecular graph of a frame
+     * 
+     * The graph passed in is reused between frames: its atom count, basis and positions are those of a previously 
+     * provided frame (if any), its bonds have been removed via MolecularGraph::clear_bonds().
+     * The provider is called concurrently from multiple threads for different frames and needs to be thread-safe.
+     */
+    using FrameProvider = std::function<void(size_t frame_index, MolecularGraph &frame)>;
+
+    struct FrameAnalysisOptions
+    {
+        /**
+         * @brief Number of frames analyzed concurrently, 0 for one frame per hardware thread
+         */
+        size_t num_threads = 0;
+    };
+
+    struct FrameResult
+    {
+        size_t frame_index;
+
+        /**
+         * @brief The maximum percolation dimension of all components of the frame
+         */
+        size_t max_percolation_dim;
+
+        /**
+         * @brief The result of percolation::PercolationGraph::get_component_percolation_info() for the frame
+         */
+        std::vector<percolation::ComponentInfo> components;
+    };
+
+    /**
+     * @brief Analyze the percolation of many frames concurrently
+     * 
+     * Every thread keeps its own molecular graph, percolation graph and analysis buffers and reuses them for all 
+     * frames it processes, so after the first frames barely any memory is allocated except for the results.
+     * Each frame is analyzed on a single thread, the parallelism is across frames.
+     * 
+     * @param num_frames The number of frames, which are identified by the indices 0 to num_frames-1
+     * @param provider Callback to fill in the data of a frame
+     * @param options 
+     * @return std::vector<FrameResult> The results for all frames in frame order
+     */
+    std::vector<FrameResult> analyze_frames(size_t num_frames, const FrameProvider &provider, const FrameAnalysisOptions &options = FrameAnalysisOptions());
+
+    /**
+     * @brief Analyze the percolation of frames that are already held in memory concurrently
+     * 
+     * @param frames 
+     * @param options 
+     * @return std::vector<FrameResult> The results for all frames in frame order
+     */
+    std::vector<FrameResult> analyze_frames(const std::vector<MolecularGraph> &frames, const FrameAnalysisOptions &options = FrameAnalysisOptions());
+
+    /**
+     * @brief Callback to read the next frame of a stream
+     * 
+     * The graph passed in is reused between frames like for FrameProvider. It is only ever called from one thread at a time.
+     * 
+     * @return true The frame has been read
+     * @return false The stream has ended
+     */
+    using FrameSource = std::function<bool(MolecularGraph &frame, int64_t &timestep)>;
+
+    /**
+     * @brief Callback to receive the result of a frame, called in frame order from the thread that runs the pipeline
+     */
+    using FrameSink = std::function<void(const FrameResult &result, const MolecularGraph &frame, int64_t timestep)>;
+
+    struct PipelineOptions
+    {
+        /**
+         * @brief Number of threads converting frames into percolation graphs, 0 for one per hardware thread
+         */
+        size_t num_build_threads = 1;
+
+        /**
+         * @brief Number of threads analyzing percolation graphs, 0 for one per hardware thread
+         */
+        size_t num_analysis_threads = 1;
+
+        /**
+         * @brief Maximum number of frames waiting between two stages
+         */
+        size_t queue_capacity = 4;
+
+        /**
+         * @brief Optional preparation of every frame by the build threads before its conversion, 
+         * e.g. to add the bonds within a cutoff
+         */
+        std::function<void(MolecularGraph &frame)> prepare_frame;
+    };
+
+    /**
+     * @brief Stream frames through a pipeline in which reading, conversion, analysis and output overlap
+     * 
+     * A reader thread calls the source and hands the frames to the build threads, which convert them into percolation graphs 
+     * via MolecularGraph::fill_percolation_graph(). The analysis threads run percolation::PercolationGraph::get_component_percolation_info()
+     * and the calling thread passes the results to the sink in frame order.
+     * The stages are connected by queues of limited capacity and frame buffers are recycled, so at most 
+     * num_build_threads + num_analysis_threads + 2 * queue_capacity + 1 frames are held in memory, however long the stream is.
+     * The first exception thrown by the source, the sink or a stage stops the pipeline and is rethrown after all threads have finished.
+     * 
+     * @param source Callback to read the frames, which are numbered in the order they are read
+     * @param sink Callback to receive the results
+     * @param options 
+     * @return size_t The number of frames passed to the sink
+     */
+    size_t run_frame_pipeline(const FrameSource &source, const FrameSink &sink, const PipelineOptions &options = PipelineOptions());
+
+    /**
+     * @brief Marker for a percolation dimension that is not reached in any frame
+     */
+    const size_t no_gel_point = std::numeric_limits<size_t>::max();
+
+    struct GelPointOptions
+    {
+        /**
+         * @brief If larger than 1, first analyze every coarse_stride-th frame (and the last frame) and only bisect 
+         * within the stride in which a dimension is first reached.
+         * 
+         * This is meant for trajectories that are only nearly monotone, e.g. due to bonds that break and reform 
+         * within a few frames. Fluctuations within a stride are resolved locally instead of misguiding the global search.
+         */
+        size_t coarse_stride = 0;
+
+        /**
+         * @brief Number of threads used to analyze the coarse frames, 0 for one per hardware thread
+         */
+        size_t num_threads = 0;
+    };
+
+    struct GelPointResult
+    {
+        /**
+         * @brief onset_frames[d-1] is the first frame in which a component percolates in at least d dimensions or 
+         * no_gel_point if that never happens
+         */
+        std::vector<size_t> onset_frames;
+
+        /**
+         * @brief The number of frames that were actually analyzed
+         */
+        size_t num_analyzed_frames;
+    };
+
+    /**
+     * @brief Find the first frames at which the maximum percolation dimension reaches 1, 2, ... by bisection
+     * 
+     * Assumes that the maximum percolation dimension does not decrease over the trajectory, which holds if bonds 
+     * only ever form, e.g. while curing. Then only O(log(num_frames)) frames are analyzed per dimension. 
+     * No frame is analyzed twice.
+     * 
+     * @param num_frames The number of frames, which are identified by the indices 0 to num_frames-1
+     * @param provider Callback to fill in the data of a frame, must be thread-safe if a coarse stride is used
+     * @param options 
+     * @return GelPointResult 
+     */
+    GelPointResult find_gel_points(size_t num_frames, const FrameProvider &provider, const GelPointOptions &options = GelPointOptions());
+}
+
+#endif
\ No newline at end of file
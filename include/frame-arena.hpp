@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __PERCOLATION_FRAME_ARENA_H__
+#define __PERCOLATION_FRAME_ARENA_H__
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace percolation
+{
+    /**
+     * @brief Memory resource for all data of one frame, released at once by reset()
+     * 
+     * Allocations are served from a single buffer by advancing an offset, deallocation does nothing.
+     * If a frame needs more memory than the buffer holds, the rest is taken from the upstream resource and the buffer is 
+     * enlarged to the total amount used (plus a margin of a quarter) by the next reset(). After a warm-up frame, frames of
+     * similar size are therefore served without any call to the upstream resource, i.e. without malloc.
+     * 
+     * Typical use is a percolation::PercolationGraph constructed with the arena for every frame. All objects using the arena 
+     * must be destroyed before it is reset.
+     */
+    class FrameArena : public std::pmr::memory_resource
+    {
+    public:
+        /**
+         * @brief Create an arena
+         * 
+         * @param initial_capacity Size of the buffer in bytes, allocated right away
+         * @param upstream The resource for the buffer and for the memory exceeding it, must outlive the arena
+         */
+        explicit FrameArena(size_t initial_capacity = 0, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+        ~FrameArena();
+
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        /**
+         * @brief Release all memory handed out since the last reset, growing the buffer if it has been too small
+         */
+        void reset();
+
+        /**
+         * @brief Get the size of the buffer in bytes
+         * 
+         * @return size_t 
+         */
+        size_t get_capacity() const;
+
+        /**
+         * @brief Get the number of bytes handed out since the last reset, including the memory taken from upstream
+         * 
+         * @return size_t 
+         */
+        size_t get_used() const;
+
+        /**
+         * @brief Get the number of allocations from the upstream resource over the lifetime of the arena
+         * 
+         * Stays constant once the buffer is large enough for every frame.
+         * 
+         * @return size_t 
+         */
+        size_t get_num_upstream_allocations() const;
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    private:
+        /**
+         * @brief Header in front of every block taken from upstream, linking all blocks of the current frame
+         */
+        struct OverflowBlock
+        {
+            OverflowBlock *next;
+            size_t size;
+            size_t alignment;
+        };
+
+        void release_overflow();
+
+        std::pmr::memory_resource *upstream;
+
+        char *buffer = nullptr;
+        size_t capacity = 0;
+        size_t offset = 0;
+
+        OverflowBlock *overflow = nullptr;
+        size_t overflow_bytes = 0;
+        size_t num_upstream_allocations = 0;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __FRAME_FILE_H__
+#define __FRAME_FILE_H__
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "molecular-graph.hpp"
+
+/*
+ * Binary frame file format (version 1)
+ * 
+ * All numbers are little-endian, all offsets are in bytes from the start of the file and every section starts at a multiple of 8 bytes.
+ * 
+ * File header (32 bytes):
+ *      char[8]     magic "PERCFRM1"
+ *      uint64      version (1)
+ *      uint64      number of frames F
+ *      uint64      offset of the index table
+ * 
+ * Frames, each consisting of
+ *      uint64      number of atoms N
+ *      uint64      number of bonds B
+ *      uint64      flags (bit 0: the frame contains precomputed bond translations)
+ *      double[9]   triclinic basis, basis vector i at entries 3*i to 3*i+2
+ *      double[3*N] atom positions, x, y and z of atom i at entries 3*i to 3*i+2
+ *      uint64[B]   base atom of every bond
+ *      uint64[B]   head atom of every bond
+ *      int8[3*B]   only if flag bit 0 is set: x translations of all bonds, then the y and then the z translations,
+ *                  zero padded to a multiple of 8 bytes
+ * 
+ * Index table:
+ *      uint64[F]   offset of every frame
+ */
+
+namespace mol
+{
+    /**
+     * @brief Writer for the binary frame file format described above
+     */
+    class FrameFileWriter
+    {
+    public:
+        ~FrameFileWriter();
+
+        /**
+         * @brief Create a new frame file, replacing an existing one
+         * 
+         * @param path 
+         * @return true The file has been created
+         * @return false The file could not be created or the system is not little-endian
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Append a frame to the file
+         * 
+         * @param frame 
+         * @param with_translations Also store the pbc translations of the bonds, so readers can skip the coordinate transformation
+         * @return true 
+         * @return false The file is not open or could not be written
+         */
+        bool write_frame(const MolecularGraph &frame, bool with_translations = false);
+
+        /**
+         * @brief Write the index table and close the file. Also called by the destructor.
+         * 
+         * @return true 
+         * @return false The file is not open or could not be written
+         */
+        bool close();
+
+    protected:
+        std::ofstream out;
+        uint64_t curr_offset = 0;
+        std::vector<uint64_t> frame_offsets;
+        ConversionWorkspace workspace;
+
+        bool write_bytes(const void *bytes, size_t num_bytes);
+    };
+
+    /**
+     * @brief A frame of a memory-mapped frame file
+     * 
+     * All pointers point into the mapped file and are valid until the file is closed.
+     */
+    struct FrameView
+    {
+        size_t num_atoms;
+        size_t num_bonds;
+        std::array<vec<graph_precision_type>, 3> basis;
+        const vec<graph_precision_type> *positions;
+        const size_t *bond_base;
+        const size_t *bond_head;
+
+        // Only set if the frame contains precomputed translations, nullptr otherwise
+        const int8_t *trans_x;
+        const int8_t *trans_y;
+        const int8_t *trans_z;
+    };
+
+    /**
+     * @brief Reader for the binary frame file format described above
+     * 
+     * The file is mapped into memory instead of being read, so opening it is cheap independent of its size and any frame can be 
+     * accessed directly via the index table. Only the pages of the frames that are actually used are loaded from disk.
+     * All const methods can be called concurrently, e.g. from a FrameProvider passed to analyze_frames().
+     */
+    class FrameFileReader
+    {
+    public:
+        FrameFileReader() = default;
+        FrameFileReader(const FrameFileReader &) = delete;
+        FrameFileReader &operator=(const FrameFileReader &) = delete;
+        ~FrameFileReader();
+
+        /**
+         * @brief Map a frame file into memory
+         * 
+         * @param path 
+         * @return true The file has been opened and its header and index table are valid
+         * @return false The file could not be mapped, is not a valid frame file or the system is not little-endian
+         */
+        bool open(const std::string &path);
+
+        void close();
+
+        size_t get_num_frames() const;
+
+        /**
+         * @brief Get direct access to the arrays of a frame in the mapped file
+         * 
+         * @param frame_index 
+         * @param view Output of the frame data
+         * @return true 
+         * @return false The frame does not exist or exceeds the file
+         */
+        bool get_frame(size_t frame_index, FrameView &view) const;
+
+        /**
+         * @brief Fill a molecular graph with a frame, replacing its atoms and bonds
+         * 
+         * @param frame_index 
+         * @param frame 
+         * @return true 
+         * @return false The frame does not exist, exceeds the file or its basis is not triclinic
+         */
+        bool read_frame(size_t frame_index, MolecularGraph &frame) const;
+
+        /**
+         * @brief Build the percolation graph of a frame directly from the mapped arrays, without a MolecularGraph in between
+         * 
+         * Precomputed translations are used if present, otherwise they are computed from the positions like in 
+         * MolecularGraph::fill_percolation_graph(). The adjacency structure is sorted straight out of the bond arrays.
+         * 
+         * @param frame_index 
+         * @param res The graph to be filled, its previous contents are replaced
+         * @param workspace Buffers for the conversion
+         * @return true 
+         * @return false The frame does not exist or exceeds the file
+         */
+        bool fill_percolation_graph(size_t frame_index, percolation::PercolationGraph &res, ConversionWorkspace &workspace) const;
+
+    protected:
+        const unsigned char *data = nullptr;
+        size_t size = 0;
+        size_t num_frames = 0;
+        const uint64_t *frame_offsets = nullptr;
+
+#ifdef _WIN32
+        void *file_handle = nullptr;
+        void *mapping_handle = nullptr;
+#endif
+    };
+}
+
+#endif
\ No newline at end of file
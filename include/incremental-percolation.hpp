@@ -0,0 +1,216 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __INCREMENTAL_PERCOLATION_H__
+#define __INCREMENTAL_PERCOLATION_H__
+
+#include <vector>
+
+#include "percolation-detection.hpp"
+
+namespace percolation
+{
+    /**
+     * @brief Percolation analysis for graphs that only ever grow by adding edges
+     * 
+     * Keeps a union-find structure in which every vertex stores its translation relative to its parent (weighted union-find).
+     * Whenever an added edge closes a cycle within a component, the net translation of that cycle is a lattice vector of the component
+     * and is recorded if it is linearly independent of the vectors found so far.
+     * Adding an edge therefore costs near constant amortized time and the percolation dimension of every component can be queried
+     * at any time without rerunning the full analysis of PercolationGraph.
+     * 
+     * This is meant for trajectories in which bonds are only formed (e.g. curing simulations), where the graph of a frame is the graph
+     * of the previous frame plus the newly formed bonds.
+     * 
+     * @tparam Dim The vector space dimension of the periodic system
+     * @tparam Coord The coordinate type of the edge translations
+     */
+    template <size_t Dim, typename Coord>
+    class BasicIncrementalPercolationGraph
+    {
+    public:
+        using translation_type = BasicTranslationVector<Dim, Coord>;
+        using edge_data_type = BasicEdgeData<Dim, Coord>;
+        using position_type = typename BasicPercolationGraph<Dim, Coord>::position_type;
+        using basis_type = typename BasicPercolationGraph<Dim, Coord>::basis_type;
+
+        /**
+         * @brief Reserve memory for the desired maximum number of vertices.
+         * 
+         * Each new vertex starts out as its own component.
+         * 
+         * @param num_vertices The maximum number of indices (starting from index zero) to be added.
+         * @return true Memory allocation has been successful
+         * @return false Memory allocation has failed
+         */
+        bool reserve_vertices(size_t num_vertices);
+
+        /**
+         * @brief Add vertex information to keep track of
+         * 
+         * @param vertex_index The index of the vertex to be annotated
+         * @param vertex_data The data to be associated with the vertex
+         * @return true The vertex data has been added successfully
+         * @return false Something went wrong adding the vertex metadata
+         */
+        bool add_vertex(size_t vertex_index, const VertexData &vertex_data);
+
+        /**
+         * @brief Add an edge and update the component and percolation information
+         * 
+         * The translation vector is required to be pointing from the base to the head vertex, same as for PercolationGraph::add_edge().
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_data 
+         * @return true The edge has successfully been added.
+         * @return false 
+         */
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data);
+
+        /**
+         * @brief Wrapper to directly provide the TranslationVector instead of an EdgeData object
+         * 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         * @return true 
+         * @return false 
+         */
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Remove all vertices and edges while keeping the allocated memory
+         */
+        void reset();
+
+        /**
+         * @brief Get the representative vertex of the component the vertex belongs to
+         * 
+         * Two vertices are in the same component if and only if they have the same representative.
+         * The representative may change whenever edges are added.
+         * 
+         * @param vertex_index 
+         * @return size_t The index of the representative vertex
+         */
+        size_t get_component_representative(size_t vertex_index);
+
+        /**
+         * @brief Get the percolation dimension of the component that the vertex belongs to
+         * 
+         * @param vertex_index 
+         * @return size_t The percolation dimension (0 if the vertex is not known)
+         */
+        size_t get_percolation_dim(size_t vertex_index);
+
+        /**
+         * @brief Get the current number of connected components
+         * 
+         * @return size_t 
+         */
+        size_t get_num_components() const;
+
+        /**
+         * @brief Get a list of all connected components and their respective percolation information.
+         * 
+         * Uses the same ordering as PercolationGraph::get_component_percolation_info(), i.e. components are numbered in the order
+         * of their smallest vertex index. The vertices of each component are listed in increasing index order.
+         * 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info();
+
+    protected:
+        /**
+         * @brief Member to keep track of vertex information 
+         */
+        std::vector<VertexData> vertices;
+
+        /**
+         * @brief The parent of each vertex in the union-find forest. Roots are their own parent.
+         */
+        std::vector<size_t> parent;
+
+        /**
+         * @brief The translation of each vertex relative to its parent
+         */
+        std::vector<position_type> parent_offset;
+
+        /**
+         * @brief The number of vertices in the component, only valid for roots
+         */
+        std::vector<size_t> component_size;
+
+        /**
+         * @brief Index into lattice_bases of the lattice vectors of a component, only valid for roots
+         * 
+         * Components without any non-zero cycle translation do not occupy an entry.
+         */
+        std::vector<size_t> basis_index;
+
+        /**
+         * @brief Linearly independent lattice vectors of the components that have at least one
+         */
+        std::vector<basis_type> lattice_bases;
+
+        /**
+         * @brief Entries in lattice_bases that have been released by merging two components
+         */
+        std::vector<size_t> free_bases;
+
+        size_t num_components = 0;
+
+        /**
+         * @brief Find the root of a vertex and compress the path to it
+         * 
+         * @param vertex_index 
+         * @param position Output of the translation of the vertex relative to the root
+         * @return size_t The root of the vertex
+         */
+        size_t find_root(size_t vertex_index, position_type &position);
+
+        /**
+         * @brief Add a lattice vector to the basis of a component root if it is linearly independent of it
+         * 
+         * @param root 
+         * @param lattice_vector 
+         */
+        void add_lattice_vector(size_t root, const position_type &lattice_vector);
+    };
+
+    using IncrementalPercolationGraph = BasicIncrementalPercolationGraph<vector_space_dimension, translation_coordinate_type>;
+
+    extern template class BasicIncrementalPercolationGraph<2, int8_t>;
+    extern template class BasicIncrementalPercolationGraph<2, int32_t>;
+    extern template class BasicIncrementalPercolationGraph<2, int64_t>;
+    extern template class BasicIncrementalPercolationGraph<3, int8_t>;
+    extern template class BasicIncrementalPercolationGraph<3, int32_t>;
+    extern template class BasicIncrementalPercolationGraph<3, int64_t>;
+}
+
+#endif
\ No newline at end of file
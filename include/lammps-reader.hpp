@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __LAMMPS_READER_H__
+#define __LAMMPS_READER_H__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "molecular-graph.hpp"
+
+namespace mol
+{
+    /**
+     * @brief Per-atom information of a LAMMPS file that is not stored in the MolecularGraph
+     * 
+     * Atoms are indexed in the MolecularGraph in the order of their LAMMPS ids, i.e. the atom with the smallest id has index 0.
+     */
+    struct LammpsAtomInfo
+    {
+        /**
+         * @brief The timestep of a dump frame, 0 for data files
+         */
+        int64_t timestep = 0;
+
+        std::vector<int64_t> ids;
+        std::vector<int64_t> types;
+    };
+
+    /**
+     * @brief Buffered reading of a text file, which provides blocks of complete lines without copying them
+     */
+    class TextLineReader
+    {
+    public:
+        bool open(const std::string &path);
+
+        /**
+         * @brief Get the next line without its line break
+         * 
+         * @param line_begin 
+         * @param line_end 
+         * @return true 
+         * @return false The end of the file has been reached
+         */
+        bool next_line(const char *&line_begin, const char *&line_end);
+
+        /**
+         * @brief Get the next lines as one block of text, which stays valid until the next call
+         * 
+         * @param num_lines 
+         * @param block_begin 
+         * @param block_end 
+         * @return true 
+         * @return false The file ends before the requested number of lines
+         */
+        bool next_lines(size_t num_lines, const char *&block_begin, const char *&block_end);
+
+    protected:
+        std::ifstream in;
+        std::vector<char> buffer;
+        size_t begin = 0;
+        size_t end = 0;
+        bool at_eof = true;
+
+        /**
+         * @brief Read more of the file into the buffer, moving the unread data to its front
+         * 
+         * @return true 
+         * @return false Nothing more could be read
+         */
+        bool fill();
+    };
+
+    /**
+     * @brief Read the atoms and bonds of a LAMMPS data file
+     * 
+     * Reads the box from the header and the Atoms and Bonds sections, all other sections are skipped.
+     * The atom style is taken from the comment of the Atoms section ("Atoms # full") and supports the styles atomic, charge, 
+     * bond, angle, molecular and full. Without the comment, it is derived from the number of columns. Image flags are applied if present.
+     * The sections are parsed in parallel on the number of threads set via MolecularGraph::set_num_threads().
+     * 
+     * @param path 
+     * @param graph The graph to fill, its previous atoms and bonds are replaced
+     * @param atom_info Optional output of the ids and types of the atoms
+     * @param error_message Optional output of the reason if reading fails
+     * @return true 
+     * @return false The file could not be read or is not a valid data file
+     */
+    bool read_lammps_data(const std::string &path, MolecularGraph &graph, LammpsAtomInfo *atom_info = nullptr, std::string *error_message = nullptr);
+
+    /**
+     * @brief Frame by frame reader of LAMMPS custom dump files and, optionally, local dumps of the bonds
+     * 
+     * The atom dump needs the columns id and the positions as x y z, xu yu zu, xs ys zs or xsu ysu zsu. The columns type and 
+     * ix iy iz are used if present.
+     * The bond dump is a local dump (e.g. of compute property/local batom1 batom2) with the same timesteps as the atom dump, 
+     * in which the first two columns not named index hold the ids of the bonded atoms.
+     * The atom lines of every frame are parsed in parallel on the number of threads set via MolecularGraph::set_num_threads()
+     * while only one frame is kept in memory at a time.
+     */
+    class LammpsDumpReader
+    {
+    public:
+        /**
+         * @brief Open a dump file and optionally a matching bond dump
+         * 
+         * @param path 
+         * @param bond_dump_path Empty if bonds are not read
+         * @return true 
+         * @return false A file could not be opened
+         */
+        bool open(const std::string &path, const std::string &bond_dump_path = "");
+
+        /**
+         * @brief Read the next frame
+         * 
+         * @param frame The graph to fill, its previous atoms and bonds are replaced
+         * @param atom_info Optional output of the timestep and the ids and types of the atoms
+         * @return true 
+         * @return false The end of the dump has been reached or the frame is invalid, see get_error()
+         */
+        bool read_next_frame(MolecularGraph &frame, LammpsAtomInfo *atom_info = nullptr);
+
+        /**
+         * @brief Get the reason why read_next_frame() failed, empty if the end of the dump has been reached
+         * 
+         * @return const std::string& 
+         */
+        const std::string &get_error() const;
+
+    protected:
+        TextLineReader atom_reader;
+        TextLineReader bond_reader;
+        bool read_bonds = false;
+        std::string error;
+
+        // Buffers reused for all frames
+        LammpsAtomInfo frame_info;
+        std::vector<vec<graph_precision_type>> positions;
+        std::vector<size_t> atom_order;
+        std::vector<size_t> id_lookup;
+        std::vector<int64_t> bond_ids;
+    };
+}
+
+#endif
\ No newline at end of file
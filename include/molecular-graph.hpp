@@ -29,15 +29,54 @@
 #ifndef __MOLECULAR_GRAPH_H__
 #define __MOLECULAR_GRAPH_H__
 
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
 #include <vector>
 
 #include "vec.hpp"
 #include "percolation-detection.hpp"
+#include "compact-percolation.hpp"
 
 namespace mol
 {
     using graph_precision_type = double;
 
+    /**
+     * @brief Buffers used to convert a MolecularGraph into a PercolationGraph
+     * 
+     * Passing the same workspace to repeated conversions (e.g. of consecutive frames) reuses its memory.
+     * A workspace created for a single conversion can instead take its buffers from a percolation::FrameArena.
+     */
+    struct ConversionWorkspace
+    {
+        ConversionWorkspace() = default;
+
+        /**
+         * @brief Create a workspace whose buffers are allocated from @p resource
+         * 
+         * @param resource 
+         */
+        explicit ConversionWorkspace(std::pmr::memory_resource *resource);
+
+        // Normalized basis coefficients of the atoms in structure-of-arrays layout
+        std::pmr::vector<graph_precision_type> coeff_x, coeff_y, coeff_z;
+
+        // Offset of the first bond of every block of atoms in the bond arrays
+        std::pmr::vector<size_t> block_offsets;
+
+        // One entry per bond
+        std::pmr::vector<size_t> bond_base, bond_head;
+        std::pmr::vector<int8_t> trans_x, trans_y, trans_z;
+    };
+
+    /**
+     * @brief Callback deciding whether two atoms within the cutoff distance should be bonded, e.g. based on their types
+     * 
+     * Called concurrently from multiple threads and needs to be thread-safe.
+     */
+    using BondFilter = std::function<bool(size_t atom_index_1, size_t atom_index_2)>;
+
     class MolecularGraph
     {
     public:
@@ -45,19 +84,120 @@ namespace mol
         MolecularGraph(size_t num_atoms);
 
         void set_atom_count(size_t num_atoms);
+        size_t get_atom_count() const;
         bool set_basis(const std::vector<vec<graph_precision_type>> &triclinic_basis);
 
         bool set_atom_position(size_t atom_index, const vec<graph_precision_type> &pos);
         bool add_bond(size_t atom_index_1, size_t atom_index_2);
 
-        percolation::PercolationGraph get_percolation_graph() const;
+        /**
+         * @brief Add a bond between every pair of atoms closer than the cutoff distance (respecting the pbc)
+         * 
+         * Uses a cell list in basis coordinates, so the cost grows linearly with the number of atoms instead of quadratically.
+         * The cells are searched in parallel (see set_num_threads()), the bonds are added in the same order for any number of threads.
+         * The basis and all atom positions need to be set beforehand. The cutoff needs to be less than half the width of the 
+         * pbc cell in every direction, so that every pair of atoms is bonded at most once.
+         * 
+         * @param cutoff The maximum distance of bonded atoms
+         * @param filter Optional callback to select which of the pairs within the cutoff should be bonded
+         * @return true The bonds have been added
+         * @return false No basis has been set or the cutoff is not within (0, half the cell width)
+         */
+        bool add_bonds_within_cutoff(graph_precision_type cutoff, const BondFilter &filter = BondFilter());
+
+        /**
+         * @brief Set the number of threads used by the bulk operations of the molecular graph
+         * 
+         * These are add_bonds_within_cutoff() and the conversion into a PercolationGraph. The results do not depend on the number of threads.
+         * 
+         * @param num_threads The number of threads to use, 0 for one thread per hardware thread. Default is 1 (serial).
+         */
+        void set_num_threads(size_t num_threads);
+
+        /**
+         * @brief Get the number of threads set by set_num_threads()
+         * 
+         * @return size_t 
+         */
+        size_t get_num_threads() const;
+
+        /**
+         * @brief Register an object to which the timings of the conversion into a PercolationGraph are added
+         * 
+         * Only has an effect if the library is built with statistics (see percolation::statistics_enabled()).
+         * The statistics are not passed on to the PercolationGraph, use percolation::PercolationGraph::set_statistics() for its analysis.
+         * 
+         * @param statistics The statistics object, which must outlive the conversions, or nullptr to stop collecting statistics
+         */
+        void set_statistics(percolation::AnalysisStatistics *statistics);
+
+        /**
+         * @brief Remove all bonds while keeping the allocated memory, e.g. to reuse the object for the next frame
+         */
+        void clear_bonds();
+
+        const std::vector<vec<graph_precision_type>> &get_basis() const;
+        const std::vector<vec<graph_precision_type>> &get_atom_positions() const;
+
+        /**
+         * @brief Get the atoms bonded to an atom
+         * 
+         * @param atom_index 
+         * @return const std::vector<size_t>& 
+         */
+        const std::vector<size_t> &get_bonds(size_t atom_index) const;
+
+        /**
+         * @brief Convert into a new PercolationGraph
+         * 
+         * The buffers of the conversion are taken from @p resource as well, so no other memory is allocated.
+         * 
+         * @param resource The memory resource of the graph, e.g. a percolation::FrameArena that is reset for every frame
+         * @return percolation::PercolationGraph 
+         */
+        percolation::PercolationGraph get_percolation_graph(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+        /**
+         * @brief Convert into an existing PercolationGraph, reusing the memory of the graph and of the workspace
+         * 
+         * The previous contents of @p res are replaced.
+         * Positions and bonds are converted in parallel on the threads set via set_num_threads().
+         * 
+         * @param res The graph to be filled
+         * @param workspace Buffers for the conversion
+         */
+        void fill_percolation_graph(percolation::PercolationGraph &res, ConversionWorkspace &workspace) const;
+
+        /**
+         * @brief Convert into a CompactPercolationGraph, which stores every bond once in 9 bytes
+         * 
+         * Bonds only connect atoms in neighboring periodic cells, so their translations always fit into the 2 bits per axis.
+         * 
+         * @param res The graph to be filled, its previous contents are replaced
+         * @param workspace Buffers for the conversion
+         * @return true 
+         * @return false There are more atoms than the 32 bit indices of the compact graph can address
+         */
+        bool fill_percolation_graph(percolation::CompactPercolationGraph &res, ConversionWorkspace &workspace) const;
 
     protected:
+        /**
+         * @brief Collect every bond once with its translation into the bond arrays of the workspace
+         * 
+         * @param workspace Buffers for the conversion
+         * @return size_t The number of bonds
+         */
+        size_t collect_bonds(ConversionWorkspace &workspace) const;
+
         size_t n_atoms;
         std::vector<vec<graph_precision_type>> triclinic_basis;
 
         std::vector<vec<graph_precision_type>> atom_positions;
         std::vector<std::vector<size_t>> bonds;
+
+        size_t num_threads = 1;
+
+        percolation::AnalysisStatistics *statistics = nullptr;
     };
 }
 
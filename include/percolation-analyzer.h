@@ -30,9 +30,12 @@
 #define __PERCOLATION_ANALYZER_H__
 
 #include <stddef.h>
+#include <stdint.h>
 
+#ifdef __cplusplus
 extern "C"
 {
+#endif
     struct PercolationAnalyzer;
 
     struct TranslationVector
@@ -65,13 +68,46 @@ extern "C"
 
     void free_PercolationAnalyzer(struct PercolationAnalyzer *);
 
+    /**
+     * @brief Remove all vertices and edges, keeping the allocated memory for the next frame
+     */
+    void reset_PercolationAnalyzer(struct PercolationAnalyzer *);
+
     void add_edge(struct PercolationAnalyzer *, size_t source_node, size_t head_node, struct EdgeData *);
     void add_edge_translation(struct PercolationAnalyzer *, size_t source_node, size_t head_node, struct TranslationVector *);
 
+    /**
+     * @brief Add many edges in one call
+     * 
+     * Edge i points from source_nodes[i] to head_nodes[i] with the translation translations[3*i], translations[3*i+1], translations[3*i+2] 
+     * (same as add_edge_translation()). The arrays are only read during the call.
+     * 
+     * @param num_edges The number of edges
+     * @param source_nodes Array of num_edges vertex indices
+     * @param head_nodes Array of num_edges vertex indices
+     * @param translations Array of 3*num_edges translation coordinates
+     * @return int 1 if the edges have been added, 0 if an argument is NULL or a vertex index is negative, in which case no edge is added
+     */
+    int add_edges(struct PercolationAnalyzer *, size_t num_edges, const int64_t *source_nodes, const int64_t *head_nodes, const int64_t *translations);
+
     void reserve_memory(struct PercolationAnalyzer *, size_t num_vertices);
 
     void set_vertex_data(struct PercolationAnalyzer *, size_t vertex_index, struct VertexData *);
 
+    /**
+     * @brief Analyze the graph and write the results into arrays provided by the caller
+     * 
+     * Components are numbered as by get_PercolationInfo(). No memory is allocated for the results, 
+     * buffers for the analysis are kept in the analyzer and reused by later calls.
+     * 
+     * @param num_vertices The length of component_label
+     * @param component_label Output of the component index of every vertex, -1 for vertices that are not part of the graph. May be NULL
+     * @param max_components The length of component_dim, num_vertices is always sufficient
+     * @param component_dim Output of the percolation dimension of every component, only the first max_components are written. May be NULL
+     * @return size_t The number of components
+     */
+    size_t get_component_labels(struct PercolationAnalyzer *, size_t num_vertices, int64_t *component_label, size_t max_components, int64_t *component_dim);
+
     struct PercolationInfo *get_PercolationInfo(struct PercolationAnalyzer *);
     void free_PercolationInfo(struct PercolationInfo *);
 
@@ -86,6 +122,8 @@ extern "C"
 
     int get_next_VertexData(struct VertexList *, struct VertexData *);
     size_t get_num_vertices(struct VertexList *);
-};
+#ifdef __cplusplus
+}
+#endif
 
 #endif
\ No newline at end of file
@@ -26,9 +26,23 @@
  * DEALINGS IN THE SOFTWARE. 
  */
 
+#ifndef __PERCOLATION_DETECTION_H__
+#define __PERCOLATION_DETECTION_H__
+
 #include <vector>
+#include <memory_resource>
 #include <cmath>
 #include <cstdlib>
+#include <cstdint>
+#include <type_traits>
+
+#include "analysis-statistics.hpp"
+#include "thread-pool.hpp"
+
+// The classes of this library are templates over the vector space dimension and the coordinate type of the translations
+// (see BasicPercolationGraph). They are explicitly instantiated for the dimensions 2 and 3 and the coordinate types
+// int8_t, int32_t and int64_t. The following settings select the combination used by the default names
+// (PercolationGraph, TranslationVector, ...), which needs to be one of the instantiated ones.
 
 // The value type of coordinates to be considered
 using translation_coordinate_type = int64_t;
@@ -37,7 +51,7 @@ using translation_coordinate_type = int64_t;
 // The function to obtain the absolute value for the coordinate type
 #define translation_abs_function std::abs
 
-// alternative values for floating point systems
+// alternative values for floating point systems (requires an additional explicit instantiation in the sources)
 //using translation_coordinate_type = float;
 //#define translation_coordinate_precision 1e-7
 //#define translation_abs_function std::abs
@@ -48,17 +62,130 @@ using translation_coordinate_type = int64_t;
 namespace percolation
 {
 
-    struct TranslationVector
+    /**
+     * @brief Properties of a coordinate type for translations
+     * 
+     * @tparam Coord 
+     */
+    template <typename Coord>
+    struct CoordinateTraits
     {
-        translation_coordinate_type vec[vector_space_dimension];
+        /**
+         * @brief Type used to sum up translations along paths through the graph.
+         * 
+         * Integer coordinates are summed up in 64 bit, so that narrow types can be used to store the edges without
+         * risking an overflow of the positions.
+         */
+        using accumulator_type = typename std::conditional<std::is_integral<Coord>::value, int64_t, Coord>::type;
+
+        /**
+         * @brief Check if a coordinate is considered to be zero
+         * 
+         * @param value 
+         * @return true The absolute value is below translation_coordinate_precision (exactly zero for integers)
+         * @return false 
+         */
+        static bool is_zero(Coord value)
+        {
+            if constexpr (std::is_integral<Coord>::value)
+            {
+                return value == 0;
+            }
+            else
+            {
+                return translation_abs_function(value) <= translation_coordinate_precision;
+            }
+        }
+    };
+
+    template <size_t Dim, typename Coord>
+    struct BasicTranslationVector
+    {
+        Coord vec[Dim];
+
+        BasicTranslationVector() = default;
+
+        /**
+         * @brief Convert a translation vector with a different coordinate type
+         * 
+         * @tparam OtherCoord 
+         * @param other 
+         */
+        template <typename OtherCoord>
+        explicit BasicTranslationVector(const BasicTranslationVector<Dim, OtherCoord> &other)
+        {
+            for (size_t i = 0; i < Dim; i++)
+            {
+                vec[i] = Coord(other.vec[i]);
+            }
+        }
+
+        BasicTranslationVector operator-() const
+        {
+            BasicTranslationVector res;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                res.vec[i] = -vec[i];
+            }
+            return res;
+        }
+
+        BasicTranslationVector operator+(BasicTranslationVector const &other) const
+        {
+            BasicTranslationVector res;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                res.vec[i] = vec[i] + other.vec[i];
+            }
+            return res;
+        }
+
+        BasicTranslationVector operator-(BasicTranslationVector const &other) const
+        {
+            BasicTranslationVector res;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                res.vec[i] = vec[i] - other.vec[i];
+            }
+            return res;
+        }
+
+        bool operator==(BasicTranslationVector const &other) const
+        {
+            for (size_t i = 0; i < Dim; i++)
+            {
+                if (vec[i] != other.vec[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Coord &operator[](size_t i)
+        {
+            return vec[i];
+        }
 
-        struct TranslationVector operator-() const;
-        struct TranslationVector operator+(struct TranslationVector const &other) const;
-        struct TranslationVector operator-(struct TranslationVector const &other) const;
-        bool operator==(struct TranslationVector const &other) const;
+        Coord operator[](size_t i) const
+        {
+            return vec[i];
+        }
 
-        translation_coordinate_type &operator[](size_t i);
-        translation_coordinate_type operator[](size_t i) const;
+        /**
+         * @brief Get the vector with all entries set to zero
+         * 
+         * @return BasicTranslationVector 
+         */
+        static BasicTranslationVector zero()
+        {
+            BasicTranslationVector res;
+            for (size_t i = 0; i < Dim; i++)
+            {
+                res.vec[i] = 0;
+            }
+            return res;
+        }
     };
 
     struct VertexData
@@ -66,13 +193,27 @@ namespace percolation
         size_t index;
     };
 
-    struct EdgeData
+    template <size_t Dim, typename Coord>
+    struct BasicEdgeData
     {
-        EdgeData(){};
-        EdgeData(const TranslationVector &trans) : translation(trans) {}
-        TranslationVector translation;
+        BasicEdgeData(){};
+        BasicEdgeData(const BasicTranslationVector<Dim, Coord> &trans) : translation(trans) {}
+        BasicTranslationVector<Dim, Coord> translation;
 
-        struct EdgeData inverse() const;
+        BasicEdgeData inverse() const
+        {
+            BasicEdgeData res(*this);
+            res.translation = -this->translation;
+            return res;
+        }
+    };
+
+    template <size_t Dim, typename Coord>
+    struct BasicEdge
+    {
+        size_t base;
+        size_t head;
+        BasicEdgeData<Dim, Coord> data;
     };
 
     struct ComponentInfo
@@ -82,6 +223,100 @@ namespace percolation
         std::vector<VertexData> vertices;
     };
 
+    /**
+     * @brief Read-only view of a contiguous range of elements owned by someone else
+     * 
+     * @tparam T 
+     */
+    template <typename T>
+    class Span
+    {
+    public:
+        Span() : first(nullptr), num_elements(0) {}
+        Span(const T *first, size_t num_elements) : first(first), num_elements(num_elements) {}
+
+        const T *begin() const
+        {
+            return first;
+        }
+
+        const T *end() const
+        {
+            return first + num_elements;
+        }
+
+        const T &operator[](size_t i) const
+        {
+            return first[i];
+        }
+
+        size_t size() const
+        {
+            return num_elements;
+        }
+
+        bool empty() const
+        {
+            return num_elements == 0;
+        }
+
+    protected:
+        const T *first;
+        size_t num_elements;
+    };
+
+    /**
+     * @brief Result of the percolation analysis stored in flat arrays
+     * 
+     * Holds the same information as a list of ComponentInfo with a fixed number of allocations regardless of the number of components,
+     * and none at all if the same object is filled again for another graph of at most the same size.
+     * Components are numbered and their vertices ordered like in the result of BasicPercolationGraph::get_component_percolation_info().
+     */
+    struct ComponentLabels
+    {
+        /**
+         * @brief The component of every vertex
+         */
+        std::vector<size_t> component_of;
+
+        /**
+         * @brief The vertices of component c are members[offsets[c]] to members[offsets[c+1]-1]
+         */
+        std::vector<size_t> offsets;
+        std::vector<size_t> members;
+
+        /**
+         * @brief The percolation dimension and the number of vertices of every component
+         */
+        std::vector<size_t> percolation_dims;
+        std::vector<size_t> sizes;
+
+        size_t get_num_components() const
+        {
+            return percolation_dims.size();
+        }
+
+        /**
+         * @brief Get the vertex indices of a component
+         * 
+         * @param component_index 
+         * @return Span<size_t> View into members, valid until the labels are changed
+         */
+        Span<size_t> get_members(size_t component_index) const
+        {
+            return Span<size_t>(members.data() + offsets[component_index], sizes[component_index]);
+        }
+
+        /**
+         * @brief Convert into the per-component representation
+         * 
+         * Only the indices of the vertices are known to the labels, other members of VertexData are left default initialized.
+         * 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> to_component_info() const;
+    };
+
     /**
      * @brief Function to calculate the determinant of a square matrix
      * 
@@ -93,6 +328,170 @@ namespace percolation
      */
     translation_coordinate_type det(const std::vector<std::vector<translation_coordinate_type>> &matrix);
 
+    /**
+     * @brief A set of linearly independent translation vectors, kept in echelon form for fast independence checks
+     * 
+     * Storage is fixed to Dim entries, so neither the basis nor any check allocates heap memory.
+     * New vectors are reduced against the stored rows by fraction-free gaussian elimination. For integer coordinates,
+     * every reduced row is divided by the gcd of its entries, which keeps the entries small and avoids the overflow of 
+     * the squared coordinates in a Gram matrix.
+     * 
+     * @tparam Dim The vector space dimension
+     * @tparam Coord The coordinate type, should be wide enough to hold the reduced rows (see CoordinateTraits::accumulator_type)
+     */
+    template <size_t Dim, typename Coord>
+    class BasicTranslationBasis
+    {
+    public:
+        using vector_type = BasicTranslationVector<Dim, Coord>;
+
+        /**
+         * @brief Add a vector to the basis if it is linearly independent of the vectors in the basis.
+         * 
+         * A zero vector is never added.
+         * 
+         * @param new_vector The vector to be added
+         * @return true The vector was independent and has been added
+         * @return false The vector is linearly dependent on the basis and has not been added
+         */
+        bool insert(const vector_type &new_vector)
+        {
+            if (num_vectors >= Dim)
+            {
+                return false;
+            }
+
+            vector_type reduced_vector = new_vector;
+            size_t new_pivot = reduce(reduced_vector);
+            if (new_pivot >= Dim)
+            {
+                return false;
+            }
+
+            vectors[num_vectors] = new_vector;
+            reduced[num_vectors] = reduced_vector;
+            pivot[num_vectors] = new_pivot;
+            num_vectors++;
+            return true;
+        }
+
+        /**
+         * @brief Check if a vector is linearly independent of the vectors in the basis, without adding it
+         * 
+         * @param new_vector 
+         * @return true Adding the vector would increase the dimension of the basis
+         * @return false 
+         */
+        bool is_independent(const vector_type &new_vector) const
+        {
+            if (num_vectors >= Dim)
+            {
+                return false;
+            }
+            vector_type reduced_vector = new_vector;
+            return reduce(reduced_vector) < Dim;
+        }
+
+        /**
+         * @brief Get the number of vectors in the basis, i.e. the dimension of the spanned space
+         * 
+         * @return size_t 
+         */
+        size_t size() const
+        {
+            return num_vectors;
+        }
+
+        /**
+         * @brief Get the i-th vector that has been added to the basis
+         * 
+         * @param i 
+         * @return const vector_type& 
+         */
+        const vector_type &operator[](size_t i) const
+        {
+            return vectors[i];
+        }
+
+    protected:
+        vector_type vectors[Dim];
+        vector_type reduced[Dim];
+        size_t pivot[Dim];
+        size_t num_vectors = 0;
+
+        static Coord gcd(Coord a, Coord b)
+        {
+            a = (a < 0 ? -a : a);
+            b = (b < 0 ? -b : b);
+            while (b != 0)
+            {
+                Coord tmp = a % b;
+                a = b;
+                b = tmp;
+            }
+            return a;
+        }
+
+        /**
+         * @brief Eliminate the pivot entries of all reduced rows from a vector
+         * 
+         * @param vec The vector to be reduced in place
+         * @return size_t The index of the first non-zero entry of the reduced vector or Dim if it is zero
+         */
+        size_t reduce(vector_type &vec) const
+        {
+            for (size_t r = 0; r < num_vectors; r++)
+            {
+                const vector_type &row = reduced[r];
+                const size_t p = pivot[r];
+                if (CoordinateTraits<Coord>::is_zero(vec[p]))
+                {
+                    continue;
+                }
+
+                if constexpr (std::is_integral<Coord>::value)
+                {
+                    // vec = a * vec - b * row eliminates the pivot entry without leaving the integers
+                    Coord divisor = gcd(row[p], vec[p]);
+                    Coord a = row[p] / divisor;
+                    Coord b = vec[p] / divisor;
+
+                    Coord content = 0;
+                    for (size_t i = 0; i < Dim; i++)
+                    {
+                        vec[i] = a * vec[i] - b * row[i];
+                        content = gcd(content, vec[i]);
+                    }
+                    if (content > 1)
+                    {
+                        for (size_t i = 0; i < Dim; i++)
+                        {
+                            vec[i] /= content;
+                        }
+                    }
+                }
+                else
+                {
+                    Coord factor = vec[p] / row[p];
+                    for (size_t i = 0; i < Dim; i++)
+                    {
+                        vec[i] -= factor * row[i];
+                    }
+                    vec[p] = 0;
+                }
+            }
+
+            for (size_t i = 0; i < Dim; i++)
+            {
+                if (!CoordinateTraits<Coord>::is_zero(vec[i]))
+                {
+                    return i;
+                }
+            }
+            return Dim;
+        }
+    };
+
     /**
      * @brief Function to check if a given basis set of translation vectors and another translation vector are linearly independent
      * 
@@ -101,17 +500,118 @@ namespace percolation
      * Otherwise false will be the result.
      * 
      * If the result is true, adding the new_vector to existing_base will create a new basis set of vectors.
+     * The check runs on a BasicTranslationBasis on the stack and does not allocate any memory.
      * 
      * @param existing_base The pre-existing, linearly independent set of vectors or empty if none have been added yet
      * @param new_vector The vector to be checked for linear independence from the existing basis set
      * @return true The new_vector can be added to the set maintaining its basis properties
      * @return false The new_vector cannot be added to the set so that the result has vector basis properties.
      */
-    bool check_translation_independent(const std::vector<TranslationVector> &existing_base, const TranslationVector &new_vector);
+    template <size_t Dim, typename Coord>
+    bool check_translation_independent(const std::vector<BasicTranslationVector<Dim, Coord>> &existing_base, const BasicTranslationVector<Dim, Coord> &new_vector)
+    {
+        using accumulator_type = typename CoordinateTraits<Coord>::accumulator_type;
+        using vector_type = BasicTranslationVector<Dim, accumulator_type>;
 
-    class PercolationGraph
+        if (existing_base.size() + 1 > Dim)
+        {
+            return false;
+        }
+
+        BasicTranslationBasis<Dim, accumulator_type> basis;
+        for (const BasicTranslationVector<Dim, Coord> &base_vector : existing_base)
+        {
+            basis.insert(vector_type(base_vector));
+        }
+        return basis.is_independent(vector_type(new_vector));
+    }
+
+    /**
+     * @brief Graph of the bonds in a periodic system, which is analyzed for its percolation properties
+     * 
+     * @tparam Dim The vector space dimension of the periodic system
+     * @tparam Coord The coordinate type of the edge translations
+     */
+    template <size_t Dim, typename Coord>
+    class BasicPercolationGraph
     {
     public:
+        using translation_type = BasicTranslationVector<Dim, Coord>;
+        using edge_data_type = BasicEdgeData<Dim, Coord>;
+        using edge_type = BasicEdge<Dim, Coord>;
+
+        /**
+         * @brief Type of the positions of vertices and of the lattice vectors, wide enough to sum up translations
+         */
+        using position_type = BasicTranslationVector<Dim, typename CoordinateTraits<Coord>::accumulator_type>;
+        using basis_type = BasicTranslationBasis<Dim, typename CoordinateTraits<Coord>::accumulator_type>;
+
+        /**
+         * @brief Buffers used by the analysis
+         * 
+         * Passing the same workspace to repeated analyses (e.g. of consecutive frames) reuses its memory instead of
+         * allocating it anew for every call. A workspace must not be used by two analyses at the same time.
+         */
+        struct AnalysisWorkspace
+        {
+            std::vector<uint8_t> visited;
+            std::vector<position_type> positions;
+            std::vector<size_t> start_vertices;
+            std::vector<size_t> component_sizes;
+            std::vector<size_t> component_edges;
+            std::vector<size_t> component_order;
+
+            /**
+             * @brief Bfs queue of the queries, see max_percolation_dim()
+             */
+            std::vector<size_t> query_queue;
+
+            /**
+             * @brief Union-find forest of the parallel labeling, reused as visited flags of the parallel bfs
+             */
+            AtomicArray<size_t> parents;
+
+            /**
+             * @brief Sizes and edge counts of the components summed up by the parallel labeling
+             */
+            AtomicArray<size_t> component_counts;
+
+            std::vector<size_t> block_offsets;
+            std::vector<std::vector<size_t>> thread_frontiers;
+
+            /**
+             * @brief Number of discovered vertices, thread and offset in the thread's frontier of every chunk of a level of the parallel bfs
+             */
+            std::vector<size_t> level_chunks;
+
+            /**
+             * @brief Labels computed on the way to a list of ComponentInfo
+             */
+            ComponentLabels labels;
+
+            /**
+             * @brief Cycle translations collected by each thread when a component is searched by all threads
+             */
+            std::vector<basis_type> thread_bases;
+
+            /**
+             * @brief Bfs counters of every thread, only used if statistics are enabled
+             */
+            std::vector<BfsCounters> thread_counters;
+        };
+
+        BasicPercolationGraph() = default;
+
+        /**
+         * @brief Create an empty graph whose vertices and edges are stored in @p resource
+         * 
+         * With a percolation::FrameArena, a graph constructed anew for every frame takes its memory from one reused buffer.
+         * Copies of the graph use the default resource, moved graphs keep the resource of the original.
+         * 
+         * @param resource The memory resource, must outlive the graph
+         */
+        explicit BasicPercolationGraph(std::pmr::memory_resource *resource);
+
         /**
          * @brief Reserve memory for the desired maximum number of vertices.
          * 
@@ -143,7 +643,7 @@ namespace percolation
          * @return true The edge has successfully been added.
          * @return false 
          */
-        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const EdgeData &edge_data);
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data);
 
         /**
          * @brief Wrapper to directly provide the TranslationVector instead of an EdgeData object
@@ -156,34 +656,474 @@ namespace percolation
          * @return true 
          * @return false 
          */
-        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const TranslationVector &edge_trans);
+        bool add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Replace all edges of the graph by the edges of a flat edge list
+         * 
+         * Builds the adjacency structure in one pass over the list instead of inserting the edges one by one.
+         * Every entry is treated like a call to add_edge(), i.e. the inverse edge is added as well.
+         * Vertices are reserved up to the largest index in the list, existing vertex data is kept.
+         * 
+         * @param edge_list Pointer to the first edge of the list
+         * @param num_edges Number of edges in the list
+         * @return true The edges have successfully been added.
+         * @return false Memory allocation has failed
+         */
+        bool build_from_edges(const edge_type *edge_list, size_t num_edges);
+
+        /**
+         * @brief Wrapper to directly provide a std::vector of edges
+         * 
+         * @param edge_list 
+         * @return true 
+         * @return false 
+         */
+        bool build_from_edges(const std::vector<edge_type> &edge_list);
+
+        /**
+         * @brief Replace all edges of the graph by edges given in structure-of-arrays layout
+         * 
+         * Works like build_from_edges(), but reads the edges straight from separate arrays, e.g. the bond arrays of a 
+         * memory-mapped frame file, so they do not need to be copied into an edge list first.
+         * 
+         * @param edge_base The base vertex of every edge
+         * @param edge_head The head vertex of every edge
+         * @param edge_translations Dim arrays, array i holds the translation component of every edge along axis i
+         * @param num_edges Number of edges in the arrays
+         * @return true The edges have successfully been added.
+         * @return false Memory allocation has failed
+         */
+        bool build_from_edge_arrays(const size_t *edge_base, const size_t *edge_head, const int8_t *const *edge_translations, size_t num_edges);
+
+        /**
+         * @brief Prepare the graph for edges added by several threads at the same time via add_edge_concurrent()
+         * 
+         * Every slot is an append buffer owned by one thread, so the threads do not need any lock. 
+         * Must not be called while edges are added concurrently.
+         * 
+         * @param num_slots The number of slots, i.e. the number of threads adding edges
+         */
+        void begin_concurrent_insertion(size_t num_slots);
+
+        /**
+         * @brief Add an edge like add_edge(), but into the buffer of one slot
+         * 
+         * Different slots may be filled by different threads at the same time, each slot must only be used by one thread at a time.
+         * The edges only become part of the graph with the next call of finalize(), which is required before the analysis.
+         * 
+         * @param slot The slot of the calling thread, less than the number passed to begin_concurrent_insertion()
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_data 
+         */
+        void add_edge_concurrent(size_t slot, size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data);
+
+        /**
+         * @brief Wrapper to directly provide the TranslationVector instead of an EdgeData object
+         * 
+         * @param slot 
+         * @param vertex_index_base 
+         * @param vertex_index_head 
+         * @param edge_trans 
+         */
+        void add_edge_concurrent(size_t slot, size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans);
+
+        /**
+         * @brief Merge all edges added via add_edge() or add_edge_concurrent() into the adjacency structure
+         * 
+         * The analysis methods do this on demand for edges added via add_edge(), but as they are const, calling finalize() once 
+         * after building the graph is required if the analysis should run on the same graph from multiple threads.
+         * Edges added via add_edge_concurrent() are only merged here: vertices are reserved up to the largest index of all slots
+         * and the edges are appended in the order of the slots, so the result does not depend on the timing of the threads.
+         * The slots are merged on the threads set via set_num_threads(), one slot per task.
+         */
+        void finalize();
+
+        /**
+         * @brief Remove all vertices and edges while keeping the allocated memory
+         * 
+         * Allows to reuse one graph object for many frames without reallocating its storage every time.
+         * The number of threads set via set_num_threads() and the slots of begin_concurrent_insertion() are kept.
+         */
+        void reset();
+
+        /**
+         * @brief Set the number of threads used by get_component_percolation_info()
+         * 
+         * The components are found by a parallel union-find and then analyzed in parallel, largest first, on threads created for each call.
+         * A component with more than a thread's share of the vertices is searched by all threads together.
+         * The results are identical to the ones of the serial analysis, including the order of the vertices within each component.
+         * 
+         * @param num_threads The number of threads to use, 0 for one thread per hardware thread. Default is 1 (serial analysis).
+         */
+        void set_num_threads(size_t num_threads);
+
+        /**
+         * @brief Get the number of threads used by get_component_percolation_info() as set by set_num_threads()
+         * 
+         * @return size_t 
+         */
+        size_t get_num_threads() const;
+
+        /**
+         * @brief Register an object to which timings and counters of the analysis are added
+         * 
+         * Only has an effect if the library is built with statistics (see statistics_enabled()).
+         * 
+         * @param statistics The statistics object, which must outlive the analyses, or nullptr to stop collecting statistics
+         */
+        void set_statistics(AnalysisStatistics *statistics);
 
         /**
          * @brief Get a list of all connected component of the current graph and their respective percolation information.
          * 
-         * Will run a breadth first search to detect the components of the graph and then find the percolation dimension of 
-         * each component by a more thorough bfs analyzing the grid structure of the graph
+         * Will run a single breadth first search over the graph, which detects the components of the graph and at the same time
+         * finds the percolation dimension of each component by analyzing the grid structure of the graph.
+         * For a parallel analysis (see set_num_threads()), the components are detected first to distribute them among the threads.
          * 
          * @return std::vector<ComponentInfo> 
          */
         std::vector<ComponentInfo> get_component_percolation_info() const;
 
+        /**
+         * @brief Same as get_component_percolation_info(), but reuses the buffers of @p workspace
+         * 
+         * @param workspace 
+         * @return std::vector<ComponentInfo> 
+         */
+        std::vector<ComponentInfo> get_component_percolation_info(AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Analyze the graph like get_component_percolation_info(), but store the result in flat arrays
+         * 
+         * The arrays of @p labels are reused, so analyzing many graphs into the same object does not allocate memory once it is large enough.
+         * get_component_percolation_info() is implemented on top of this and converts the labels into one ComponentInfo per component.
+         * 
+         * @param labels Output of the components
+         */
+        void get_component_labels(ComponentLabels &labels) const;
+
+        /**
+         * @brief Same as get_component_labels(), but reuses the buffers of @p workspace
+         * 
+         * @param labels 
+         * @param workspace 
+         */
+        void get_component_labels(ComponentLabels &labels, AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Get the largest percolation dimension among all components with at least @p min_component_size vertices
+         * 
+         * Cheaper than a full analysis if only this number is of interest: no labels are stored, the search stops as soon as a 
+         * component percolates in all Dim directions and the bfs of that component is not finished.
+         * With a size threshold, the components are found first and only the ones above the threshold are analyzed, 
+         * largest first. Components that are trees are skipped without evaluating any cycles.
+         * 
+         * @param min_component_size Components with fewer vertices are ignored
+         * @return size_t 
+         */
+        size_t max_percolation_dim(size_t min_component_size = 0) const;
+
+        /**
+         * @brief Same as max_percolation_dim(), but reuses the buffers of @p workspace
+         * 
+         * @param min_component_size 
+         * @param workspace 
+         * @return size_t 
+         */
+        size_t max_percolation_dim(size_t min_component_size, AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Check if any component with at least @p min_component_size vertices has a percolation dimension of at least @p dim
+         * 
+         * Stops at the first component found, in the middle of its bfs. See max_percolation_dim() for the size threshold.
+         * 
+         * @param dim The required percolation dimension
+         * @param min_component_size Components with fewer vertices are ignored
+         * @return true 
+         * @return false 
+         */
+        bool any_component_reaches(size_t dim, size_t min_component_size = 0) const;
+
+        /**
+         * @brief Same as any_component_reaches(), but reuses the buffers of @p workspace
+         * 
+         * @param dim 
+         * @param min_component_size 
+         * @param workspace 
+         * @return true 
+         * @return false 
+         */
+        bool any_component_reaches(size_t dim, size_t min_component_size, AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Check if a component with at least @p min_component_size vertices percolates along all axes of @p axis_mask
+         * 
+         * A component percolates along axis a if one of its cycles has a net translation with a non-zero entry a, i.e. if it connects 
+         * to its own periodic image along that axis. A single diagonal chain therefore percolates along more than one axis.
+         * Stops at the first component found, in the middle of its bfs. See max_percolation_dim() for the size threshold.
+         * 
+         * @param axis_mask Bit a is set for every axis a that is required, e.g. 0b100 for the z axis. Bits of axes >= Dim can never be satisfied.
+         * @param min_component_size Components with fewer vertices are ignored
+         * @return true 
+         * @return false 
+         */
+        bool percolates_along(unsigned axis_mask, size_t min_component_size = 0) const;
+
+        /**
+         * @brief Same as percolates_along(), but reuses the buffers of @p workspace
+         * 
+         * @param axis_mask 
+         * @param min_component_size 
+         * @param workspace 
+         * @return true 
+         * @return false 
+         */
+        bool percolates_along(unsigned axis_mask, size_t min_component_size, AnalysisWorkspace &workspace) const;
+
     protected:
         /**
          * @brief Member to keep track of vertex information 
          */
-        std::vector<VertexData> vertices;
+        std::pmr::vector<VertexData> vertices;
+
+        /**
+         * @brief Edges added via add_edge() that have not been merged into the adjacency structure yet
+         */
+        mutable std::pmr::vector<edge_type> pending_edges;
 
         /**
-         * @brief Member to keep track of the edges of the constructed graph
+         * @brief Compressed sparse row offsets: the edges of vertex i are adjacency[adjacency_offsets[i]] to adjacency[adjacency_offsets[i+1]-1]
          */
-        std::vector<std::vector<std::pair<size_t, EdgeData>>> edges;
+        mutable std::pmr::vector<size_t> adjacency_offsets;
 
         /**
-         * @brief Get the connected components of the current graph.
+         * @brief Neighbor index and edge data of all outgoing edges, grouped by their base vertex
          * 
-         * @return std::vector<ComponentInfo> One component info entry for each detected component.
+         * Loops (edges from a vertex to itself) are only stored once.
          */
-        std::vector<ComponentInfo> get_components() const;
+        mutable std::pmr::vector<std::pair<size_t, edge_data_type>> adjacency;
+
+        /**
+         * @brief Append buffer of one thread for add_edge_concurrent()
+         * 
+         * Aligned to a cache line, so that threads filling neighboring slots do not slow each other down.
+         */
+        struct alignas(64) EdgeSlot
+        {
+            std::vector<edge_type> edges;
+            size_t max_index = 0;
+        };
+
+        std::vector<EdgeSlot> edge_slots;
+
+        /**
+         * @brief The lists merged by finalize(), kept to reuse the memory
+         */
+        std::vector<Span<edge_type>> merge_lists;
+
+        /**
+         * @brief An edge of merge_edges_parallel() waiting in the buffer of its block, with the base vertex relative to the block
+         */
+        struct MergeEntry
+        {
+            size_t head;
+            edge_data_type data;
+            uint32_t block_vertex;
+        };
+
+        /**
+         * @brief Stage position of every list in every block of vertices in merge_edges_parallel(), list after list
+         */
+        mutable std::vector<size_t> merge_block_counts;
+
+        /**
+         * @brief Offset of the staged edges of every block of vertices in merge_edges_parallel()
+         */
+        mutable std::vector<size_t> merge_stage_offsets;
+
+        /**
+         * @brief Offset of the first edge of every block of vertices in merge_edges_parallel()
+         */
+        mutable std::vector<size_t> merge_block_offsets;
+
+        /**
+         * @brief Insert position of every vertex of the block that each thread sorts in merge_edges_parallel()
+         */
+        mutable std::vector<size_t> merge_vertex_positions;
+
+        /**
+         * @brief Merge lists of edges into the adjacency structure via a counting sort over the base vertices.
+         * 
+         * The edges of each vertex keep the order in which they have been added, the lists are taken one after another.
+         * 
+         * @param edge_lists 
+         * @param num_lists 
+         */
+        void merge_edges(const Span<edge_type> *edge_lists, size_t num_lists) const;
+
+        /**
+         * @brief Merge lists of edges like merge_edges(), but with the lists and the blocks of vertices spread over threads
+         * 
+         * Every list counts its edges per block of vertices and scatters them concurrently into its own range of a staging 
+         * buffer, grouped by block and, within each block, ordered by list. Each block is then sorted by vertex into the 
+         * adjacency structure on its own, which keeps the order of the lists and the result is the same as with merge_edges().
+         * Apart from the staging buffer of the new edges, which is taken from the memory resource of the graph and released 
+         * again, the scratch memory only grows with the number of lists times the number of blocks.
+         * 
+         * @param edge_lists 
+         * @param num_lists 
+         * @param thread_count The number of threads to use, at least 2
+         */
+        void merge_edges_parallel(const Span<edge_type> *edge_lists, size_t num_lists, size_t thread_count) const;
+
+        /**
+         * @brief Build the adjacency structure from scratch via a counting sort over the base vertices
+         * 
+         * @param for_each_edge Callable that passes the base, head and edge data of every edge to the callable it is given
+         */
+        template <typename EdgeVisitor>
+        void build_adjacency(const EdgeVisitor &for_each_edge) const;
+
+        /**
+         * @brief Make sure that the adjacency structure covers all vertices and edges added so far
+         */
+        void update_adjacency() const;
+
+        /**
+         * @brief Number of threads for the analysis, 0 for one thread per hardware thread
+         */
+        size_t num_threads = 1;
+
+        AnalysisStatistics *statistics = nullptr;
+
+        /**
+         * @brief Find the connected components of the current graph without analyzing them
+         * 
+         * Used to distribute the components among threads before they are analyzed.
+         * 
+         * @param start_vertices Output of the smallest vertex index of each component, in increasing order
+         * @param component_sizes Output of the number of vertices of each component
+         * @param component_edges Output of the number of edges (counting both directions) of each component
+         * @param visited Per-vertex flag, needs to be zero initially and will be set for all vertices
+         */
+        void label_components(std::vector<size_t> &start_vertices, std::vector<size_t> &component_sizes, std::vector<size_t> &component_edges, std::vector<uint8_t> &visited) const;
+
+        /**
+         * @brief Find the connected components of the current graph using all threads
+         * 
+         * Lock-free union-find in the style of Afforest: every vertex is first linked to its first neighbor, which merges most
+         * of a giant component. The remaining edges only need to be processed for the vertices outside of the largest component
+         * found by sampling. A root is always linked below the smaller root, so every component ends up with its smallest vertex
+         * as root and the components are numbered in the order of their smallest vertex like in the serial analysis.
+         * 
+         * @param labels Output of component_of, sizes and offsets
+         * @param workspace Output of start_vertices (the root of each component) and component_edges, parents holds the root of every vertex afterwards
+         */
+        void label_components_parallel(ComponentLabels &labels, AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Determine the percolation dimension of one large component using all threads
+         * 
+         * Works like analyze_component(), but on a level-synchronous bfs: the vertices of the current level first claim their 
+         * undiscovered neighbors with an atomic maximum on parents, which the vertex that comes first in the level wins. Then each 
+         * vertex discovers the neighbors it has claimed in the order of its edges, chunk by chunk, and the chunks are placed 
+         * in order behind the level. So the members and positions are the same as in the serial bfs, whatever the thread timing. 
+         * Afterwards, the cycle translations of the edges are collected by all threads in local bases, which are merged at the end.
+         * The threads are started once per component and meet at a barrier between the levels. Narrow levels, e.g. along 
+         * chains, are expanded by a single thread without any barrier.
+         * 
+         * @param component_index The component, labeled by label_components_parallel()
+         * @param check_cycles If false, the component is known to be a tree and cycle translations are not evaluated
+         * @param labels Labels of the graph, the members of the component are written in bfs order
+         * @param workspace Workspace used for the labeling
+         * @param thread_counters Counters of every thread if statistics are enabled, unused (and may be nullptr) otherwise
+         * @return size_t The percolation dimension of the component
+         */
+        size_t analyze_component_parallel(size_t component_index, bool check_cycles, ComponentLabels &labels, AnalysisWorkspace &workspace, BfsCounters *thread_counters) const;
+
+        /**
+         * @brief Condition at which a query stops the analysis
+         */
+        struct QueryTarget
+        {
+            /**
+             * @brief Required number of linearly independent cycle translations
+             */
+            size_t min_dim = 0;
+
+            /**
+             * @brief Axes along which a cycle translation with a non-zero entry is required
+             */
+            unsigned axis_mask = 0;
+
+            /**
+             * @brief Set by the analysis once a component satisfying the condition has been found
+             */
+            bool reached = false;
+        };
+
+        /**
+         * @brief Check if the cycle translations found so far satisfy a query
+         * 
+         * @param basis 
+         * @param target 
+         * @return true 
+         * @return false 
+         */
+        static bool is_target_reached(const basis_type &basis, const QueryTarget &target);
+
+        /**
+         * @brief Analyze the components with at least @p min_component_size vertices until one of them satisfies @p target
+         * 
+         * @param target The condition of the query, its member reached is set to the result
+         * @param min_component_size 
+         * @param workspace 
+         * @return size_t The largest percolation dimension among the analyzed components. Components are only analyzed 
+         * until the target is reached, so this is a lower bound unless the target is a percolation in all Dim directions.
+         */
+        size_t run_query(QueryTarget &target, size_t min_component_size, AnalysisWorkspace &workspace) const;
+
+        /**
+         * @brief Discover a component and determine its percolation dimension in a single bfs
+         * 
+         * Every vertex is enqueued once and assigned the position of its first copy reached from the start vertex, 
+         * which builds a spanning tree of the component. Every edge outside of the spanning tree closes a cycle, whose net 
+         * translation is the difference between the position via that edge and the vertex's assigned position. Each of these 
+         * edges is evaluated exactly once, until the maximum dimension is attained. The percolation dimension is the 
+         * number of linearly independent cycle translations.
+         * Time and memory are therefore bounded by O(#vertices + #edges) of the component.
+         * 
+         * Only the entries of @p visited and @p positions belonging to the vertices of the component are accessed,
+         * so different components can be analyzed concurrently using the same arrays.
+         * 
+         * @param start_vertex The vertex to start the bfs at
+         * @param check_cycles If false, the component is known to be a tree and cycle translations are not evaluated
+         * @param component_vertices Output of the indices of all vertices of the component in bfs order, needs room for all of them
+         * @param num_component_vertices Output of the number of vertices of the component
+         * @param visited Per-vertex state of the bfs, needs to be zero for the component's vertices
+         * @param positions Per-vertex storage for the position at which the vertex was first reached
+         * @param counters Counters of the bfs if statistics are enabled, unused (and may be nullptr) otherwise
+         * @param target If given, the bfs stops as soon as the condition is satisfied and sets target->reached. 
+         * The component is only partially discovered in that case.
+         * @return size_t The percolation dimension of the component
+         */
+        size_t analyze_component(size_t start_vertex, bool check_cycles, size_t *component_vertices, size_t &num_component_vertices, std::vector<uint8_t> &visited, std::vector<position_type> &positions, BfsCounters *counters, QueryTarget *target = nullptr) const;
     };
-}
\ No newline at end of file
+
+    using TranslationVector = BasicTranslationVector<vector_space_dimension, translation_coordinate_type>;
+    using EdgeData = BasicEdgeData<vector_space_dimension, translation_coordinate_type>;
+    using Edge = BasicEdge<vector_space_dimension, translation_coordinate_type>;
+    using TranslationBasis = BasicTranslationBasis<vector_space_dimension, CoordinateTraits<translation_coordinate_type>::accumulator_type>;
+    using PercolationGraph = BasicPercolationGraph<vector_space_dimension, translation_coordinate_type>;
+
+    extern template class BasicPercolationGraph<2, int8_t>;
+    extern template class BasicPercolationGraph<2, int32_t>;
+    extern template class BasicPercolationGraph<2, int64_t>;
+    extern template class BasicPercolationGraph<3, int8_t>;
+    extern template class BasicPercolationGraph<3, int32_t>;
+    extern template class BasicPercolationGraph<3, int64_t>;
+}
+
+#endif
\ No newline at end of file
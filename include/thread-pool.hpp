@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#ifndef __PERCOLATION_THREAD_POOL_H__
+#define __PERCOLATION_THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace percolation
+{
+    /**
+     * @brief Translate a requested number of threads into the number of threads to actually use
+     * 
+     * @param num_threads The requested number of threads, 0 for one thread per hardware thread
+     * @return size_t The number of threads to use (at least 1)
+     */
+    inline size_t resolve_thread_count(size_t num_threads)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        return (num_threads == 0 ? 1 : num_threads);
+    }
+
+    /**
+     * @brief Fixed-size array of atomics for data shared between the threads of a parallel loop
+     * 
+     * std::vector cannot hold atomics, as it needs to move its elements when growing. The array is only reallocated
+     * if it grows, so reusing it for inputs of similar size does not allocate memory.
+     * 
+     * @tparam T The type of the entries
+     */
+    template <typename T>
+    class AtomicArray
+    {
+    public:
+        /**
+         * @brief Change the number of entries, the values of all entries are unspecified afterwards
+         * 
+         * @param size The new number of entries
+         */
+        void resize(size_t size)
+        {
+            if (size > capacity)
+            {
+                entries.reset(new std::atomic<T>[size]);
+                capacity = size;
+            }
+            num_entries = size;
+        }
+
+        size_t size() const
+        {
+            return num_entries;
+        }
+
+        std::atomic<T> &operator[](size_t i)
+        {
+            return entries[i];
+        }
+
+        const std::atomic<T> &operator[](size_t i) const
+        {
+            return entries[i];
+        }
+
+    private:
+        std::unique_ptr<std::atomic<T>[]> entries;
+        size_t capacity = 0;
+        size_t num_entries = 0;
+    };
+
+    /**
+     * @brief Reusable barrier for a fixed number of threads, as std::barrier is only available from C++20 on
+     * 
+     * Waiting threads spin for a short while before they block, since the phases between two barriers are often short.
+     * Everything written by a thread before it arrives is visible to all threads once they are released.
+     */
+    class ThreadBarrier
+    {
+    public:
+        explicit ThreadBarrier(size_t num_threads) : num_threads(num_threads) {}
+
+        /**
+         * @brief Wait until all threads have arrived, the last one releases the others
+         */
+        void arrive_and_wait()
+        {
+            size_t curr_generation = generation.load(std::memory_order_acquire);
+            if (num_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == num_threads)
+            {
+                num_arrived.store(0, std::memory_order_relaxed);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    generation.store(curr_generation + 1, std::memory_order_release);
+                }
+                released.notify_all();
+                return;
+            }
+
+            for (size_t spin = 0; spin < max_spins; spin++)
+            {
+                if (generation.load(std::memory_order_acquire) != curr_generation)
+                {
+                    return;
+                }
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&]() { return generation.load(std::memory_order_acquire) != curr_generation; });
+        }
+
+    private:
+        static const size_t max_spins = 4096;
+
+        const size_t num_threads;
+        std::atomic<size_t> num_arrived{0};
+        std::atomic<size_t> generation{0};
+        std::mutex mutex;
+        std::condition_variable released;
+    };
+
+    /**
+     * @brief Run a task once on each of @p num_threads threads, the calling thread being the one with index 0
+     * 
+     * Unlike parallel_for_dynamic(), the threads live for the whole task, so they can work through several phases
+     * separated by a ThreadBarrier. The task must not throw, as the other threads could wait for it forever.
+     * 
+     * @tparam Task Callable as task(size_t thread_index)
+     * @param num_threads The number of threads to use, at least 1
+     * @param task The task to run
+     */
+    template <typename Task>
+    void parallel_run(size_t num_threads, Task &&task)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (size_t thread_index = 1; thread_index < num_threads; thread_index++)
+        {
+            threads.emplace_back(task, thread_index);
+        }
+        task(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Run a task for every index in [0, num_tasks) on a pool of threads created for this call
+     * 
+     * Tasks are handed out dynamically in increasing index order in blocks of @p grain_size, so threads that finish
+     * early take over the remaining work. If the tasks are sorted by decreasing cost, this balances the load well
+     * even if a few tasks are much more expensive than the rest.
+     * If only one thread is requested, all tasks run on the calling thread.
+     * The first exception thrown by a task is rethrown on the calling thread after all threads have finished.
+     * 
+     * @tparam Task Callable as task(size_t task_index, size_t thread_index)
+     * @param num_tasks The number of tasks to run
+     * @param num_threads The number of threads to use, 0 for one thread per hardware thread
+     * @param grain_size The number of consecutive tasks handed out at once
+     * @param task The task to run
+     */
+    template <typename Task>
+    void parallel_for_dynamic(size_t num_tasks, size_t num_threads, size_t grain_size, Task &&task)
+    {
+        num_threads = resolve_thread_count(num_threads);
+        grain_size = (grain_size == 0 ? 1 : grain_size);
+        size_t max_useful_threads = (num_tasks + grain_size - 1) / grain_size;
+        num_threads = (num_threads < max_useful_threads ? num_threads : max_useful_threads);
+
+        if (num_threads <= 1)
+        {
+            for (size_t t = 0; t < num_tasks; t++)
+            {
+                task(t, 0);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_task(0);
+        std::exception_ptr first_exception;
+        std::mutex exception_mutex;
+
+        auto worker = [&](size_t thread_index) {
+            try
+            {
+                while (true)
+                {
+                    size_t begin = next_task.fetch_add(grain_size, std::memory_order_relaxed);
+                    if (begin >= num_tasks)
+                    {
+                        break;
+                    }
+                    size_t end = (begin + grain_size < num_tasks ? begin + grain_size : num_tasks);
+                    for (size_t t = begin; t < end; t++)
+                    {
+                        task(t, thread_index);
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!first_exception)
+                {
+                    first_exception = std::current_exception();
+                }
+                // Make the other threads stop picking up new work
+                next_task.store(num_tasks, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (size_t thread_index = 1; thread_index < num_threads; thread_index++)
+        {
+            threads.emplace_back(worker, thread_index);
+        }
+        worker(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        if (first_exception)
+        {
+            std::rethrow_exception(first_exception);
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -29,6 +29,10 @@
 #ifndef __MOLECULAR_GRAPH_VEC_H__
 #define __MOLECULAR_GRAPH_VEC_H__
 
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 /**
  * @brief Simple geometric 3d vector class
  * 
@@ -173,12 +177,13 @@ vec<T> operator*(T scalar, const vec<T> &other)
  * @brief Retrieve the basis coefficients of vector @p pos with respect to a triclinic @p basis 
  * 
  * @tparam T 
+ * @tparam Basis Container of the three basis vectors, e.g. std::vector or std::array
  * @param pos 
  * @param basis 
  * @return vec<T> 
  */
-template <typename T>
-vec<T> decompose(const vec<T> &pos, const std::vector<vec<T>> &basis)
+template <typename T, typename Basis>
+vec<T> decompose(const vec<T> &pos, const Basis &basis)
 {
     vec<T> cpy(pos);
     vec<T> res;
@@ -0,0 +1,299 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "compact-percolation.hpp"
+
+namespace percolation
+{
+    template <size_t Dim, typename Index>
+    void BasicCompactUnionFind<Dim, Index>::reset(size_t num_vertices)
+    {
+        const Index no_basis = std::numeric_limits<Index>::max();
+        parent.resize(num_vertices);
+        parent_offset.assign(num_vertices, BasicTranslationVector<Dim, offset_type>::zero());
+        rank.assign(num_vertices, 0);
+        basis_index.assign(num_vertices, no_basis);
+        for (size_t i = 0; i < num_vertices; i++)
+        {
+            parent[i] = Index(i);
+        }
+        lattice_bases.clear();
+        free_bases.clear();
+        num_components = num_vertices;
+    }
+
+    template <size_t Dim, typename Index>
+    void BasicCompactUnionFind<Dim, Index>::add_edge(Index vertex_index_base, Index vertex_index_head, const position_type &edge_trans)
+    {
+        const Index no_basis = std::numeric_limits<Index>::max();
+
+        position_type base_position, head_position;
+        Index base_root = find_root(vertex_index_base, base_position);
+        Index head_root = find_root(vertex_index_head, head_position);
+
+        // Translation of the head root relative to the base root if the edge is used to connect the two
+        position_type head_root_offset = base_position + edge_trans - head_position;
+
+        if (base_root == head_root)
+        {
+            // The edge closes a cycle, its net translation is a lattice vector of the component
+            add_lattice_vector(base_root, head_root_offset);
+            return;
+        }
+
+        // Union by rank: attach the lower tree below the root of the higher one
+        Index new_root = base_root;
+        Index child_root = head_root;
+        if (rank[base_root] < rank[head_root])
+        {
+            new_root = head_root;
+            child_root = base_root;
+            head_root_offset = -head_root_offset;
+        }
+        else if (rank[base_root] == rank[head_root])
+        {
+            rank[new_root]++;
+        }
+
+        parent[child_root] = new_root;
+        parent_offset[child_root] = BasicTranslationVector<Dim, offset_type>(head_root_offset);
+        num_components--;
+
+        // Lattice vectors do not depend on the reference vertex, so the ones of the absorbed component carry over
+        Index child_basis = basis_index[child_root];
+        if (child_basis != no_basis)
+        {
+            if (basis_index[new_root] == no_basis)
+            {
+                basis_index[new_root] = child_basis;
+            }
+            else
+            {
+                const basis_type &child_lattice = lattice_bases[child_basis];
+                for (size_t i = 0; i < child_lattice.size(); i++)
+                {
+                    add_lattice_vector(new_root, child_lattice[i]);
+                }
+                lattice_bases[child_basis] = basis_type();
+                free_bases.push_back(child_basis);
+            }
+            basis_index[child_root] = no_basis;
+        }
+    }
+
+    template <size_t Dim, typename Index>
+    std::vector<ComponentInfo> BasicCompactUnionFind<Dim, Index>::get_component_percolation_info()
+    {
+        const Index no_basis = std::numeric_limits<Index>::max();
+        const size_t num_vertices = parent.size();
+
+        std::vector<ComponentInfo> component_info;
+        component_info.reserve(num_components);
+        std::vector<size_t> component_size;
+        component_size.reserve(num_components);
+
+        // Components are numbered in order of their smallest vertex, which is the first one encountered here.
+        // The number replaces the basis slot of the root, marked by a rank above any reachable one.
+        const uint8_t numbered = std::numeric_limits<uint8_t>::max();
+        position_type position;
+        for (size_t curr_vertex = 0; curr_vertex < num_vertices; curr_vertex++)
+        {
+            Index root = find_root(Index(curr_vertex), position);
+            if (rank[root] != numbered)
+            {
+                ComponentInfo new_comp;
+                new_comp.component_index = component_info.size();
+                new_comp.percolation_dim = (basis_index[root] == no_basis ? 0 : lattice_bases[basis_index[root]].size());
+                component_info.push_back(new_comp);
+                component_size.push_back(0);
+
+                rank[root] = numbered;
+                basis_index[root] = Index(new_comp.component_index);
+            }
+            component_size[basis_index[root]]++;
+        }
+
+        for (size_t c = 0; c < component_info.size(); c++)
+        {
+            component_info[c].vertices.reserve(component_size[c]);
+        }
+        // All paths have been compressed above, so the parent is the root
+        for (size_t curr_vertex = 0; curr_vertex < num_vertices; curr_vertex++)
+        {
+            VertexData vertex;
+            vertex.index = curr_vertex;
+            component_info[basis_index[parent[curr_vertex]]].vertices.push_back(vertex);
+        }
+        return component_info;
+    }
+
+    template <size_t Dim, typename Index>
+    Index BasicCompactUnionFind<Dim, Index>::find_root(Index vertex_index, position_type &position)
+    {
+        // Find the root and the accumulated translation along the way
+        Index root = vertex_index;
+        position = position_type::zero();
+        while (parent[root] != root)
+        {
+            position = position + position_type(parent_offset[root]);
+            root = parent[root];
+        }
+
+        // Point every vertex on the path directly to the root
+        position_type remaining = position;
+        Index curr_vertex = vertex_index;
+        while (curr_vertex != root)
+        {
+            Index next_vertex = parent[curr_vertex];
+            position_type curr_offset = position_type(parent_offset[curr_vertex]);
+
+            parent[curr_vertex] = root;
+            parent_offset[curr_vertex] = BasicTranslationVector<Dim, offset_type>(remaining);
+
+            remaining = remaining - curr_offset;
+            curr_vertex = next_vertex;
+        }
+        return root;
+    }
+
+    template <size_t Dim, typename Index>
+    void BasicCompactUnionFind<Dim, Index>::add_lattice_vector(Index root, const position_type &lattice_vector)
+    {
+        const Index no_basis = std::numeric_limits<Index>::max();
+        Index &index = basis_index[root];
+        if (index != no_basis)
+        {
+            lattice_bases[index].insert(lattice_vector);
+            return;
+        }
+
+        // Only components with a non-zero lattice vector occupy an entry
+        basis_type new_basis;
+        if (!new_basis.insert(lattice_vector))
+        {
+            return;
+        }
+
+        if (free_bases.empty())
+        {
+            index = Index(lattice_bases.size());
+            lattice_bases.push_back(new_basis);
+        }
+        else
+        {
+            index = free_bases.back();
+            free_bases.pop_back();
+            lattice_bases[index] = new_basis;
+        }
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    bool BasicCompactPercolationGraph<Dim, TranslationBits, Index>::reserve_vertices(size_t num_vertices)
+    {
+        if (num_vertices > 0 && num_vertices - 1 > size_t(std::numeric_limits<Index>::max()))
+        {
+            return false;
+        }
+        this->num_vertices = (num_vertices > this->num_vertices ? num_vertices : this->num_vertices);
+        return true;
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    void BasicCompactPercolationGraph<Dim, TranslationBits, Index>::reserve_edges(size_t num_edges)
+    {
+        edge_base.reserve(num_edges);
+        edge_head.reserve(num_edges);
+        edge_translation.reserve(num_edges);
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    void BasicCompactPercolationGraph<Dim, TranslationBits, Index>::reset()
+    {
+        num_vertices = 0;
+        edge_base.clear();
+        edge_head.clear();
+        edge_translation.clear();
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    size_t BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_num_vertices() const
+    {
+        return num_vertices;
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    size_t BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_num_edges() const
+    {
+        return edge_base.size();
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    size_t BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_edge_memory() const
+    {
+        return edge_base.size() * (2 * sizeof(Index) + sizeof(packed_translation_type));
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    void BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_edge(size_t edge_index, size_t &vertex_index_base, size_t &vertex_index_head, translation_type &edge_trans) const
+    {
+        vertex_index_base = edge_base[edge_index];
+        vertex_index_head = edge_head[edge_index];
+        edge_trans = edge_translation[edge_index].template unpack<coordinate_type>();
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    std::vector<ComponentInfo> BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_component_percolation_info() const
+    {
+        analysis_graph_type analysis_graph;
+        return get_component_percolation_info(analysis_graph);
+    }
+
+    template <size_t Dim, unsigned TranslationBits, typename Index>
+    std::vector<ComponentInfo> BasicCompactPercolationGraph<Dim, TranslationBits, Index>::get_component_percolation_info(analysis_graph_type &analysis_graph) const
+    {
+        analysis_graph.reset(num_vertices);
+
+        // Each edge is read once in storage order, the union-find does not need the inverse direction
+        const size_t num_edges = edge_base.size();
+        for (size_t e = 0; e < num_edges; e++)
+        {
+            analysis_graph.add_edge(edge_base[e], edge_head[e], edge_translation[e].template unpack<int64_t>());
+        }
+        return analysis_graph.get_component_percolation_info();
+    }
+
+    template class BasicCompactUnionFind<2, uint32_t>;
+    template class BasicCompactUnionFind<3, uint32_t>;
+    template class BasicCompactUnionFind<3, uint64_t>;
+
+    template class BasicCompactPercolationGraph<2, 2, uint32_t>;
+    template class BasicCompactPercolationGraph<3, 2, uint32_t>;
+    template class BasicCompactPercolationGraph<3, 4, uint32_t>;
+    template class BasicCompactPercolationGraph<3, 8, uint32_t>;
+    template class BasicCompactPercolationGraph<3, 2, uint64_t>;
+}
\ No newline at end of file
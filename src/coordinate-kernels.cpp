@@ -0,0 +1,303 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "coordinate-kernels.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define COORDINATE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace mol
+{
+    namespace
+    {
+        static_assert(sizeof(vec<double>) == 3 * sizeof(double), "The kernels read positions as a flat array of coordinates");
+
+        /**
+         * @brief The non-zero entries of a triclinic basis
+         */
+        struct TriclinicBasis
+        {
+            double a_x, b_x, b_y, c_x, c_y, c_z;
+
+            TriclinicBasis(const std::array<vec<double>, 3> &basis)
+                : a_x(basis[0][0]), b_x(basis[1][0]), b_y(basis[1][1]), c_x(basis[2][0]), c_y(basis[2][1]), c_z(basis[2][2]) {}
+        };
+
+        void normalize_positions_scalar(const vec<double> *positions, size_t begin, size_t end, const std::array<vec<double>, 3> &triclinic_basis,
+                                        double *coeff_x, double *coeff_y, double *coeff_z)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                vec<double> coeff = normalize_basis_coefficients(decompose(positions[i], triclinic_basis));
+                coeff_x[i] = coeff.x;
+                coeff_y[i] = coeff.y;
+                coeff_z[i] = coeff.z;
+            }
+        }
+
+        int8_t bond_translation(double base_coeff, double head_coeff)
+        {
+            if (head_coeff - base_coeff > 0.5)
+            {
+                // The shorter connection intersects the cell boundary going down from the base
+                return -1;
+            }
+            if (base_coeff - head_coeff > 0.5)
+            {
+                // The shorter connection intersects the cell boundary going up from the base
+                return +1;
+            }
+            return 0;
+        }
+
+        void compute_bond_translations_scalar(const double *coeff_x, const double *coeff_y, const double *coeff_z, const size_t *bond_base, const size_t *bond_head,
+                                              size_t begin, size_t end, int8_t *trans_x, int8_t *trans_y, int8_t *trans_z)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                trans_x[i] = bond_translation(coeff_x[bond_base[i]], coeff_x[bond_head[i]]);
+                trans_y[i] = bond_translation(coeff_y[bond_base[i]], coeff_y[bond_head[i]]);
+                trans_z[i] = bond_translation(coeff_z[bond_base[i]], coeff_z[bond_head[i]]);
+            }
+        }
+
+#ifdef COORDINATE_KERNELS_X86
+        // The vector kernels perform the same operations in the same order as decompose() and normalize_basis_coefficients(),
+        // so they produce bitwise identical results.
+
+        __attribute__((target("avx2"))) __m256d normalize_avx2(__m256d coeff)
+        {
+            coeff = _mm256_sub_pd(coeff, _mm256_floor_pd(coeff));
+            __m256d upper = _mm256_cmp_pd(coeff, _mm256_set1_pd(0.5), _CMP_GE_OQ);
+            return _mm256_sub_pd(coeff, _mm256_and_pd(upper, _mm256_set1_pd(1.0)));
+        }
+
+        __attribute__((target("avx2"))) void normalize_positions_avx2(const vec<double> *positions, size_t num_positions, const std::array<vec<double>, 3> &triclinic_basis,
+                                                                      double *coeff_x, double *coeff_y, double *coeff_z)
+        {
+            const TriclinicBasis basis(triclinic_basis);
+            const __m256d a_x = _mm256_set1_pd(basis.a_x), b_x = _mm256_set1_pd(basis.b_x), b_y = _mm256_set1_pd(basis.b_y);
+            const __m256d c_x = _mm256_set1_pd(basis.c_x), c_y = _mm256_set1_pd(basis.c_y), c_z = _mm256_set1_pd(basis.c_z);
+
+            // Offsets of the same coordinate of four consecutive positions
+            const __m256i stride = _mm256_setr_epi64x(0, 3, 6, 9);
+            const double *coords = positions[0].pos;
+
+            size_t i = 0;
+            for (; i + 4 <= num_positions; i += 4)
+            {
+                const double *block = coords + 3 * i;
+                __m256d x = _mm256_i64gather_pd(block, stride, 8);
+                __m256d y = _mm256_i64gather_pd(block + 1, stride, 8);
+                __m256d z = _mm256_i64gather_pd(block + 2, stride, 8);
+
+                __m256d f_z = _mm256_div_pd(z, c_z);
+                x = _mm256_sub_pd(x, _mm256_mul_pd(c_x, f_z));
+                y = _mm256_sub_pd(y, _mm256_mul_pd(c_y, f_z));
+                __m256d f_y = _mm256_div_pd(y, b_y);
+                x = _mm256_sub_pd(x, _mm256_mul_pd(b_x, f_y));
+                __m256d f_x = _mm256_div_pd(x, a_x);
+
+                _mm256_storeu_pd(coeff_x + i, normalize_avx2(f_x));
+                _mm256_storeu_pd(coeff_y + i, normalize_avx2(f_y));
+                _mm256_storeu_pd(coeff_z + i, normalize_avx2(f_z));
+            }
+            normalize_positions_scalar(positions, i, num_positions, triclinic_basis, coeff_x, coeff_y, coeff_z);
+        }
+
+        __attribute__((target("avx2"))) void translations_avx2(const double *coeff, __m256i base, __m256i head, int8_t *trans)
+        {
+            __m256d base_coeff = _mm256_i64gather_pd(coeff, base, 8);
+            __m256d head_coeff = _mm256_i64gather_pd(coeff, head, 8);
+            int down = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_sub_pd(head_coeff, base_coeff), _mm256_set1_pd(0.5), _CMP_GT_OQ));
+            int up = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_sub_pd(base_coeff, head_coeff), _mm256_set1_pd(0.5), _CMP_GT_OQ));
+            for (int lane = 0; lane < 4; lane++)
+            {
+                trans[lane] = int8_t(((up >> lane) & 1) - ((down >> lane) & 1));
+            }
+        }
+
+        __attribute__((target("avx2"))) void compute_bond_translations_avx2(const double *coeff_x, const double *coeff_y, const double *coeff_z, const size_t *bond_base, const size_t *bond_head,
+                                                                            size_t num_bonds, int8_t *trans_x, int8_t *trans_y, int8_t *trans_z)
+        {
+            size_t i = 0;
+            for (; i + 4 <= num_bonds; i += 4)
+            {
+                __m256i base = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bond_base + i));
+                __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bond_head + i));
+                translations_avx2(coeff_x, base, head, trans_x + i);
+                translations_avx2(coeff_y, base, head, trans_y + i);
+                translations_avx2(coeff_z, base, head, trans_z + i);
+            }
+            compute_bond_translations_scalar(coeff_x, coeff_y, coeff_z, bond_base, bond_head, i, num_bonds, trans_x, trans_y, trans_z);
+        }
+
+        // The masked forms of the AVX-512 intrinsics are used with a full mask, as the unmasked ones trigger
+        // false uninitialized warnings in some GCC versions
+
+        __attribute__((target("avx512f"))) __m512d normalize_avx512(__m512d coeff)
+        {
+            coeff = _mm512_sub_pd(coeff, _mm512_mask_roundscale_pd(coeff, 0xFF, coeff, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+            __mmask8 upper = _mm512_cmp_pd_mask(coeff, _mm512_set1_pd(0.5), _CMP_GE_OQ);
+            return _mm512_mask_sub_pd(coeff, upper, coeff, _mm512_set1_pd(1.0));
+        }
+
+        __attribute__((target("avx512f"))) void normalize_positions_avx512(const vec<double> *positions, size_t num_positions, const std::array<vec<double>, 3> &triclinic_basis,
+                                                                           double *coeff_x, double *coeff_y, double *coeff_z)
+        {
+            const TriclinicBasis basis(triclinic_basis);
+            const __m512d a_x = _mm512_set1_pd(basis.a_x), b_x = _mm512_set1_pd(basis.b_x), b_y = _mm512_set1_pd(basis.b_y);
+            const __m512d c_x = _mm512_set1_pd(basis.c_x), c_y = _mm512_set1_pd(basis.c_y), c_z = _mm512_set1_pd(basis.c_z);
+
+            // Offsets of the same coordinate of eight consecutive positions
+            const __m512i stride = _mm512_setr_epi64(0, 3, 6, 9, 12, 15, 18, 21);
+            const double *coords = positions[0].pos;
+
+            size_t i = 0;
+            for (; i + 8 <= num_positions; i += 8)
+            {
+                const double *block = coords + 3 * i;
+                __m512d x = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, stride, block, 8);
+                __m512d y = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, stride, block + 1, 8);
+                __m512d z = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, stride, block + 2, 8);
+
+                __m512d f_z = _mm512_div_pd(z, c_z);
+                x = _mm512_sub_pd(x, _mm512_mul_pd(c_x, f_z));
+                y = _mm512_sub_pd(y, _mm512_mul_pd(c_y, f_z));
+                __m512d f_y = _mm512_div_pd(y, b_y);
+                x = _mm512_sub_pd(x, _mm512_mul_pd(b_x, f_y));
+                __m512d f_x = _mm512_div_pd(x, a_x);
+
+                _mm512_storeu_pd(coeff_x + i, normalize_avx512(f_x));
+                _mm512_storeu_pd(coeff_y + i, normalize_avx512(f_y));
+                _mm512_storeu_pd(coeff_z + i, normalize_avx512(f_z));
+            }
+            normalize_positions_scalar(positions, i, num_positions, triclinic_basis, coeff_x, coeff_y, coeff_z);
+        }
+
+        __attribute__((target("avx512f"))) void translations_avx512(const double *coeff, __m512i base, __m512i head, int8_t *trans)
+        {
+            __m512d base_coeff = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, base, coeff, 8);
+            __m512d head_coeff = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, head, coeff, 8);
+            __mmask8 down = _mm512_cmp_pd_mask(_mm512_sub_pd(head_coeff, base_coeff), _mm512_set1_pd(0.5), _CMP_GT_OQ);
+            __mmask8 up = _mm512_cmp_pd_mask(_mm512_sub_pd(base_coeff, head_coeff), _mm512_set1_pd(0.5), _CMP_GT_OQ);
+            for (int lane = 0; lane < 8; lane++)
+            {
+                trans[lane] = int8_t(((up >> lane) & 1) - ((down >> lane) & 1));
+            }
+        }
+
+        __attribute__((target("avx512f"))) void compute_bond_translations_avx512(const double *coeff_x, const double *coeff_y, const double *coeff_z, const size_t *bond_base, const size_t *bond_head,
+                                                                                 size_t num_bonds, int8_t *trans_x, int8_t *trans_y, int8_t *trans_z)
+        {
+            size_t i = 0;
+            for (; i + 8 <= num_bonds; i += 8)
+            {
+                __m512i base = _mm512_loadu_si512(bond_base + i);
+                __m512i head = _mm512_loadu_si512(bond_head + i);
+                translations_avx512(coeff_x, base, head, trans_x + i);
+                translations_avx512(coeff_y, base, head, trans_y + i);
+                translations_avx512(coeff_z, base, head, trans_z + i);
+            }
+            compute_bond_translations_scalar(coeff_x, coeff_y, coeff_z, bond_base, bond_head, i, num_bonds, trans_x, trans_y, trans_z);
+        }
+#endif
+    }
+
+    KernelLevel get_supported_kernel_level()
+    {
+#ifdef COORDINATE_KERNELS_X86
+        static const KernelLevel supported_level = []() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+            {
+                return KernelLevel::avx512;
+            }
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return KernelLevel::avx2;
+            }
+            return KernelLevel::scalar;
+        }();
+        return supported_level;
+#else
+        return KernelLevel::scalar;
+#endif
+    }
+
+    void normalize_positions(const vec<double> *positions, size_t num_positions, const std::array<vec<double>, 3> &triclinic_basis,
+                             double *coeff_x, double *coeff_y, double *coeff_z, KernelLevel level)
+    {
+        if (num_positions == 0)
+        {
+            return;
+        }
+        switch (level)
+        {
+#ifdef COORDINATE_KERNELS_X86
+        case KernelLevel::avx512:
+            normalize_positions_avx512(positions, num_positions, triclinic_basis, coeff_x, coeff_y, coeff_z);
+            break;
+        case KernelLevel::avx2:
+            normalize_positions_avx2(positions, num_positions, triclinic_basis, coeff_x, coeff_y, coeff_z);
+            break;
+#endif
+        default:
+            normalize_positions_scalar(positions, 0, num_positions, triclinic_basis, coeff_x, coeff_y, coeff_z);
+            break;
+        }
+    }
+
+    void normalize_positions(const vec<double> *positions, size_t num_positions, const std::vector<vec<double>> &triclinic_basis,
+                             double *coeff_x, double *coeff_y, double *coeff_z, KernelLevel level)
+    {
+        const std::array<vec<double>, 3> basis = {triclinic_basis[0], triclinic_basis[1], triclinic_basis[2]};
+        normalize_positions(positions, num_positions, basis, coeff_x, coeff_y, coeff_z, level);
+    }
+
+    void compute_bond_translations(const double *coeff_x, const double *coeff_y, const double *coeff_z, const size_t *bond_base, const size_t *bond_head,
+                                   size_t num_bonds, int8_t *trans_x, int8_t *trans_y, int8_t *trans_z, KernelLevel level)
+    {
+        switch (level)
+        {
+#ifdef COORDINATE_KERNELS_X86
+        case KernelLevel::avx512:
+            compute_bond_translations_avx512(coeff_x, coeff_y, coeff_z, bond_base, bond_head, num_bonds, trans_x, trans_y, trans_z);
+            break;
+        case KernelLevel::avx2:
+            compute_bond_translations_avx2(coeff_x, coeff_y, coeff_z, bond_base, bond_head, num_bonds, trans_x, trans_y, trans_z);
+            break;
+#endif
+        default:
+            compute_bond_translations_scalar(coeff_x, coeff_y, coeff_z, bond_base, bond_head, 0, num_bonds, trans_x, trans_y, trans_z);
+            break;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,690 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "dynamic-percolation.hpp"
+
+namespace percolation
+{
+    namespace
+    {
+        const size_t no_lattice = (size_t)-1;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::reserve_vertices(size_t num_vertices)
+    {
+        if (this->vertices.size() >= num_vertices)
+        {
+            return true;
+        }
+        size_t curr_size = this->vertices.size();
+        this->vertices.resize(num_vertices);
+        this->adjacency.resize(num_vertices);
+        this->component_of.resize(num_vertices);
+        this->tree_parent.resize(num_vertices);
+        this->tree_translation.resize(num_vertices, translation_type::zero());
+        this->positions.resize(num_vertices, position_type::zero());
+        this->component_slot.resize(num_vertices, 0);
+        this->visit_stamp.resize(num_vertices, 0);
+        for (size_t i = curr_size; i < num_vertices; i++)
+        {
+            this->vertices[i].index = i;
+            this->tree_parent[i] = i;
+
+            size_t new_component = allocate_component();
+            component_of[i] = new_component;
+            components[new_component].vertices.push_back(i);
+        }
+        num_components += num_vertices - curr_size;
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::add_vertex(size_t vertex_index, const VertexData &vertex_data)
+    {
+        if (!reserve_vertices(vertex_index + 1))
+        {
+            return false;
+        }
+        vertices[vertex_index] = vertex_data;
+        vertices[vertex_index].index = vertex_index;
+
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data)
+    {
+        size_t max_index = (vertex_index_base > vertex_index_head ? vertex_index_base : vertex_index_head);
+        if (!reserve_vertices(max_index + 1))
+        {
+            return false;
+        }
+
+        // Merging and cycle checks rely on valid trees and positions
+        update_components();
+
+        adjacency[vertex_index_base].push_back({vertex_index_head, edge_data});
+        if (vertex_index_base != vertex_index_head)
+        {
+            adjacency[vertex_index_head].push_back({vertex_index_base, edge_data.inverse()});
+        }
+
+        size_t base_component = component_of[vertex_index_base];
+        size_t head_component = component_of[vertex_index_head];
+
+        if (base_component == head_component)
+        {
+            // The edge closes a cycle within the component
+            add_cycle(base_component, {vertex_index_base, vertex_index_head, edge_data});
+            return true;
+        }
+
+        // Attach the tree of the smaller component to the larger one via the new edge
+        size_t new_component = base_component;
+        size_t child_component = head_component;
+        if (components[base_component].vertices.size() >= components[head_component].vertices.size())
+        {
+            attach_tree(vertex_index_base, vertex_index_head, edge_data.translation);
+        }
+        else
+        {
+            new_component = head_component;
+            child_component = base_component;
+            attach_tree(vertex_index_head, vertex_index_base, edge_data.inverse().translation);
+        }
+
+        Component &parent_comp = components[new_component];
+        Component &child_comp = components[child_component];
+
+        // Move the smaller component so that the positions agree with the new edge
+        position_type child_shift = positions[vertex_index_base] + position_type(edge_data.translation) - positions[vertex_index_head];
+        if (new_component != base_component)
+        {
+            child_shift = -child_shift;
+        }
+        size_t first_slot = parent_comp.vertices.size();
+        for (size_t i = 0; i < child_comp.vertices.size(); i++)
+        {
+            size_t curr_vertex = child_comp.vertices[i];
+            positions[curr_vertex] = positions[curr_vertex] + child_shift;
+            component_of[curr_vertex] = new_component;
+            component_slot[curr_vertex] = first_slot + i;
+        }
+        parent_comp.vertices.insert(parent_comp.vertices.end(), child_comp.vertices.begin(), child_comp.vertices.end());
+        child_comp.vertices.clear();
+
+        // Lattice vectors do not depend on the reference vertex, so the cycles of the absorbed component carry over
+        if (child_comp.lattice_index != no_lattice)
+        {
+            Lattice child_lattice = lattices[child_comp.lattice_index];
+            release_lattice(child_comp);
+            for (size_t i = 0; i < child_lattice.basis.size(); i++)
+            {
+                add_cycle(new_component, child_lattice.witnesses[i]);
+            }
+        }
+
+        free_components.push_back(child_component);
+        num_components--;
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        return add_edge(vertex_index_base, vertex_index_head, edge_data_type(edge_trans));
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::remove_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data)
+    {
+        if (vertex_index_base >= vertices.size() || vertex_index_head >= vertices.size())
+        {
+            return false;
+        }
+
+        const translation_type &trans = edge_data.translation;
+        const translation_type inverse_trans = -trans;
+        bool is_loop = (vertex_index_base == vertex_index_head);
+
+        // Self-loops are only stored once, in whatever direction they have been added
+        std::vector<AdjacencyEntry> &base_edges = adjacency[vertex_index_base];
+        size_t num_copies = 0;
+        size_t entry_index = 0;
+        for (size_t i = 0; i < base_edges.size(); i++)
+        {
+            if (base_edges[i].head == vertex_index_head && (base_edges[i].data.translation == trans || (is_loop && base_edges[i].data.translation == inverse_trans)))
+            {
+                entry_index = i;
+                num_copies++;
+            }
+        }
+        if (num_copies == 0)
+        {
+            return false;
+        }
+
+        base_edges[entry_index] = base_edges.back();
+        base_edges.pop_back();
+        if (!is_loop)
+        {
+            std::vector<AdjacencyEntry> &head_edges = adjacency[vertex_index_head];
+            for (size_t i = 0; i < head_edges.size(); i++)
+            {
+                if (head_edges[i].head == vertex_index_base && head_edges[i].data.translation == inverse_trans)
+                {
+                    head_edges[i] = head_edges.back();
+                    head_edges.pop_back();
+                    break;
+                }
+            }
+        }
+
+        if (num_copies > 1)
+        {
+            // An identical copy takes over the role of the removed edge in the tree or as a witness
+            return true;
+        }
+
+        if (is_tree_edge(vertex_index_base, {vertex_index_head, edge_data}))
+        {
+            if (tree_parent[vertex_index_head] == vertex_index_base && tree_translation[vertex_index_head] == trans)
+            {
+                remove_tree_edge(vertex_index_base, vertex_index_head);
+            }
+            else
+            {
+                remove_tree_edge(vertex_index_head, vertex_index_base);
+            }
+            return true;
+        }
+
+        size_t component_index = component_of[vertex_index_base];
+        Component &component = components[component_index];
+        if (component.needs_lattice || component.lattice_index == no_lattice)
+        {
+            return true;
+        }
+
+        // Removing a non-tree edge only matters if its cycle contributed to the lattice
+        const Lattice &lattice = lattices[component.lattice_index];
+        for (size_t i = 0; i < lattice.basis.size(); i++)
+        {
+            const edge_type &witness = lattice.witnesses[i];
+            bool same_direction = (witness.base == vertex_index_base && witness.head == vertex_index_head && witness.data.translation == trans);
+            bool opposite_direction = (witness.base == vertex_index_head && witness.head == vertex_index_base && witness.data.translation == inverse_trans);
+            if (same_direction || opposite_direction)
+            {
+                invalidate_lattice(component_index);
+                break;
+            }
+        }
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::remove_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        return remove_edge(vertex_index_base, vertex_index_head, edge_data_type(edge_trans));
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::apply_bond_delta(const std::vector<edge_type> &added, const std::vector<edge_type> &removed)
+    {
+        bool all_applied = true;
+        for (const edge_type &edge : removed)
+        {
+            all_applied = remove_edge(edge.base, edge.head, edge.data) && all_applied;
+        }
+
+        update_components();
+
+        for (const edge_type &edge : added)
+        {
+            all_applied = add_edge(edge.base, edge.head, edge.data) && all_applied;
+        }
+        return all_applied;
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicDynamicPercolationGraph<Dim, Coord>::get_percolation_dim(size_t vertex_index)
+    {
+        if (vertex_index >= vertices.size())
+        {
+            return 0;
+        }
+        update_components();
+
+        return get_lattice_dim(component_of[vertex_index]);
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicDynamicPercolationGraph<Dim, Coord>::get_num_components()
+    {
+        update_components();
+        return num_components;
+    }
+
+    template <size_t Dim, typename Coord>
+    std::vector<ComponentInfo> BasicDynamicPercolationGraph<Dim, Coord>::get_component_percolation_info()
+    {
+        update_components();
+
+        std::vector<ComponentInfo> component_info;
+        component_info.reserve(num_components);
+
+        // Components are numbered in order of their smallest vertex, which is the first one encountered here
+        std::vector<size_t> output_index(components.size(), (size_t)-1);
+
+        for (size_t curr_vertex = 0; curr_vertex < vertices.size(); curr_vertex++)
+        {
+            size_t component_index = component_of[curr_vertex];
+            if (output_index[component_index] == (size_t)-1)
+            {
+                output_index[component_index] = component_info.size();
+
+                const Component &component = components[component_index];
+                ComponentInfo new_comp;
+                new_comp.component_index = component_info.size();
+                new_comp.percolation_dim = get_lattice_dim(component_index);
+                new_comp.vertices.reserve(component.vertices.size());
+                component_info.push_back(new_comp);
+            }
+            component_info[output_index[component_index]].vertices.push_back(vertices[curr_vertex]);
+        }
+        return component_info;
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicDynamicPercolationGraph<Dim, Coord>::allocate_component()
+    {
+        size_t component_index = components.size();
+        if (free_components.empty())
+        {
+            components.emplace_back();
+        }
+        else
+        {
+            component_index = free_components.back();
+            free_components.pop_back();
+        }
+
+        Component &component = components[component_index];
+        component.vertices.clear();
+        component.lattice_index = no_lattice;
+        component.needs_lattice = false;
+        return component_index;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::release_lattice(Component &component)
+    {
+        if (component.lattice_index != no_lattice)
+        {
+            free_lattices.push_back(component.lattice_index);
+            component.lattice_index = no_lattice;
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::add_cycle(size_t component_index, const edge_type &witness)
+    {
+        position_type cycle = positions[witness.base] + position_type(witness.data.translation) - positions[witness.head];
+
+        size_t &lattice_index = components[component_index].lattice_index;
+        if (lattice_index != no_lattice)
+        {
+            Lattice &lattice = lattices[lattice_index];
+            size_t num_vectors = lattice.basis.size();
+            if (lattice.basis.insert(cycle))
+            {
+                lattice.witnesses[num_vectors] = witness;
+            }
+            return;
+        }
+
+        // Only components with a non-zero cycle occupy an entry
+        Lattice new_lattice;
+        if (!new_lattice.basis.insert(cycle))
+        {
+            return;
+        }
+        new_lattice.witnesses[0] = witness;
+
+        if (free_lattices.empty())
+        {
+            lattice_index = lattices.size();
+            lattices.push_back(new_lattice);
+        }
+        else
+        {
+            lattice_index = free_lattices.back();
+            free_lattices.pop_back();
+            lattices[lattice_index] = new_lattice;
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::attach_tree(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        // Reverse the parent pointers on the path from the head vertex to its root
+        size_t prev_vertex = vertex_index_base;
+        translation_type prev_trans = edge_trans;
+        size_t curr_vertex = vertex_index_head;
+        while (true)
+        {
+            size_t next_vertex = tree_parent[curr_vertex];
+            translation_type next_trans = tree_translation[curr_vertex];
+
+            tree_parent[curr_vertex] = prev_vertex;
+            tree_translation[curr_vertex] = prev_trans;
+            if (next_vertex == curr_vertex)
+            {
+                break;
+            }
+
+            prev_vertex = curr_vertex;
+            prev_trans = -next_trans;
+            curr_vertex = next_vertex;
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicDynamicPercolationGraph<Dim, Coord>::get_lattice_dim(size_t component_index) const
+    {
+        size_t lattice_index = components[component_index].lattice_index;
+        return (lattice_index == no_lattice ? 0 : lattices[lattice_index].basis.size());
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::invalidate_lattice(size_t component_index)
+    {
+        Component &component = components[component_index];
+        if (!component.needs_lattice)
+        {
+            dirty_components.push_back(component_index);
+            component.needs_lattice = true;
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicDynamicPercolationGraph<Dim, Coord>::is_tree_edge(size_t vertex_index, const AdjacencyEntry &entry) const
+    {
+        if (entry.head == vertex_index)
+        {
+            return false;
+        }
+        return (tree_parent[entry.head] == vertex_index && tree_translation[entry.head] == entry.data.translation) || (tree_parent[vertex_index] == entry.head && tree_translation[vertex_index] == -entry.data.translation);
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::remove_tree_edge(size_t vertex_index_parent, size_t vertex_index_child)
+    {
+        size_t component_index = component_of[vertex_index_child];
+        tree_parent[vertex_index_child] = vertex_index_child;
+        tree_translation[vertex_index_child] = translation_type::zero();
+
+        // Side 0 is the detached subtree of the child, side 1 the rest of the tree. Both are searched along tree edges 
+        // one vertex at a time, so the work is bounded by the smaller side unless a replacement edge turns up earlier.
+        curr_stamp += 2;
+        const size_t side_stamp[2] = {curr_stamp - 1, curr_stamp};
+        const size_t start_vertex[2] = {vertex_index_child, vertex_index_parent};
+        size_t queue_index[2] = {0, 0};
+        for (size_t side = 0; side < 2; side++)
+        {
+            search_queues[side].clear();
+            search_queues[side].push_back(start_vertex[side]);
+            visit_stamp[start_vertex[side]] = side_stamp[side];
+        }
+
+        size_t exhausted_side = 2;
+        while (exhausted_side == 2)
+        {
+            for (size_t side = 0; side < 2; side++)
+            {
+                std::vector<size_t> &queue = search_queues[side];
+                if (queue_index[side] == queue.size())
+                {
+                    exhausted_side = side;
+                    break;
+                }
+
+                size_t curr_vertex = queue[queue_index[side]++];
+                for (const AdjacencyEntry &entry : adjacency[curr_vertex])
+                {
+                    if (is_tree_edge(curr_vertex, entry))
+                    {
+                        if (visit_stamp[entry.head] != side_stamp[side])
+                        {
+                            visit_stamp[entry.head] = side_stamp[side];
+                            queue.push_back(entry.head);
+                        }
+                    }
+                    else if (positions[curr_vertex] + position_type(entry.data.translation) == positions[entry.head] && find_tree_side(entry.head, side_stamp) != side)
+                    {
+                        // An edge between the sides with a zero cycle replaces the removed edge without changing any position or cycle
+                        reconnect_tree(curr_vertex, entry, side == 0);
+                        return;
+                    }
+                }
+            }
+        }
+
+        // All edges between the two sides start at the exhausted side
+        const std::vector<size_t> &piece = search_queues[exhausted_side];
+        size_t replacement_vertex = vertices.size();
+        AdjacencyEntry replacement_entry;
+        for (size_t curr_vertex : piece)
+        {
+            for (const AdjacencyEntry &entry : adjacency[curr_vertex])
+            {
+                if (visit_stamp[entry.head] == side_stamp[exhausted_side])
+                {
+                    continue;
+                }
+                if (positions[curr_vertex] + position_type(entry.data.translation) == positions[entry.head])
+                {
+                    reconnect_tree(curr_vertex, entry, exhausted_side == 0);
+                    return;
+                }
+                if (replacement_vertex == vertices.size())
+                {
+                    replacement_vertex = curr_vertex;
+                    replacement_entry = entry;
+                }
+            }
+        }
+
+        if (replacement_vertex == vertices.size())
+        {
+            split_component(component_index, piece, side_stamp[exhausted_side]);
+            return;
+        }
+
+        // The replacement edge wraps around the periodic system, shift the exhausted side by its cycle to close it
+        position_type shift = positions[replacement_entry.head] - position_type(replacement_entry.data.translation) - positions[replacement_vertex];
+        for (size_t curr_vertex : piece)
+        {
+            positions[curr_vertex] = positions[curr_vertex] + shift;
+        }
+        reconnect_tree(replacement_vertex, replacement_entry, exhausted_side == 0);
+
+        Component &component = components[component_index];
+        if (component.needs_lattice || component.lattice_index == no_lattice)
+        {
+            return;
+        }
+
+        // Only the cycles of edges between the sides have changed and they all start at the shifted side. 
+        // The new lattice is a sublattice of the old one, so it is complete once it has the old dimension again.
+        Lattice prev_lattice = lattices[component.lattice_index];
+        size_t prev_dim = prev_lattice.basis.size();
+        release_lattice(component);
+        for (size_t i = 0; i < prev_dim; i++)
+        {
+            add_cycle(component_index, prev_lattice.witnesses[i]);
+        }
+        for (size_t curr_vertex : piece)
+        {
+            for (const AdjacencyEntry &entry : adjacency[curr_vertex])
+            {
+                if (get_lattice_dim(component_index) == prev_dim)
+                {
+                    return;
+                }
+                add_cycle(component_index, {curr_vertex, entry.head, entry.data});
+            }
+        }
+        if (get_lattice_dim(component_index) < prev_dim)
+        {
+            // Some of the old cycles may have come from edges that are not connected to the shifted side
+            invalidate_lattice(component_index);
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicDynamicPercolationGraph<Dim, Coord>::find_tree_side(size_t vertex_index, const size_t (&side_stamp)[2]) const
+    {
+        // The start of the detached subtree is marked, so an unmarked root is the root of the rest of the tree
+        size_t curr_vertex = vertex_index;
+        while (true)
+        {
+            if (visit_stamp[curr_vertex] == side_stamp[0])
+            {
+                return 0;
+            }
+            if (visit_stamp[curr_vertex] == side_stamp[1] || tree_parent[curr_vertex] == curr_vertex)
+            {
+                return 1;
+            }
+            curr_vertex = tree_parent[curr_vertex];
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::reconnect_tree(size_t vertex_index, const AdjacencyEntry &entry, bool vertex_detached)
+    {
+        // Reroot the detached subtree at its end of the edge, so the root of the component stays the same
+        if (vertex_detached)
+        {
+            attach_tree(entry.head, vertex_index, -entry.data.translation);
+        }
+        else
+        {
+            attach_tree(vertex_index, entry.head, entry.data.translation);
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::split_component(size_t component_index, const std::vector<size_t> &piece, size_t piece_stamp)
+    {
+        size_t piece_index = allocate_component();
+        num_components++;
+
+        std::vector<size_t> &rest_vertices = components[component_index].vertices;
+        std::vector<size_t> &piece_vertices = components[piece_index].vertices;
+        for (size_t curr_vertex : piece)
+        {
+            size_t last_vertex = rest_vertices.back();
+            rest_vertices[component_slot[curr_vertex]] = last_vertex;
+            component_slot[last_vertex] = component_slot[curr_vertex];
+            rest_vertices.pop_back();
+
+            component_of[curr_vertex] = piece_index;
+            component_slot[curr_vertex] = piece_vertices.size();
+            piece_vertices.push_back(curr_vertex);
+        }
+
+        for (size_t curr_vertex : piece)
+        {
+            for (const AdjacencyEntry &entry : adjacency[curr_vertex])
+            {
+                add_cycle(piece_index, {curr_vertex, entry.head, entry.data});
+            }
+        }
+
+        Component &component = components[component_index];
+        if (component.needs_lattice || component.lattice_index == no_lattice)
+        {
+            return;
+        }
+
+        // There are no edges between the two parts, so the witnesses of the rest are still valid.
+        // They span its lattice only if none of the old dimensions came from the piece.
+        Lattice prev_lattice = lattices[component.lattice_index];
+        size_t prev_dim = prev_lattice.basis.size();
+        release_lattice(component);
+        for (size_t i = 0; i < prev_dim; i++)
+        {
+            if (visit_stamp[prev_lattice.witnesses[i].base] != piece_stamp)
+            {
+                add_cycle(component_index, prev_lattice.witnesses[i]);
+            }
+        }
+        if (get_lattice_dim(component_index) < prev_dim)
+        {
+            invalidate_lattice(component_index);
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::rebuild_lattice(size_t component_index)
+    {
+        components[component_index].needs_lattice = false;
+        release_lattice(components[component_index]);
+
+        for (size_t curr_vertex : components[component_index].vertices)
+        {
+            for (const AdjacencyEntry &entry : adjacency[curr_vertex])
+            {
+                add_cycle(component_index, {curr_vertex, entry.head, entry.data});
+            }
+        }
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicDynamicPercolationGraph<Dim, Coord>::update_components()
+    {
+        for (size_t component_index : dirty_components)
+        {
+            if (components[component_index].needs_lattice)
+            {
+                rebuild_lattice(component_index);
+            }
+        }
+        dirty_components.clear();
+    }
+
+    template class BasicDynamicPercolationGraph<2, int8_t>;
+    template class BasicDynamicPercolationGraph<2, int32_t>;
+    template class BasicDynamicPercolationGraph<2, int64_t>;
+    template class BasicDynamicPercolationGraph<3, int8_t>;
+    template class BasicDynamicPercolationGraph<3, int32_t>;
+    template class BasicDynamicPercolationGraph<3, int64_t>;
+}
\ No newline at end of file
@@ -0,0 +1,361 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "frame-analysis.hpp"
+#include "thread-pool.hpp"
+#include "bounded-queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace mol
+{
+    namespace
+    {
+        /**
+         * @brief Buffers kept by each thread and reused for all of its frames
+         */
+        struct FrameWorker
+        {
+            MolecularGraph frame;
+            percolation::PercolationGraph graph;
+            ConversionWorkspace conversion;
+            percolation::PercolationGraph::AnalysisWorkspace analysis;
+        };
+
+        void analyze_graph(const percolation::PercolationGraph &graph, size_t frame_index, percolation::PercolationGraph::AnalysisWorkspace &analysis, FrameResult &result)
+        {
+            result.frame_index = frame_index;
+            result.components = graph.get_component_percolation_info(analysis);
+            result.max_percolation_dim = 0;
+            for (const percolation::ComponentInfo &component : result.components)
+            {
+                result.max_percolation_dim = (component.percolation_dim > result.max_percolation_dim ? component.percolation_dim : result.max_percolation_dim);
+            }
+        }
+
+        void analyze_frame(const MolecularGraph &frame, size_t frame_index, FrameWorker &worker, FrameResult &result)
+        {
+            frame.fill_percolation_graph(worker.graph, worker.conversion);
+            analyze_graph(worker.graph, frame_index, worker.analysis, result);
+        }
+
+        /**
+         * @brief A frame on its way through the pipeline, recycled once its result has been written
+         */
+        struct PipelineFrame
+        {
+            int64_t timestep;
+            MolecularGraph frame;
+            percolation::PercolationGraph graph;
+            FrameResult result;
+        };
+        using PipelineFramePtr = std::unique_ptr<PipelineFrame>;
+    }
+
+    std::vector<FrameResult> analyze_frames(size_t num_frames, const FrameProvider &provider, const FrameAnalysisOptions &options)
+    {
+        std::vector<FrameResult> results(num_frames);
+        std::vector<FrameWorker> workers(percolation::resolve_thread_count(options.num_threads));
+
+        percolation::parallel_for_dynamic(num_frames, workers.size(), 1, [&](size_t frame_index, size_t thread_index) {
+            FrameWorker &worker = workers[thread_index];
+            worker.frame.clear_bonds();
+            provider(frame_index, worker.frame);
+            analyze_frame(worker.frame, frame_index, worker, results[frame_index]);
+        });
+
+        return results;
+    }
+
+    std::vector<FrameResult> analyze_frames(const std::vector<MolecularGraph> &frames, const FrameAnalysisOptions &options)
+    {
+        std::vector<FrameResult> results(frames.size());
+        std::vector<FrameWorker> workers(percolation::resolve_thread_count(options.num_threads));
+
+        percolation::parallel_for_dynamic(frames.size(), workers.size(), 1, [&](size_t frame_index, size_t thread_index) {
+            analyze_frame(frames[frame_index], frame_index, workers[thread_index], results[frame_index]);
+        });
+
+        return results;
+    }
+
+    size_t run_frame_pipeline(const FrameSource &source, const FrameSink &sink, const PipelineOptions &options)
+    {
+        const size_t num_build_threads = percolation::resolve_thread_count(options.num_build_threads);
+        const size_t num_analysis_threads = percolation::resolve_thread_count(options.num_analysis_threads);
+        const size_t queue_capacity = std::max<size_t>(1, options.queue_capacity);
+
+        // The pool of frame buffers limits the number of frames in flight, including those the writer holds back to restore the order
+        const size_t num_buffers = num_build_threads + num_analysis_threads + 2 * queue_capacity + 1;
+        percolation::BoundedQueue<PipelineFramePtr> free_frames(num_buffers);
+        percolation::BoundedQueue<PipelineFramePtr> build_queue(queue_capacity);
+        percolation::BoundedQueue<PipelineFramePtr> analysis_queue(queue_capacity);
+        percolation::BoundedQueue<PipelineFramePtr> result_queue(queue_capacity);
+        for (size_t b = 0; b < num_buffers; b++)
+        {
+            free_frames.push(PipelineFramePtr(new PipelineFrame()));
+        }
+
+        std::atomic<bool> failed(false);
+        std::exception_ptr first_exception;
+        std::mutex exception_mutex;
+        auto fail = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!first_exception)
+                {
+                    first_exception = std::current_exception();
+                }
+            }
+            failed = true;
+            free_frames.close();
+            build_queue.close();
+            analysis_queue.close();
+            result_queue.close();
+        };
+
+        std::vector<std::thread> threads;
+
+        threads.emplace_back([&]() {
+            try
+            {
+                size_t frame_index = 0;
+                PipelineFramePtr item;
+                while (!failed && free_frames.pop(item))
+                {
+                    item->frame.clear_bonds();
+                    item->timestep = int64_t(frame_index);
+                    if (!source(item->frame, item->timestep))
+                    {
+                        break;
+                    }
+                    item->result.frame_index = frame_index++;
+                    build_queue.push(std::move(item));
+                }
+            }
+            catch (...)
+            {
+                fail();
+            }
+            build_queue.close();
+        });
+
+        std::atomic<size_t> active_build_threads(num_build_threads);
+        for (size_t t = 0; t < num_build_threads; t++)
+        {
+            threads.emplace_back([&]() {
+                try
+                {
+                    ConversionWorkspace conversion;
+                    PipelineFramePtr item;
+                    while (!failed && build_queue.pop(item))
+                    {
+                        if (options.prepare_frame)
+                        {
+                            options.prepare_frame(item->frame);
+                        }
+                        item->frame.fill_percolation_graph(item->graph, conversion);
+                        analysis_queue.push(std::move(item));
+                    }
+                }
+                catch (...)
+                {
+                    fail();
+                }
+                if (--active_build_threads == 0)
+                {
+                    analysis_queue.close();
+                }
+            });
+        }
+
+        std::atomic<size_t> active_analysis_threads(num_analysis_threads);
+        for (size_t t = 0; t < num_analysis_threads; t++)
+        {
+            threads.emplace_back([&]() {
+                try
+                {
+                    percolation::PercolationGraph::AnalysisWorkspace analysis;
+                    PipelineFramePtr item;
+                    while (!failed && analysis_queue.pop(item))
+                    {
+                        analyze_graph(item->graph, item->result.frame_index, analysis, item->result);
+                        result_queue.push(std::move(item));
+                    }
+                }
+                catch (...)
+                {
+                    fail();
+                }
+                if (--active_analysis_threads == 0)
+                {
+                    result_queue.close();
+                }
+            });
+        }
+
+        // Write the results in frame order, holding back frames that overtook earlier ones
+        size_t num_written = 0;
+        try
+        {
+            std::map<size_t, PipelineFramePtr> pending;
+            PipelineFramePtr item;
+            while (!failed && result_queue.pop(item))
+            {
+                size_t frame_index = item->result.frame_index;
+                pending.emplace(frame_index, std::move(item));
+                while (!failed && !pending.empty() && pending.begin()->first == num_written)
+                {
+                    PipelineFramePtr &next = pending.begin()->second;
+                    sink(next->result, next->frame, next->timestep);
+                    free_frames.push(std::move(next));
+                    pending.erase(pending.begin());
+                    num_written++;
+                }
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        if (first_exception)
+        {
+            std::rethrow_exception(first_exception);
+        }
+        return num_written;
+    }
+
+    GelPointResult find_gel_points(size_t num_frames, const FrameProvider &provider, const GelPointOptions &options)
+    {
+        GelPointResult result;
+        result.onset_frames.assign(vector_space_dimension, no_gel_point);
+        result.num_analyzed_frames = 0;
+        if (num_frames == 0)
+        {
+            return result;
+        }
+
+        // Maximum percolation dimension of every frame analyzed so far
+        std::unordered_map<size_t, size_t> known_dims;
+
+        // Sample the trajectory with the coarse stride first. These frames are independent and can be analyzed in parallel
+        std::vector<size_t> samples;
+        if (options.coarse_stride > 1)
+        {
+            for (size_t frame_index = 0; frame_index < num_frames; frame_index += options.coarse_stride)
+            {
+                samples.push_back(frame_index);
+            }
+            if (samples.back() != num_frames - 1)
+            {
+                samples.push_back(num_frames - 1);
+            }
+
+            FrameAnalysisOptions coarse_options;
+            coarse_options.num_threads = options.num_threads;
+            std::vector<FrameResult> coarse_results = analyze_frames(
+                samples.size(), [&](size_t sample_index, MolecularGraph &frame) { provider(samples[sample_index], frame); }, coarse_options);
+
+            for (size_t s = 0; s < samples.size(); s++)
+            {
+                known_dims[samples[s]] = coarse_results[s].max_percolation_dim;
+            }
+            result.num_analyzed_frames += samples.size();
+        }
+        else
+        {
+            samples.push_back(num_frames - 1);
+        }
+
+        FrameWorker worker;
+        FrameResult frame_result;
+        auto get_max_dim = [&](size_t frame_index) {
+            auto known = known_dims.find(frame_index);
+            if (known != known_dims.end())
+            {
+                return known->second;
+            }
+
+            worker.frame.clear_bonds();
+            provider(frame_index, worker.frame);
+            analyze_frame(worker.frame, frame_index, worker, frame_result);
+            known_dims[frame_index] = frame_result.max_percolation_dim;
+            result.num_analyzed_frames++;
+            return frame_result.max_percolation_dim;
+        };
+
+        for (size_t dim = 1; dim <= vector_space_dimension; dim++)
+        {
+            // Find the first sample reaching the dimension. The onset lies between it and the previous sample
+            size_t sample = 0;
+            while (sample < samples.size() && get_max_dim(samples[sample]) < dim)
+            {
+                sample++;
+            }
+            if (sample == samples.size())
+            {
+                // Higher dimensions cannot be reached either
+                break;
+            }
+
+            // Bisect for the first frame in [first, last] reaching the dimension, knowing that last does
+            size_t first = (sample > 0 ? samples[sample - 1] + 1 : 0);
+            size_t last = samples[sample];
+            if (dim > 1)
+            {
+                first = std::max(first, result.onset_frames[dim - 2]);
+            }
+            while (first < last)
+            {
+                size_t middle = first + (last - first) / 2;
+                if (get_max_dim(middle) >= dim)
+                {
+                    last = middle;
+                }
+                else
+                {
+                    first = middle + 1;
+                }
+            }
+            result.onset_frames[dim - 1] = last;
+        }
+
+        return result;
+    }
+}
\ No newline at end of file
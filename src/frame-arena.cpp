@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "frame-arena.hpp"
+#include <cstdint>
+#include <new>
+
+namespace percolation
+{
+    namespace
+    {
+        const size_t buffer_alignment = 64;
+
+        size_t align_up(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    FrameArena::FrameArena(size_t initial_capacity, std::pmr::memory_resource *upstream) : upstream(upstream)
+    {
+        if (initial_capacity > 0)
+        {
+            buffer = static_cast<char *>(upstream->allocate(initial_capacity, buffer_alignment));
+            capacity = initial_capacity;
+            num_upstream_allocations++;
+        }
+    }
+
+    FrameArena::~FrameArena()
+    {
+        release_overflow();
+        if (buffer != nullptr)
+        {
+            upstream->deallocate(buffer, capacity, buffer_alignment);
+        }
+    }
+
+    void FrameArena::reset()
+    {
+        size_t required = offset + overflow_bytes;
+        bool grow = (overflow != nullptr);
+        release_overflow();
+
+        if (grow)
+        {
+            if (buffer != nullptr)
+            {
+                upstream->deallocate(buffer, capacity, buffer_alignment);
+                buffer = nullptr;
+                capacity = 0;
+            }
+            size_t new_capacity = align_up(required + required / 4, buffer_alignment);
+            buffer = static_cast<char *>(upstream->allocate(new_capacity, buffer_alignment));
+            capacity = new_capacity;
+            num_upstream_allocations++;
+        }
+        offset = 0;
+    }
+
+    size_t FrameArena::get_capacity() const
+    {
+        return capacity;
+    }
+
+    size_t FrameArena::get_used() const
+    {
+        return offset + overflow_bytes;
+    }
+
+    size_t FrameArena::get_num_upstream_allocations() const
+    {
+        return num_upstream_allocations;
+    }
+
+    void *FrameArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        if (buffer != nullptr)
+        {
+            // The alignment is applied to the address, as it may exceed the alignment of the buffer
+            uintptr_t base = reinterpret_cast<uintptr_t>(buffer);
+            size_t start = align_up(base + offset, alignment) - base;
+            if (start + bytes <= capacity)
+            {
+                offset = start + bytes;
+                return buffer + start;
+            }
+        }
+
+        // The header is padded so that the memory behind it keeps the requested alignment
+        size_t block_alignment = (alignment > alignof(OverflowBlock) ? alignment : alignof(OverflowBlock));
+        size_t header_size = align_up(sizeof(OverflowBlock), block_alignment);
+        void *block = upstream->allocate(header_size + bytes, block_alignment);
+        num_upstream_allocations++;
+
+        overflow = new (block) OverflowBlock{overflow, header_size + bytes, block_alignment};
+        overflow_bytes += bytes + alignment;
+        return static_cast<char *>(block) + header_size;
+    }
+
+    void FrameArena::do_deallocate(void *, size_t, size_t)
+    {
+        // Memory is only released as a whole by reset()
+    }
+
+    bool FrameArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void FrameArena::release_overflow()
+    {
+        while (overflow != nullptr)
+        {
+            OverflowBlock *next = overflow->next;
+            upstream->deallocate(overflow, overflow->size, overflow->alignment);
+            overflow = next;
+        }
+        overflow_bytes = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,431 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "frame-file.hpp"
+#include "coordinate-kernels.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mol
+{
+    namespace
+    {
+        static_assert(sizeof(size_t) == sizeof(uint64_t), "Bond indices are mapped directly as size_t");
+        static_assert(sizeof(vec<graph_precision_type>) == 3 * sizeof(double) && sizeof(graph_precision_type) == sizeof(double), "Positions are mapped directly as vec<graph_precision_type>");
+
+        const char frame_file_magic[8] = {'P', 'E', 'R', 'C', 'F', 'R', 'M', '1'};
+        const uint64_t frame_file_version = 1;
+        const size_t file_header_size = 32;
+        const size_t frame_header_size = 96;
+        const uint64_t flag_translations = 1;
+
+        bool is_little_endian()
+        {
+            const uint16_t probe = 1;
+            unsigned char first_byte;
+            std::memcpy(&first_byte, &probe, 1);
+            return first_byte == 1;
+        }
+
+        size_t padded_size(size_t num_bytes)
+        {
+            return (num_bytes + 7) / 8 * 8;
+        }
+
+        uint64_t read_uint64(const unsigned char *bytes)
+        {
+            uint64_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+    }
+
+    FrameFileWriter::~FrameFileWriter()
+    {
+        close();
+    }
+
+    bool FrameFileWriter::open(const std::string &path)
+    {
+        close();
+        if (!is_little_endian())
+        {
+            return false;
+        }
+
+        out.open(path, std::ios::binary | std::ios::trunc);
+        frame_offsets.clear();
+        curr_offset = 0;
+
+        // The header is completed by close() once the number of frames and the position of the index are known
+        const unsigned char placeholder[file_header_size] = {};
+        return out.is_open() && write_bytes(placeholder, file_header_size);
+    }
+
+    bool FrameFileWriter::write_frame(const MolecularGraph &frame, bool with_translations)
+    {
+        const std::vector<vec<graph_precision_type>> &basis = frame.get_basis();
+        if (!out.is_open() || basis.size() != 3)
+        {
+            return false;
+        }
+
+        // Collect every bond once
+        const size_t num_atoms = frame.get_atom_count();
+        workspace.bond_base.clear();
+        workspace.bond_head.clear();
+        for (size_t base = 0; base < num_atoms; base++)
+        {
+            for (size_t head : frame.get_bonds(base))
+            {
+                if (head >= base)
+                {
+                    workspace.bond_base.push_back(base);
+                    workspace.bond_head.push_back(head);
+                }
+            }
+        }
+        const size_t num_bonds = workspace.bond_base.size();
+
+        frame_offsets.push_back(curr_offset);
+
+        uint64_t header[3] = {num_atoms, num_bonds, (with_translations ? flag_translations : 0)};
+        double basis_entries[9];
+        for (size_t i = 0; i < 3; i++)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                basis_entries[3 * i + j] = basis[i][j];
+            }
+        }
+        bool success = write_bytes(header, sizeof(header)) && write_bytes(basis_entries, sizeof(basis_entries));
+        success = success && write_bytes(frame.get_atom_positions().data(), num_atoms * sizeof(vec<graph_precision_type>));
+        success = success && write_bytes(workspace.bond_base.data(), num_bonds * sizeof(size_t)) && write_bytes(workspace.bond_head.data(), num_bonds * sizeof(size_t));
+
+        if (with_translations)
+        {
+            workspace.coeff_x.resize(num_atoms);
+            workspace.coeff_y.resize(num_atoms);
+            workspace.coeff_z.resize(num_atoms);
+            workspace.trans_x.resize(num_bonds);
+            workspace.trans_y.resize(num_bonds);
+            workspace.trans_z.resize(num_bonds);
+            normalize_positions(frame.get_atom_positions().data(), num_atoms, basis, workspace.coeff_x.data(), workspace.coeff_y.data(), workspace.coeff_z.data());
+            compute_bond_translations(workspace.coeff_x.data(), workspace.coeff_y.data(), workspace.coeff_z.data(), workspace.bond_base.data(), workspace.bond_head.data(),
+                                      num_bonds, workspace.trans_x.data(), workspace.trans_y.data(), workspace.trans_z.data());
+
+            const unsigned char padding[8] = {};
+            success = success && write_bytes(workspace.trans_x.data(), num_bonds) && write_bytes(workspace.trans_y.data(), num_bonds) && write_bytes(workspace.trans_z.data(), num_bonds);
+            success = success && write_bytes(padding, padded_size(3 * num_bonds) - 3 * num_bonds);
+        }
+        return success;
+    }
+
+    bool FrameFileWriter::close()
+    {
+        if (!out.is_open())
+        {
+            return false;
+        }
+
+        uint64_t index_offset = curr_offset;
+        bool success = write_bytes(frame_offsets.data(), frame_offsets.size() * sizeof(uint64_t));
+
+        uint64_t header[3] = {frame_file_version, frame_offsets.size(), index_offset};
+        out.seekp(0);
+        success = success && write_bytes(frame_file_magic, sizeof(frame_file_magic)) && write_bytes(header, sizeof(header));
+
+        out.close();
+        return success && !out.fail();
+    }
+
+    bool FrameFileWriter::write_bytes(const void *bytes, size_t num_bytes)
+    {
+        out.write(static_cast<const char *>(bytes), num_bytes);
+        curr_offset += num_bytes;
+        return out.good();
+    }
+
+    FrameFileReader::~FrameFileReader()
+    {
+        close();
+    }
+
+    bool FrameFileReader::open(const std::string &path)
+    {
+        close();
+        if (!is_little_endian())
+        {
+            return false;
+        }
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        file_handle = file;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < (LONGLONG)file_header_size)
+        {
+            close();
+            return false;
+        }
+        size = (size_t)file_size.QuadPart;
+
+        mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle == nullptr)
+        {
+            close();
+            return false;
+        }
+        data = static_cast<const unsigned char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if (data == nullptr)
+        {
+            close();
+            return false;
+        }
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat file_stat;
+        if (fstat(file, &file_stat) != 0 || file_stat.st_size < (off_t)file_header_size)
+        {
+            ::close(file);
+            return false;
+        }
+
+        // The mapping stays valid after closing the file descriptor
+        void *mapping = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (mapping == MAP_FAILED)
+        {
+            return false;
+        }
+        data = static_cast<const unsigned char *>(mapping);
+        size = (size_t)file_stat.st_size;
+#endif
+
+        uint64_t version = read_uint64(data + 8);
+        uint64_t frames_in_file = read_uint64(data + 16);
+        uint64_t index_offset = read_uint64(data + 24);
+        bool valid_header = std::memcmp(data, frame_file_magic, sizeof(frame_file_magic)) == 0 && version == frame_file_version;
+        bool valid_index = index_offset % 8 == 0 && index_offset <= size && frames_in_file <= (size - index_offset) / sizeof(uint64_t);
+        if (!valid_header || !valid_index)
+        {
+            close();
+            return false;
+        }
+
+        num_frames = frames_in_file;
+        frame_offsets = reinterpret_cast<const uint64_t *>(data + index_offset);
+        return true;
+    }
+
+    void FrameFileReader::close()
+    {
+#ifdef _WIN32
+        if (data != nullptr)
+        {
+            UnmapViewOfFile(data);
+        }
+        if (mapping_handle != nullptr)
+        {
+            CloseHandle(mapping_handle);
+        }
+        if (file_handle != nullptr)
+        {
+            CloseHandle(file_handle);
+        }
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        if (data != nullptr)
+        {
+            munmap(const_cast<unsigned char *>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+        num_frames = 0;
+        frame_offsets = nullptr;
+    }
+
+    size_t FrameFileReader::get_num_frames() const
+    {
+        return num_frames;
+    }
+
+    bool FrameFileReader::get_frame(size_t frame_index, FrameView &view) const
+    {
+        if (frame_index >= num_frames)
+        {
+            return false;
+        }
+
+        uint64_t offset = frame_offsets[frame_index];
+        if (offset % 8 != 0 || offset > size || size - offset < frame_header_size)
+        {
+            return false;
+        }
+        const unsigned char *frame = data + offset;
+        size_t remaining = size - offset - frame_header_size;
+
+        // Check the sizes before multiplying them to not overflow on corrupted files
+        uint64_t num_atoms = read_uint64(frame);
+        uint64_t num_bonds = read_uint64(frame + 8);
+        uint64_t flags = read_uint64(frame + 16);
+        if (num_atoms > remaining / sizeof(vec<graph_precision_type>))
+        {
+            return false;
+        }
+        remaining -= num_atoms * sizeof(vec<graph_precision_type>);
+        size_t bytes_per_bond = 2 * sizeof(size_t) + ((flags & flag_translations) ? 3 : 0);
+        if (num_bonds > remaining / bytes_per_bond)
+        {
+            return false;
+        }
+        if ((flags & flag_translations) && padded_size(3 * num_bonds) > remaining - 2 * sizeof(size_t) * num_bonds)
+        {
+            return false;
+        }
+
+        view.num_atoms = num_atoms;
+        view.num_bonds = num_bonds;
+        for (size_t i = 0; i < 3; i++)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                std::memcpy(&view.basis[i][j], frame + 24 + 8 * (3 * i + j), sizeof(double));
+            }
+        }
+
+        const unsigned char *section = frame + frame_header_size;
+        view.positions = reinterpret_cast<const vec<graph_precision_type> *>(section);
+        section += num_atoms * sizeof(vec<graph_precision_type>);
+        view.bond_base = reinterpret_cast<const size_t *>(section);
+        section += num_bonds * sizeof(size_t);
+        view.bond_head = reinterpret_cast<const size_t *>(section);
+        section += num_bonds * sizeof(size_t);
+
+        if (flags & flag_translations)
+        {
+            view.trans_x = reinterpret_cast<const int8_t *>(section);
+            view.trans_y = view.trans_x + num_bonds;
+            view.trans_z = view.trans_y + num_bonds;
+        }
+        else
+        {
+            view.trans_x = view.trans_y = view.trans_z = nullptr;
+        }
+        return true;
+    }
+
+    bool FrameFileReader::read_frame(size_t frame_index, MolecularGraph &frame) const
+    {
+        FrameView view;
+        if (!get_frame(frame_index, view))
+        {
+            return false;
+        }
+
+        frame.set_atom_count(view.num_atoms);
+        frame.clear_bonds();
+        if (!frame.set_basis(std::vector<vec<graph_precision_type>>(view.basis.begin(), view.basis.end())))
+        {
+            return false;
+        }
+        for (size_t atom = 0; atom < view.num_atoms; atom++)
+        {
+            frame.set_atom_position(atom, view.positions[atom]);
+        }
+        for (size_t b = 0; b < view.num_bonds; b++)
+        {
+            if (!frame.add_bond(view.bond_base[b], view.bond_head[b]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool FrameFileReader::fill_percolation_graph(size_t frame_index, percolation::PercolationGraph &res, ConversionWorkspace &workspace) const
+    {
+        FrameView view;
+        if (!get_frame(frame_index, view))
+        {
+            return false;
+        }
+        for (size_t b = 0; b < view.num_bonds; b++)
+        {
+            if (view.bond_base[b] >= view.num_atoms || view.bond_head[b] >= view.num_atoms)
+            {
+                return false;
+            }
+        }
+
+        res.reset();
+        res.reserve_vertices(view.num_atoms);
+
+        const int8_t *trans[3] = {view.trans_x, view.trans_y, view.trans_z};
+        if (view.trans_x == nullptr)
+        {
+            // No precomputed translations, derive them from the positions
+            workspace.coeff_x.resize(view.num_atoms);
+            workspace.coeff_y.resize(view.num_atoms);
+            workspace.coeff_z.resize(view.num_atoms);
+            workspace.trans_x.resize(view.num_bonds);
+            workspace.trans_y.resize(view.num_bonds);
+            workspace.trans_z.resize(view.num_bonds);
+            normalize_positions(view.positions, view.num_atoms, view.basis, workspace.coeff_x.data(), workspace.coeff_y.data(), workspace.coeff_z.data());
+            compute_bond_translations(workspace.coeff_x.data(), workspace.coeff_y.data(), workspace.coeff_z.data(), view.bond_base, view.bond_head,
+                                      view.num_bonds, workspace.trans_x.data(), workspace.trans_y.data(), workspace.trans_z.data());
+            trans[0] = workspace.trans_x.data();
+            trans[1] = workspace.trans_y.data();
+            trans[2] = workspace.trans_z.data();
+        }
+
+        return res.build_from_edge_arrays(view.bond_base, view.bond_head, trans, view.num_bonds);
+    }
+}
\ No newline at end of file
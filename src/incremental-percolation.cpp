@@ -0,0 +1,279 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "incremental-percolation.hpp"
+
+namespace percolation
+{
+    namespace
+    {
+        const size_t no_basis = (size_t)-1;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicIncrementalPercolationGraph<Dim, Coord>::reserve_vertices(size_t num_vertices)
+    {
+        if (this->vertices.size() >= num_vertices)
+        {
+            return true;
+        }
+        size_t curr_size = this->vertices.size();
+        this->vertices.resize(num_vertices);
+        this->parent.resize(num_vertices);
+        this->parent_offset.resize(num_vertices, position_type::zero());
+        this->component_size.resize(num_vertices, 1);
+        this->basis_index.resize(num_vertices, no_basis);
+        for (size_t i = curr_size; i < num_vertices; i++)
+        {
+            this->vertices[i].index = i;
+            this->parent[i] = i;
+        }
+        num_components += num_vertices - curr_size;
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicIncrementalPercolationGraph<Dim, Coord>::reset()
+    {
+        vertices.clear();
+        parent.clear();
+        parent_offset.clear();
+        component_size.clear();
+        basis_index.clear();
+        lattice_bases.clear();
+        free_bases.clear();
+        num_components = 0;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicIncrementalPercolationGraph<Dim, Coord>::add_vertex(size_t vertex_index, const VertexData &vertex_data)
+    {
+        if (!reserve_vertices(vertex_index + 1))
+        {
+            return false;
+        }
+        vertices[vertex_index] = vertex_data;
+        vertices[vertex_index].index = vertex_index;
+
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicIncrementalPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data)
+    {
+        size_t max_index = (vertex_index_base > vertex_index_head ? vertex_index_base : vertex_index_head);
+        if (!reserve_vertices(max_index + 1))
+        {
+            return false;
+        }
+
+        position_type base_position, head_position;
+        size_t base_root = find_root(vertex_index_base, base_position);
+        size_t head_root = find_root(vertex_index_head, head_position);
+
+        // Translation of the head root relative to the base root if the edge is used to connect the two
+        position_type head_root_offset = base_position + position_type(edge_data.translation) - head_position;
+
+        if (base_root == head_root)
+        {
+            // The edge closes a cycle, its net translation is a lattice vector of the component
+            add_lattice_vector(base_root, head_root_offset);
+            return true;
+        }
+
+        // Union by size: attach the smaller tree below the root of the larger one
+        size_t new_root = base_root;
+        size_t child_root = head_root;
+        if (component_size[base_root] < component_size[head_root])
+        {
+            new_root = head_root;
+            child_root = base_root;
+            head_root_offset = -head_root_offset;
+        }
+
+        parent[child_root] = new_root;
+        parent_offset[child_root] = head_root_offset;
+        component_size[new_root] += component_size[child_root];
+        num_components--;
+
+        // Lattice vectors do not depend on the reference vertex, so the ones of the absorbed component carry over
+        size_t child_basis = basis_index[child_root];
+        if (child_basis != no_basis)
+        {
+            if (basis_index[new_root] == no_basis)
+            {
+                basis_index[new_root] = child_basis;
+            }
+            else
+            {
+                const basis_type &child_lattice = lattice_bases[child_basis];
+                for (size_t i = 0; i < child_lattice.size(); i++)
+                {
+                    add_lattice_vector(new_root, child_lattice[i]);
+                }
+                lattice_bases[child_basis] = basis_type();
+                free_bases.push_back(child_basis);
+            }
+            basis_index[child_root] = no_basis;
+        }
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicIncrementalPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        return add_edge(vertex_index_base, vertex_index_head, edge_data_type(edge_trans));
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicIncrementalPercolationGraph<Dim, Coord>::get_component_representative(size_t vertex_index)
+    {
+        if (vertex_index >= vertices.size())
+        {
+            return vertex_index;
+        }
+        position_type position;
+        return find_root(vertex_index, position);
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicIncrementalPercolationGraph<Dim, Coord>::get_percolation_dim(size_t vertex_index)
+    {
+        if (vertex_index >= vertices.size())
+        {
+            return 0;
+        }
+        position_type position;
+        size_t root = find_root(vertex_index, position);
+        if (basis_index[root] == no_basis)
+        {
+            return 0;
+        }
+        return lattice_bases[basis_index[root]].size();
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicIncrementalPercolationGraph<Dim, Coord>::get_num_components() const
+    {
+        return num_components;
+    }
+
+    template <size_t Dim, typename Coord>
+    std::vector<ComponentInfo> BasicIncrementalPercolationGraph<Dim, Coord>::get_component_percolation_info()
+    {
+        std::vector<ComponentInfo> component_info;
+        component_info.reserve(num_components);
+
+        // Components are numbered in order of their smallest vertex, which is the first one encountered here
+        std::vector<size_t> root_component(vertices.size(), (size_t)-1);
+        position_type position;
+
+        for (size_t curr_vertex = 0; curr_vertex < vertices.size(); curr_vertex++)
+        {
+            size_t root = find_root(curr_vertex, position);
+            if (root_component[root] == (size_t)-1)
+            {
+                root_component[root] = component_info.size();
+
+                ComponentInfo new_comp;
+                new_comp.component_index = component_info.size();
+                new_comp.percolation_dim = (basis_index[root] == no_basis ? 0 : lattice_bases[basis_index[root]].size());
+                new_comp.vertices.reserve(component_size[root]);
+                component_info.push_back(new_comp);
+            }
+            component_info[root_component[root]].vertices.push_back(vertices[curr_vertex]);
+        }
+        return component_info;
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicIncrementalPercolationGraph<Dim, Coord>::find_root(size_t vertex_index, position_type &position)
+    {
+        // Find the root and the accumulated translation along the way
+        size_t root = vertex_index;
+        position = position_type::zero();
+        while (parent[root] != root)
+        {
+            position = position + parent_offset[root];
+            root = parent[root];
+        }
+
+        // Point every vertex on the path directly to the root
+        position_type remaining = position;
+        size_t curr_vertex = vertex_index;
+        while (curr_vertex != root)
+        {
+            size_t next_vertex = parent[curr_vertex];
+            position_type curr_offset = parent_offset[curr_vertex];
+
+            parent[curr_vertex] = root;
+            parent_offset[curr_vertex] = remaining;
+
+            remaining = remaining - curr_offset;
+            curr_vertex = next_vertex;
+        }
+        return root;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicIncrementalPercolationGraph<Dim, Coord>::add_lattice_vector(size_t root, const position_type &lattice_vector)
+    {
+        size_t &index = basis_index[root];
+        if (index != no_basis)
+        {
+            lattice_bases[index].insert(lattice_vector);
+            return;
+        }
+
+        // Only components with a non-zero lattice vector occupy an entry
+        basis_type new_basis;
+        if (!new_basis.insert(lattice_vector))
+        {
+            return;
+        }
+
+        if (free_bases.empty())
+        {
+            index = lattice_bases.size();
+            lattice_bases.push_back(new_basis);
+        }
+        else
+        {
+            index = free_bases.back();
+            free_bases.pop_back();
+            lattice_bases[index] = new_basis;
+        }
+    }
+
+    template class BasicIncrementalPercolationGraph<2, int8_t>;
+    template class BasicIncrementalPercolationGraph<2, int32_t>;
+    template class BasicIncrementalPercolationGraph<2, int64_t>;
+    template class BasicIncrementalPercolationGraph<3, int8_t>;
+    template class BasicIncrementalPercolationGraph<3, int32_t>;
+    template class BasicIncrementalPercolationGraph<3, int64_t>;
+}
\ No newline at end of file
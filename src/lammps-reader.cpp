@@ -0,0 +1,987 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include "lammps-reader.hpp"
+#include "thread-pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+
+namespace mol
+{
+    namespace
+    {
+        const size_t no_column = (size_t)-1;
+        const size_t max_fields = 64;
+
+        /**
+         * @brief Periodic box in the LAMMPS convention
+         */
+        struct LammpsBox
+        {
+            vec<graph_precision_type> origin;
+            std::vector<vec<graph_precision_type>> basis = std::vector<vec<graph_precision_type>>(3);
+        };
+
+        /**
+         * @brief Columns of the atom lines
+         */
+        struct AtomColumns
+        {
+            size_t id = no_column;
+            size_t type = no_column;
+            size_t pos[3] = {no_column, no_column, no_column};
+            size_t image[3] = {no_column, no_column, no_column};
+            bool scaled = false;
+            size_t num_required = 0;
+        };
+
+        std::string_view trim(std::string_view text)
+        {
+            size_t first = text.find_first_not_of(" \t\r");
+            if (first == std::string_view::npos)
+            {
+                return std::string_view();
+            }
+            size_t last = text.find_last_not_of(" \t\r");
+            return text.substr(first, last - first + 1);
+        }
+
+        /**
+         * @brief Split a line into whitespace separated fields, ignoring comments
+         * 
+         * @return size_t The number of fields, of which at most max_fields are stored
+         */
+        size_t split_fields(const char *begin, const char *end, std::string_view *fields)
+        {
+            size_t num_fields = 0;
+            const char *curr = begin;
+            while (curr < end)
+            {
+                while (curr < end && (*curr == ' ' || *curr == '\t' || *curr == '\r'))
+                {
+                    curr++;
+                }
+                if (curr == end || *curr == '#')
+                {
+                    break;
+                }
+                const char *field_begin = curr;
+                while (curr < end && *curr != ' ' && *curr != '\t' && *curr != '\r' && *curr != '#')
+                {
+                    curr++;
+                }
+                if (num_fields < max_fields)
+                {
+                    fields[num_fields] = std::string_view(field_begin, curr - field_begin);
+                }
+                num_fields++;
+            }
+            return num_fields;
+        }
+
+        template <typename T>
+        bool parse_number(std::string_view field, T &value)
+        {
+            const char *field_end = field.data() + field.size();
+            std::from_chars_result result = std::from_chars(field.data(), field_end, value);
+            return result.ec == std::errc() && result.ptr == field_end;
+        }
+
+        /**
+         * @brief Call parse_line(line_index, line_begin, line_end) for every line of a block, distributing chunks of the block among threads
+         * 
+         * @return size_t The index of the first line for which parse_line() returned false, num_lines if all succeeded
+         */
+        template <typename ParseLine>
+        size_t parse_lines_parallel(const char *block_begin, const char *block_end, size_t num_lines, size_t num_threads, ParseLine &&parse_line)
+        {
+            // Split the block into chunks of whole lines
+            const size_t min_chunk_bytes = 1 << 16;
+            size_t block_bytes = block_end - block_begin;
+            size_t num_chunks = std::max<size_t>(1, std::min(8 * percolation::resolve_thread_count(num_threads), block_bytes / min_chunk_bytes));
+            std::vector<const char *> chunk_begin(num_chunks + 1, block_end);
+            chunk_begin[0] = block_begin;
+            for (size_t chunk = 1; chunk < num_chunks; chunk++)
+            {
+                const char *split = std::max(chunk_begin[chunk - 1], block_begin + chunk * (block_bytes / num_chunks));
+                const char *line_break = static_cast<const char *>(std::memchr(split, '\n', block_end - split));
+                chunk_begin[chunk] = (line_break == nullptr ? block_end : line_break + 1);
+            }
+
+            // Count the lines of every chunk to know the index of its first line
+            std::vector<size_t> first_line(num_chunks + 1, 0);
+            percolation::parallel_for_dynamic(num_chunks, num_threads, 1, [&](size_t chunk, size_t) {
+                const char *begin = chunk_begin[chunk];
+                const char *end = chunk_begin[chunk + 1];
+                size_t chunk_lines = std::count(begin, end, '\n');
+                if (begin < end && *(end - 1) != '\n')
+                {
+                    chunk_lines++;
+                }
+                first_line[chunk + 1] = chunk_lines;
+            });
+            for (size_t chunk = 0; chunk < num_chunks; chunk++)
+            {
+                first_line[chunk + 1] += first_line[chunk];
+            }
+            if (first_line[num_chunks] != num_lines)
+            {
+                return std::min(num_lines, first_line[num_chunks]);
+            }
+
+            std::atomic<size_t> first_failed(num_lines);
+            percolation::parallel_for_dynamic(num_chunks, num_threads, 1, [&](size_t chunk, size_t) {
+                size_t line_index = first_line[chunk];
+                const char *curr = chunk_begin[chunk];
+                const char *end = chunk_begin[chunk + 1];
+                while (curr < end)
+                {
+                    const char *line_end = static_cast<const char *>(std::memchr(curr, '\n', end - curr));
+                    line_end = (line_end == nullptr ? end : line_end);
+                    if (!parse_line(line_index, curr, line_end))
+                    {
+                        size_t prev_failed = first_failed.load();
+                        while (line_index < prev_failed && !first_failed.compare_exchange_weak(prev_failed, line_index))
+                        {
+                        }
+                        return;
+                    }
+                    line_index++;
+                    curr = line_end + 1;
+                }
+            });
+            return first_failed.load();
+        }
+
+        /**
+         * @brief Parse the atom lines of a data file or a dump frame in parallel
+         */
+        bool parse_atom_block(const char *block_begin, const char *block_end, size_t num_atoms, const AtomColumns &columns, const LammpsBox &box, size_t num_threads,
+                              LammpsAtomInfo &rows, std::vector<vec<graph_precision_type>> &positions, std::string &error)
+        {
+            rows.ids.resize(num_atoms);
+            rows.types.resize(num_atoms);
+            positions.resize(num_atoms);
+
+            size_t failed_line = parse_lines_parallel(block_begin, block_end, num_atoms, num_threads, [&](size_t row, const char *line_begin, const char *line_end) {
+                std::string_view fields[max_fields];
+                size_t num_fields = split_fields(line_begin, line_end, fields);
+                if (num_fields < columns.num_required || num_fields > max_fields)
+                {
+                    return false;
+                }
+
+                int64_t type = 0;
+                double coord[3];
+                int64_t image[3] = {0, 0, 0};
+                bool valid = parse_number(fields[columns.id], rows.ids[row]);
+                valid = valid && (columns.type == no_column || parse_number(fields[columns.type], type));
+                for (size_t dim = 0; dim < 3; dim++)
+                {
+                    valid = valid && parse_number(fields[columns.pos[dim]], coord[dim]);
+                    valid = valid && (columns.image[dim] == no_column || parse_number(fields[columns.image[dim]], image[dim]));
+                }
+                if (!valid)
+                {
+                    return false;
+                }
+                rows.types[row] = type;
+
+                // Positions relative to the origin of the box, moved to their image
+                vec<graph_precision_type> pos;
+                if (columns.scaled)
+                {
+                    pos = box.basis[0] * coord[0] + box.basis[1] * coord[1] + box.basis[2] * coord[2];
+                }
+                else
+                {
+                    pos.x = coord[0] - box.origin.x;
+                    pos.y = coord[1] - box.origin.y;
+                    pos.z = coord[2] - box.origin.z;
+                }
+                pos += box.basis[0] * double(image[0]) + box.basis[1] * double(image[1]) + box.basis[2] * double(image[2]);
+                positions[row] = pos;
+                return true;
+            });
+
+            if (failed_line < num_atoms)
+            {
+                error = "Invalid atom line " + std::to_string(failed_line + 1) + " of " + std::to_string(num_atoms);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Parse the two atom ids of every bond line in parallel
+         */
+        bool parse_bond_block(const char *block_begin, const char *block_end, size_t num_bonds, size_t column_1, size_t column_2, size_t num_threads,
+                              std::vector<int64_t> &bond_ids, std::string &error)
+        {
+            bond_ids.resize(2 * num_bonds);
+            size_t num_required = std::max(column_1, column_2) + 1;
+
+            size_t failed_line = parse_lines_parallel(block_begin, block_end, num_bonds, num_threads, [&](size_t row, const char *line_begin, const char *line_end) {
+                std::string_view fields[max_fields];
+                size_t num_fields = split_fields(line_begin, line_end, fields);
+                return num_fields >= num_required && num_fields <= max_fields && parse_number(fields[column_1], bond_ids[2 * row]) && parse_number(fields[column_2], bond_ids[2 * row + 1]);
+            });
+
+            if (failed_line < num_bonds)
+            {
+                error = "Invalid bond line " + std::to_string(failed_line + 1) + " of " + std::to_string(num_bonds);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Fill a molecular graph with parsed atoms, ordered by their ids
+         * 
+         * @param rows The ids and types of the atoms in file order, reordered by id on return
+         * @param positions The positions of the atoms in file order
+         * @param atom_order Output of the index of the atom of every row
+         * @param id_lookup Output of the index of every atom id, no_column for ids without atom. 
+         * Left empty if the ids are too sparse for a dense table, the index of an id is then found in the sorted rows.ids.
+         */
+        bool fill_atoms(LammpsAtomInfo &rows, const std::vector<vec<graph_precision_type>> &positions, const LammpsBox &box, MolecularGraph &graph,
+                        std::vector<size_t> &atom_order, std::vector<size_t> &id_lookup, std::string &error)
+        {
+            const size_t num_atoms = rows.ids.size();
+            int64_t max_id = 0;
+            for (int64_t id : rows.ids)
+            {
+                if (id < 1)
+                {
+                    error = "Invalid atom id " + std::to_string(id);
+                    return false;
+                }
+                max_id = std::max(max_id, id);
+            }
+
+            // The index of an atom is the number of atoms with a smaller id
+            atom_order.resize(num_atoms);
+            if (size_t(max_id) <= 16 * num_atoms + 1024)
+            {
+                id_lookup.assign(size_t(max_id) + 1, no_column);
+                for (size_t row = 0; row < num_atoms; row++)
+                {
+                    size_t &entry = id_lookup[size_t(rows.ids[row])];
+                    if (entry != no_column)
+                    {
+                        error = "Duplicate atom id " + std::to_string(rows.ids[row]);
+                        return false;
+                    }
+                    entry = row;
+                }
+                size_t next_index = 0;
+                for (size_t &entry : id_lookup)
+                {
+                    if (entry != no_column)
+                    {
+                        atom_order[entry] = next_index;
+                        entry = next_index++;
+                    }
+                }
+            }
+            else
+            {
+                // Sparse ids, e.g. of a dump restricted to a group, are ranked by sorting the rows, the lookup serves as buffer
+                id_lookup.resize(num_atoms);
+                std::iota(id_lookup.begin(), id_lookup.end(), size_t(0));
+                std::sort(id_lookup.begin(), id_lookup.end(), [&](size_t row_1, size_t row_2) { return rows.ids[row_1] < rows.ids[row_2]; });
+                for (size_t index = 0; index < num_atoms; index++)
+                {
+                    if (index > 0 && rows.ids[id_lookup[index]] == rows.ids[id_lookup[index - 1]])
+                    {
+                        error = "Duplicate atom id " + std::to_string(rows.ids[id_lookup[index]]);
+                        return false;
+                    }
+                    atom_order[id_lookup[index]] = index;
+                }
+                id_lookup.clear();
+            }
+
+            graph.set_atom_count(num_atoms);
+            graph.clear_bonds();
+            if (!graph.set_basis(box.basis))
+            {
+                error = "Invalid box";
+                return false;
+            }
+
+            std::vector<int64_t> sorted(num_atoms);
+            for (size_t row = 0; row < num_atoms; row++)
+            {
+                graph.set_atom_position(atom_order[row], positions[row]);
+                sorted[atom_order[row]] = rows.ids[row];
+            }
+            rows.ids.swap(sorted);
+            for (size_t row = 0; row < num_atoms; row++)
+            {
+                sorted[atom_order[row]] = rows.types[row];
+            }
+            rows.types.swap(sorted);
+            return true;
+        }
+
+        /**
+         * @brief Find the index of an atom id as assigned by fill_atoms()
+         * 
+         * @param id 
+         * @param sorted_ids The atom ids in index order
+         * @param id_lookup The dense table of fill_atoms(), empty for sparse ids
+         * @return size_t The index of the atom, no_column for an unknown id
+         */
+        size_t find_atom_index(int64_t id, const std::vector<int64_t> &sorted_ids, const std::vector<size_t> &id_lookup)
+        {
+            if (id_lookup.empty())
+            {
+                auto it = std::lower_bound(sorted_ids.begin(), sorted_ids.end(), id);
+                return (it == sorted_ids.end() || *it != id ? no_column : size_t(it - sorted_ids.begin()));
+            }
+            return (id < 0 || size_t(id) >= id_lookup.size() ? no_column : id_lookup[size_t(id)]);
+        }
+
+        bool add_bonds(const std::vector<int64_t> &bond_ids, const std::vector<int64_t> &sorted_ids, const std::vector<size_t> &id_lookup, MolecularGraph &graph, std::string &error)
+        {
+            for (size_t b = 0; b < bond_ids.size(); b += 2)
+            {
+                size_t index[2];
+                for (size_t i = 0; i < 2; i++)
+                {
+                    index[i] = find_atom_index(bond_ids[b + i], sorted_ids, id_lookup);
+                    if (index[i] == no_column)
+                    {
+                        error = "Bond to unknown atom id " + std::to_string(bond_ids[b + i]);
+                        return false;
+                    }
+                }
+                graph.add_bond(index[0], index[1]);
+            }
+            return true;
+        }
+
+        bool next_non_blank_line(TextLineReader &reader, std::string_view &line)
+        {
+            const char *line_begin;
+            const char *line_end;
+            while (reader.next_line(line_begin, line_end))
+            {
+                line = trim(std::string_view(line_begin, line_end - line_begin));
+                if (!line.empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief The ITEM lines of a dump frame up to its per-atom or per-entry lines
+         */
+        struct DumpHeader
+        {
+            int64_t timestep = 0;
+            size_t num_rows = 0;
+            bool has_box = false;
+            LammpsBox box;
+            std::vector<std::string> columns;
+        };
+
+        /**
+         * @brief Read the header of the next frame of a dump
+         * 
+         * @return true 
+         * @return false The end of the file has been reached (error empty) or the header is invalid
+         */
+        bool read_dump_header(TextLineReader &reader, DumpHeader &header, std::string &error)
+        {
+            std::string_view line;
+            if (!next_non_blank_line(reader, line))
+            {
+                return false;
+            }
+
+            std::string_view fields[max_fields];
+            header.has_box = false;
+            while (true)
+            {
+                if (line.substr(0, 6) != "ITEM: ")
+                {
+                    error = "Expected an ITEM line in the dump, found '" + std::string(line) + "'";
+                    return false;
+                }
+                std::string_view item = line.substr(6);
+
+                if (item.substr(0, 5) == "ATOMS" || item.substr(0, 7) == "ENTRIES")
+                {
+                    size_t num_fields = std::min(split_fields(item.data(), item.data() + item.size(), fields), max_fields);
+                    header.columns.clear();
+                    for (size_t f = 1; f < num_fields; f++)
+                    {
+                        header.columns.emplace_back(fields[f]);
+                    }
+                    return true;
+                }
+
+                std::string_view value;
+                if (!next_non_blank_line(reader, value))
+                {
+                    error = "Unexpected end of the dump after '" + std::string(line) + "'";
+                    return false;
+                }
+
+                if (item == "TIMESTEP")
+                {
+                    if (!parse_number(value, header.timestep))
+                    {
+                        error = "Invalid timestep '" + std::string(value) + "'";
+                        return false;
+                    }
+                }
+                else if (item == "NUMBER OF ATOMS" || item == "NUMBER OF ENTRIES")
+                {
+                    if (!parse_number(value, header.num_rows))
+                    {
+                        error = "Invalid number of atoms or entries '" + std::string(value) + "'";
+                        return false;
+                    }
+                }
+                else if (item.substr(0, 10) == "BOX BOUNDS")
+                {
+                    // Bounds of the bounding box and tilt factors xy, xz and yz for triclinic boxes
+                    double lo_bound[3], hi_bound[3], tilt[3] = {0.0, 0.0, 0.0};
+                    for (size_t dim = 0; dim < 3; dim++)
+                    {
+                        if (dim > 0 && !next_non_blank_line(reader, value))
+                        {
+                            error = "Unexpected end of the dump in the box bounds";
+                            return false;
+                        }
+                        size_t num_fields = split_fields(value.data(), value.data() + value.size(), fields);
+                        bool valid = (num_fields == 2 || num_fields == 3) && parse_number(fields[0], lo_bound[dim]) && parse_number(fields[1], hi_bound[dim]);
+                        if (!valid || (num_fields == 3 && !parse_number(fields[2], tilt[dim])))
+                        {
+                            error = "Invalid box bounds '" + std::string(value) + "'";
+                            return false;
+                        }
+                    }
+
+                    const double xy = tilt[0], xz = tilt[1], yz = tilt[2];
+                    double xlo = lo_bound[0] - std::min({0.0, xy, xz, xy + xz});
+                    double xhi = hi_bound[0] - std::max({0.0, xy, xz, xy + xz});
+                    double ylo = lo_bound[1] - std::min(0.0, yz);
+                    double yhi = hi_bound[1] - std::max(0.0, yz);
+
+                    header.box.origin = vec<graph_precision_type>();
+                    header.box.origin.x = xlo;
+                    header.box.origin.y = ylo;
+                    header.box.origin.z = lo_bound[2];
+                    header.box.basis.assign(3, vec<graph_precision_type>());
+                    header.box.basis[0].x = xhi - xlo;
+                    header.box.basis[1].x = xy;
+                    header.box.basis[1].y = yhi - ylo;
+                    header.box.basis[2].x = xz;
+                    header.box.basis[2].y = yz;
+                    header.box.basis[2].z = hi_bound[2] - lo_bound[2];
+                    header.has_box = true;
+                }
+
+                if (!next_non_blank_line(reader, line))
+                {
+                    error = "Unexpected end of the dump after '" + std::string(value) + "'";
+                    return false;
+                }
+            }
+        }
+
+        size_t find_column(const std::vector<std::string> &columns, const char *name)
+        {
+            for (size_t c = 0; c < columns.size(); c++)
+            {
+                if (columns[c] == name)
+                {
+                    return c;
+                }
+            }
+            return no_column;
+        }
+    }
+
+    bool TextLineReader::open(const std::string &path)
+    {
+        in.close();
+        in.clear();
+        in.open(path, std::ios::binary);
+        buffer.resize(1 << 22);
+        begin = 0;
+        end = 0;
+        at_eof = !in.is_open();
+        return in.is_open();
+    }
+
+    bool TextLineReader::fill()
+    {
+        if (at_eof)
+        {
+            return false;
+        }
+
+        if (begin > 0)
+        {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (end == buffer.size())
+        {
+            buffer.resize(2 * buffer.size());
+        }
+
+        in.read(buffer.data() + end, buffer.size() - end);
+        size_t num_read = in.gcount();
+        end += num_read;
+        if (!in)
+        {
+            at_eof = true;
+        }
+        return num_read > 0;
+    }
+
+    bool TextLineReader::next_line(const char *&line_begin, const char *&line_end)
+    {
+        size_t scanned = 0;
+        while (true)
+        {
+            const char *line_break = static_cast<const char *>(std::memchr(buffer.data() + begin + scanned, '\n', end - begin - scanned));
+            if (line_break != nullptr)
+            {
+                line_begin = buffer.data() + begin;
+                line_end = line_break;
+                begin = line_break + 1 - buffer.data();
+                break;
+            }
+
+            scanned = end - begin;
+            if (!fill())
+            {
+                if (begin == end)
+                {
+                    return false;
+                }
+                // Last line without a line break
+                line_begin = buffer.data() + begin;
+                line_end = buffer.data() + end;
+                begin = end;
+                break;
+            }
+        }
+
+        if (line_end > line_begin && *(line_end - 1) == '\r')
+        {
+            line_end--;
+        }
+        return true;
+    }
+
+    bool TextLineReader::next_lines(size_t num_lines, const char *&block_begin, const char *&block_end)
+    {
+        size_t scanned = 0;
+        size_t lines_found = 0;
+        while (lines_found < num_lines)
+        {
+            const char *line_break = static_cast<const char *>(std::memchr(buffer.data() + begin + scanned, '\n', end - begin - scanned));
+            if (line_break != nullptr)
+            {
+                lines_found++;
+                scanned = line_break + 1 - (buffer.data() + begin);
+                continue;
+            }
+
+            if (!fill())
+            {
+                // Last line without a line break
+                if (lines_found + 1 == num_lines && begin + scanned < end)
+                {
+                    scanned = end - begin;
+                    break;
+                }
+                return false;
+            }
+        }
+
+        block_begin = buffer.data() + begin;
+        block_end = buffer.data() + begin + scanned;
+        begin += scanned;
+        return true;
+    }
+
+    bool read_lammps_data(const std::string &path, MolecularGraph &graph, LammpsAtomInfo *atom_info, std::string *error_message)
+    {
+        std::string error;
+        auto fail = [&](const std::string &message) {
+            if (error_message != nullptr)
+            {
+                *error_message = message;
+            }
+            return false;
+        };
+
+        TextLineReader reader;
+        if (!reader.open(path))
+        {
+            return fail("Could not open " + path);
+        }
+
+        // The first line is a comment
+        const char *line_begin;
+        const char *line_end;
+        if (!reader.next_line(line_begin, line_end))
+        {
+            return fail("Empty data file");
+        }
+
+        // Header lines are of the form "<values> <keywords>", the first line starting with a letter opens a section
+        size_t num_atoms = 0, num_bonds = 0;
+        double lo[3] = {0.0, 0.0, 0.0}, hi[3] = {0.0, 0.0, 0.0}, tilt[3] = {0.0, 0.0, 0.0};
+        std::string_view line;
+        std::string_view fields[max_fields];
+        bool has_section = false;
+        while (next_non_blank_line(reader, line))
+        {
+            if (!(std::isdigit((unsigned char)line[0]) || line[0] == '-' || line[0] == '+' || line[0] == '.'))
+            {
+                has_section = true;
+                break;
+            }
+            size_t num_fields = std::min(split_fields(line.data(), line.data() + line.size(), fields), max_fields);
+            bool valid = true;
+            if (num_fields == 2 && fields[1] == "atoms")
+            {
+                valid = parse_number(fields[0], num_atoms);
+            }
+            else if (num_fields == 2 && fields[1] == "bonds")
+            {
+                valid = parse_number(fields[0], num_bonds);
+            }
+            else if (num_fields == 4 && (fields[2] == "xlo" || fields[2] == "ylo" || fields[2] == "zlo"))
+            {
+                size_t dim = fields[2][0] - 'x';
+                valid = parse_number(fields[0], lo[dim]) && parse_number(fields[1], hi[dim]);
+            }
+            else if (num_fields == 6 && fields[3] == "xy")
+            {
+                valid = parse_number(fields[0], tilt[0]) && parse_number(fields[1], tilt[1]) && parse_number(fields[2], tilt[2]);
+            }
+            if (!valid)
+            {
+                return fail("Invalid header line '" + std::string(line) + "'");
+            }
+        }
+
+        LammpsBox box;
+        box.origin.x = lo[0];
+        box.origin.y = lo[1];
+        box.origin.z = lo[2];
+        box.basis[0].x = hi[0] - lo[0];
+        box.basis[1].x = tilt[0];
+        box.basis[1].y = hi[1] - lo[1];
+        box.basis[2].x = tilt[1];
+        box.basis[2].y = tilt[2];
+        box.basis[2].z = hi[2] - lo[2];
+
+        LammpsAtomInfo rows;
+        std::vector<vec<graph_precision_type>> positions;
+        std::vector<int64_t> bond_ids;
+        bool has_atoms = false;
+        const size_t num_threads = graph.get_num_threads();
+
+        while (has_section)
+        {
+            size_t comment = line.find('#');
+            std::string_view keyword = trim(line.substr(0, comment));
+            std::string section(keyword);
+            std::string style(comment == std::string_view::npos ? std::string_view() : trim(line.substr(comment + 1)));
+
+            // The section body follows after a blank line, which may move the buffer of the reader
+            if (!reader.next_line(line_begin, line_end) || !trim(std::string_view(line_begin, line_end - line_begin)).empty())
+            {
+                return fail("Expected a blank line after the " + section + " section header");
+            }
+
+            if (section == "Atoms" || section == "Bonds")
+            {
+                size_t num_lines = (section == "Atoms" ? num_atoms : num_bonds);
+                const char *block_begin;
+                const char *block_end;
+                if (!reader.next_lines(num_lines, block_begin, block_end))
+                {
+                    return fail("Unexpected end of the file in the " + section + " section");
+                }
+
+                if (section == "Atoms")
+                {
+                    // Derive the columns from the atom style, or from the number of columns without style comment
+                    size_t num_columns = 0;
+                    if (num_lines > 0)
+                    {
+                        const char *first_end = static_cast<const char *>(std::memchr(block_begin, '\n', block_end - block_begin));
+                        num_columns = split_fields(block_begin, (first_end == nullptr ? block_end : first_end), fields);
+                    }
+                    if (style.empty())
+                    {
+                        style = (num_columns == 5 || num_columns == 8 ? "atomic" : (num_columns == 6 || num_columns == 9 ? "molecular" : "full"));
+                    }
+
+                    AtomColumns columns;
+                    columns.id = 0;
+                    size_t first_pos;
+                    if (style == "atomic")
+                    {
+                        columns.type = 1;
+                        first_pos = 2;
+                    }
+                    else if (style == "charge")
+                    {
+                        columns.type = 1;
+                        first_pos = 3;
+                    }
+                    else if (style == "bond" || style == "angle" || style == "molecular")
+                    {
+                        columns.type = 2;
+                        first_pos = 3;
+                    }
+                    else if (style == "full")
+                    {
+                        columns.type = 2;
+                        first_pos = 4;
+                    }
+                    else
+                    {
+                        return fail("Unsupported atom style '" + style + "'");
+                    }
+                    columns.num_required = first_pos + 3;
+                    for (size_t dim = 0; dim < 3; dim++)
+                    {
+                        columns.pos[dim] = first_pos + dim;
+                        if (num_columns >= first_pos + 6)
+                        {
+                            columns.image[dim] = first_pos + 3 + dim;
+                        }
+                    }
+                    if (num_columns >= first_pos + 6)
+                    {
+                        columns.num_required = first_pos + 6;
+                    }
+
+                    if (!parse_atom_block(block_begin, block_end, num_lines, columns, box, num_threads, rows, positions, error))
+                    {
+                        return fail(error);
+                    }
+                    has_atoms = true;
+                }
+                else if (!parse_bond_block(block_begin, block_end, num_lines, 2, 3, num_threads, bond_ids, error))
+                {
+                    return fail(error);
+                }
+            }
+            else
+            {
+                // Skip the body of all other sections
+                while (reader.next_line(line_begin, line_end) && !trim(std::string_view(line_begin, line_end - line_begin)).empty())
+                {
+                }
+            }
+
+            has_section = next_non_blank_line(reader, line);
+        }
+
+        if (!has_atoms && num_atoms > 0)
+        {
+            return fail("Missing Atoms section");
+        }
+
+        std::vector<size_t> atom_order, id_lookup;
+        if (!fill_atoms(rows, positions, box, graph, atom_order, id_lookup, error) || !add_bonds(bond_ids, rows.ids, id_lookup, graph, error))
+        {
+            return fail(error);
+        }
+        if (atom_info != nullptr)
+        {
+            *atom_info = std::move(rows);
+            atom_info->timestep = 0;
+        }
+        return true;
+    }
+
+    bool LammpsDumpReader::open(const std::string &path, const std::string &bond_dump_path)
+    {
+        error.clear();
+        read_bonds = !bond_dump_path.empty();
+        if (!atom_reader.open(path))
+        {
+            error = "Could not open " + path;
+            return false;
+        }
+        if (read_bonds && !bond_reader.open(bond_dump_path))
+        {
+            error = "Could not open " + bond_dump_path;
+            return false;
+        }
+        return true;
+    }
+
+    bool LammpsDumpReader::read_next_frame(MolecularGraph &frame, LammpsAtomInfo *atom_info)
+    {
+        error.clear();
+        DumpHeader header;
+        if (!read_dump_header(atom_reader, header, error))
+        {
+            return false;
+        }
+        if (!header.has_box)
+        {
+            error = "Missing box bounds in the dump";
+            return false;
+        }
+
+        // Prefer wrapped over unwrapped over scaled positions
+        AtomColumns columns;
+        columns.id = find_column(header.columns, "id");
+        columns.type = find_column(header.columns, "type");
+        const char *position_names[4][3] = {{"x", "y", "z"}, {"xu", "yu", "zu"}, {"xs", "ys", "zs"}, {"xsu", "ysu", "zsu"}};
+        for (size_t option = 0; option < 4 && columns.pos[0] == no_column; option++)
+        {
+            for (size_t dim = 0; dim < 3; dim++)
+            {
+                columns.pos[dim] = find_column(header.columns, position_names[option][dim]);
+            }
+            if (columns.pos[1] == no_column || columns.pos[2] == no_column)
+            {
+                columns.pos[0] = no_column;
+            }
+            columns.scaled = (option >= 2);
+
+            // Image flags only apply to wrapped positions
+            if (columns.pos[0] != no_column && (option == 0 || option == 2))
+            {
+                const char *image_names[3] = {"ix", "iy", "iz"};
+                for (size_t dim = 0; dim < 3; dim++)
+                {
+                    columns.image[dim] = find_column(header.columns, image_names[dim]);
+                }
+                if (columns.image[0] == no_column || columns.image[1] == no_column || columns.image[2] == no_column)
+                {
+                    columns.image[0] = columns.image[1] = columns.image[2] = no_column;
+                }
+            }
+        }
+        if (columns.id == no_column || columns.pos[0] == no_column)
+        {
+            error = "The dump needs the columns id and x y z, xu yu zu, xs ys zs or xsu ysu zsu";
+            return false;
+        }
+        columns.num_required = header.columns.size();
+
+        const char *block_begin;
+        const char *block_end;
+        if (!atom_reader.next_lines(header.num_rows, block_begin, block_end))
+        {
+            error = "Unexpected end of the dump in the atoms of timestep " + std::to_string(header.timestep);
+            return false;
+        }
+        const size_t num_threads = frame.get_num_threads();
+        if (!parse_atom_block(block_begin, block_end, header.num_rows, columns, header.box, num_threads, frame_info, positions, error) ||
+            !fill_atoms(frame_info, positions, header.box, frame, atom_order, id_lookup, error))
+        {
+            return false;
+        }
+        frame_info.timestep = header.timestep;
+
+        if (read_bonds)
+        {
+            DumpHeader bond_header;
+            if (!read_dump_header(bond_reader, bond_header, error))
+            {
+                if (error.empty())
+                {
+                    error = "The bond dump ends before timestep " + std::to_string(header.timestep);
+                }
+                return false;
+            }
+            if (bond_header.timestep != header.timestep)
+            {
+                error = "Timestep " + std::to_string(bond_header.timestep) + " of the bond dump does not match timestep " + std::to_string(header.timestep);
+                return false;
+            }
+
+            size_t atom_columns[2] = {no_column, no_column};
+            for (size_t c = 0, found = 0; c < bond_header.columns.size() && found < 2; c++)
+            {
+                if (bond_header.columns[c] != "index")
+                {
+                    atom_columns[found++] = c;
+                }
+            }
+            if (atom_columns[1] == no_column)
+            {
+                error = "The bond dump needs two columns with atom ids";
+                return false;
+            }
+
+            if (!bond_reader.next_lines(bond_header.num_rows, block_begin, block_end))
+            {
+                error = "Unexpected end of the bond dump in timestep " + std::to_string(header.timestep);
+                return false;
+            }
+            if (!parse_bond_block(block_begin, block_end, bond_header.num_rows, atom_columns[0], atom_columns[1], num_threads, bond_ids, error) ||
+                !add_bonds(bond_ids, frame_info.ids, id_lookup, frame, error))
+            {
+                return false;
+            }
+        }
+
+        if (atom_info != nullptr)
+        {
+            *atom_info = frame_info;
+        }
+        return true;
+    }
+
+    const std::string &LammpsDumpReader::get_error() const
+    {
+        return error;
+    }
+}
\ No newline at end of file
@@ -27,9 +27,36 @@
  */
 
 #include "molecular-graph.hpp"
+#include "coordinate-kernels.hpp"
+#include "thread-pool.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace mol
 {
+    namespace
+    {
+        /**
+         * @brief Number of atoms converted as one task by fill_percolation_graph()
+         */
+        const size_t conversion_block_size = 4096;
+
+        vec<graph_precision_type> cross(const vec<graph_precision_type> &a, const vec<graph_precision_type> &b)
+        {
+            vec<graph_precision_type> res;
+            res.x = a.y * b.z - a.z * b.y;
+            res.y = a.z * b.x - a.x * b.z;
+            res.z = a.x * b.y - a.y * b.x;
+            return res;
+        }
+    }
+
+    ConversionWorkspace::ConversionWorkspace(std::pmr::memory_resource *resource)
+        : coeff_x(resource), coeff_y(resource), coeff_z(resource), block_offsets(resource), bond_base(resource), bond_head(resource),
+          trans_x(resource), trans_y(resource), trans_z(resource)
+    {
+    }
 
     MolecularGraph::MolecularGraph() : MolecularGraph(0) {}
     MolecularGraph::MolecularGraph(size_t num_atoms)
@@ -77,75 +104,335 @@ namespace mol
         return true;
     }
 
-    percolation::PercolationGraph MolecularGraph::get_percolation_graph() const
+    bool MolecularGraph::add_bonds_within_cutoff(graph_precision_type cutoff, const BondFilter &filter)
     {
-        percolation::PercolationGraph res;
-        // Resize the percolation graph appropriately
-        res.reserve_vertices(n_atoms);
+        if (triclinic_basis.size() != 3 || !(cutoff > 0.0))
+        {
+            return false;
+        }
 
-        // Transform all positions into normalized basis components
-        // This is equivalent to moving them all into one pbc cell and transforming the coordinates
-        // into cuboid shape, which makes everything simpler.
-        std::vector<vec<graph_precision_type>> normalized_positions(n_atoms);
-        for (size_t base = 0; base < n_atoms; base++)
+        // The number of cells along each basis vector is limited by the width of the pbc cell perpendicular to the other two,
+        // so that all atoms within the cutoff of an atom lie in the neighboring cells
+        const graph_precision_type volume = std::abs(triclinic_basis[0][0] * triclinic_basis[1][1] * triclinic_basis[2][2]);
+        size_t num_cells_dim[3];
+        for (size_t dim = 0; dim < 3; dim++)
         {
-            normalized_positions[base] = normalize_basis_coefficients(decompose(atom_positions[base], triclinic_basis));
+            graph_precision_type width = volume / cross(triclinic_basis[(dim + 1) % 3], triclinic_basis[(dim + 2) % 3]).norm();
+            if (2.0 * cutoff >= width)
+            {
+                return false;
+            }
+            num_cells_dim[dim] = size_t(width / cutoff);
         }
 
-        // Parse the edges to be added:
-        for (size_t base = 0; base < n_atoms; base++)
+        // Do not use (many) more cells than atoms for very small cutoffs
+        const graph_precision_type max_cells = graph_precision_type(n_atoms > 27 ? n_atoms : 27);
+        graph_precision_type total_cells = graph_precision_type(num_cells_dim[0]) * graph_precision_type(num_cells_dim[1]) * graph_precision_type(num_cells_dim[2]);
+        if (total_cells > max_cells)
         {
-            const vec<graph_precision_type> &b_pos = normalized_positions[base];
-            for (size_t n = 0; n < bonds[base].size(); n++)
+            graph_precision_type scale = std::cbrt(max_cells / total_cells);
+            for (size_t dim = 0; dim < 3; dim++)
+            {
+                num_cells_dim[dim] = std::max<size_t>(1, size_t(graph_precision_type(num_cells_dim[dim]) * scale));
+            }
+        }
+        const size_t num_cells = num_cells_dim[0] * num_cells_dim[1] * num_cells_dim[2];
+
+        // Basis coordinates of all atoms moved into [0,1) and their cells
+        std::vector<vec<graph_precision_type>> fractional(n_atoms);
+        std::vector<size_t> atom_cell(n_atoms);
+        const size_t block_size = 4096;
+        percolation::parallel_for_dynamic((n_atoms + block_size - 1) / block_size, num_threads, 1, [&](size_t block, size_t) {
+            size_t block_end = std::min(n_atoms, (block + 1) * block_size);
+            for (size_t atom = block * block_size; atom < block_end; atom++)
             {
-                size_t head = bonds[base][n];
-                if (head < base)
+                vec<graph_precision_type> coeff = decompose(atom_positions[atom], triclinic_basis);
+                size_t cell = 0;
+                for (size_t dim = 0; dim < 3; dim++)
                 {
-                    // Both directions of the edge were created, we only need to consider one.
-                    continue;
+                    coeff[dim] -= std::floor(coeff[dim]);
+                    size_t cell_dim = std::min(size_t(coeff[dim] * graph_precision_type(num_cells_dim[dim])), num_cells_dim[dim] - 1);
+                    cell = cell * num_cells_dim[dim] + cell_dim;
                 }
+                fractional[atom] = coeff;
+                atom_cell[atom] = cell;
+            }
+        });
 
-                const vec<graph_precision_type> &h_pos = normalized_positions[head];
+        // Sort the atoms into their cells, keeping them in increasing index order within each cell
+        std::vector<size_t> cell_offsets(num_cells + 1, 0);
+        for (size_t atom = 0; atom < n_atoms; atom++)
+        {
+            cell_offsets[atom_cell[atom] + 1]++;
+        }
+        for (size_t cell = 0; cell < num_cells; cell++)
+        {
+            cell_offsets[cell + 1] += cell_offsets[cell];
+        }
+        std::vector<size_t> cell_atoms(n_atoms);
+        {
+            std::vector<size_t> cursor(cell_offsets.begin(), cell_offsets.end() - 1);
+            for (size_t atom = 0; atom < n_atoms; atom++)
+            {
+                cell_atoms[cursor[atom_cell[atom]]++] = atom;
+            }
+        }
+
+        // Every thread collects the pairs it finds, the range of each cell is recorded to add them in cell order afterwards
+        struct CellPairs
+        {
+            size_t thread_index;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<std::vector<std::pair<size_t, size_t>>> thread_pairs(percolation::resolve_thread_count(num_threads));
+        std::vector<CellPairs> cell_pairs(num_cells);
+        const graph_precision_type cutoff2 = cutoff * cutoff;
+
+        percolation::parallel_for_dynamic(num_cells, num_threads, 64, [&](size_t cell, size_t thread_index) {
+            std::vector<std::pair<size_t, size_t>> &pairs = thread_pairs[thread_index];
+            cell_pairs[cell].thread_index = thread_index;
+            cell_pairs[cell].begin = pairs.size();
 
-                // Let us build the correct translation vector
-                percolation::TranslationVector trans;
+            // The neighboring cells, each listed once even if there are fewer than three cells along a direction
+            size_t cell_coord[3] = {cell / (num_cells_dim[1] * num_cells_dim[2]), (cell / num_cells_dim[2]) % num_cells_dim[1], cell % num_cells_dim[2]};
+            size_t neighbors[27];
+            size_t num_neighbors = 0;
+            for (size_t offset = 0; offset < 27; offset++)
+            {
+                size_t neighbor = 0;
+                size_t remaining_offset = offset;
+                for (size_t dim = 0; dim < 3; dim++)
+                {
+                    size_t shift = remaining_offset % 3;
+                    remaining_offset /= 3;
+                    size_t neighbor_dim = (cell_coord[dim] + shift + num_cells_dim[dim] - 1) % num_cells_dim[dim];
+                    neighbor = neighbor * num_cells_dim[dim] + neighbor_dim;
+                }
+                neighbors[num_neighbors++] = neighbor;
+            }
+            std::sort(neighbors, neighbors + num_neighbors);
+            num_neighbors = std::unique(neighbors, neighbors + num_neighbors) - neighbors;
 
-                for (size_t dim = 0; dim < vector_space_dimension; dim++)
+            for (size_t a = cell_offsets[cell]; a < cell_offsets[cell + 1]; a++)
+            {
+                size_t atom = cell_atoms[a];
+                const vec<graph_precision_type> &atom_coeff = fractional[atom];
+                for (size_t n = 0; n < num_neighbors; n++)
                 {
-                    if (b_pos[dim] < h_pos[dim])
+                    for (size_t b = cell_offsets[neighbors[n]]; b < cell_offsets[neighbors[n] + 1]; b++)
                     {
-                        // The base lies below the head in the cell
-                        if (h_pos[dim] - b_pos[dim] > 0.5)
-                        {
-                            // The shorter connection intersects the cell boundary going down from the base
-                            trans[dim] = -1;
-                        }
-                        else
+                        size_t other = cell_atoms[b];
+                        if (other <= atom)
                         {
-                            // The connection is within the cell
-                            trans[dim] = 0;
+                            // Every pair is found from both cells, only keep it once
+                            continue;
                         }
-                    }
-                    else
-                    {
-                        // Need to check edge crossing the other way around
-                        // The base lies below the head in the cell
-                        if (b_pos[dim] - h_pos[dim] > 0.5)
+
+                        // Shortest connection respecting the pbc
+                        vec<graph_precision_type> diff = fractional[other] - atom_coeff;
+                        for (size_t dim = 0; dim < 3; dim++)
                         {
-                            // The shorter connection intersects the cell boundary going up from the base
-                            trans[dim] = +1;
+                            diff[dim] -= std::round(diff[dim]);
                         }
-                        else
+                        vec<graph_precision_type> per_diff = triclinic_basis[0] * diff[0] + triclinic_basis[1] * diff[1] + triclinic_basis[2] * diff[2];
+                        if (per_diff.norm2() < cutoff2 && (!filter || filter(atom, other)))
                         {
-                            // The connection is within the cell
-                            trans[dim] = 0;
+                            pairs.emplace_back(atom, other);
                         }
                     }
                 }
-                res.add_edge(base, head, trans);
             }
+            cell_pairs[cell].end = pairs.size();
+        });
+
+        for (size_t cell = 0; cell < num_cells; cell++)
+        {
+            const std::vector<std::pair<size_t, size_t>> &pairs = thread_pairs[cell_pairs[cell].thread_index];
+            for (size_t p = cell_pairs[cell].begin; p < cell_pairs[cell].end; p++)
+            {
+                bonds[pairs[p].first].push_back(pairs[p].second);
+                bonds[pairs[p].second].push_back(pairs[p].first);
+            }
+        }
+        return true;
+    }
+
+    void MolecularGraph::set_num_threads(size_t num_threads)
+    {
+        this->num_threads = num_threads;
+    }
+
+    size_t MolecularGraph::get_num_threads() const
+    {
+        return num_threads;
+    }
+
+    size_t MolecularGraph::get_atom_count() const
+    {
+        return n_atoms;
+    }
+
+    void MolecularGraph::clear_bonds()
+    {
+        for (std::vector<size_t> &atom_bonds : bonds)
+        {
+            atom_bonds.clear();
         }
+    }
+
+    const std::vector<vec<graph_precision_type>> &MolecularGraph::get_basis() const
+    {
+        return triclinic_basis;
+    }
+
+    const std::vector<vec<graph_precision_type>> &MolecularGraph::get_atom_positions() const
+    {
+        return atom_positions;
+    }
+
+    const std::vector<size_t> &MolecularGraph::get_bonds(size_t atom_index) const
+    {
+        return bonds[atom_index];
+    }
 
+    void MolecularGraph::set_statistics(percolation::AnalysisStatistics *statistics)
+    {
+        this->statistics = statistics;
+    }
+
+    percolation::PercolationGraph MolecularGraph::get_percolation_graph(std::pmr::memory_resource *resource) const
+    {
+        percolation::PercolationGraph res(resource);
+        ConversionWorkspace workspace(resource);
+        fill_percolation_graph(res, workspace);
         return res;
     }
+
+    void MolecularGraph::fill_percolation_graph(percolation::PercolationGraph &res, ConversionWorkspace &workspace) const
+    {
+        // Resize the percolation graph appropriately
+        res.reset();
+        res.reserve_vertices(n_atoms);
+
+        const size_t num_bonds = collect_bonds(workspace);
+        PERCOLATION_STAT(percolation::PhaseClock clock(statistics);)
+        const int8_t *bond_trans[3] = {workspace.trans_x.data(), workspace.trans_y.data(), workspace.trans_z.data()};
+        res.build_from_edge_arrays(workspace.bond_base.data(), workspace.bond_head.data(), bond_trans, num_bonds);
+        PERCOLATION_STAT(clock.stop(&percolation::AnalysisStatistics::graph_build_time);)
+    }
+
+    bool MolecularGraph::fill_percolation_graph(percolation::CompactPercolationGraph &res, ConversionWorkspace &workspace) const
+    {
+        res.reset();
+        if (!res.reserve_vertices(n_atoms))
+        {
+            return false;
+        }
+
+        const size_t num_bonds = collect_bonds(workspace);
+        PERCOLATION_STAT(percolation::PhaseClock clock(statistics);)
+        res.reserve_edges(num_bonds);
+        percolation::BasicTranslationVector<vector_space_dimension, int8_t> trans;
+        const int8_t *bond_trans[3] = {workspace.trans_x.data(), workspace.trans_y.data(), workspace.trans_z.data()};
+        for (size_t b = 0; b < num_bonds; b++)
+        {
+            for (size_t dim = 0; dim < vector_space_dimension; dim++)
+            {
+                trans.vec[dim] = bond_trans[dim][b];
+            }
+            // Bonds never cross more than one cell boundary per axis, so the translation always fits
+            res.add_edge(workspace.bond_base[b], workspace.bond_head[b], trans);
+        }
+        PERCOLATION_STAT(clock.stop(&percolation::AnalysisStatistics::graph_build_time);)
+        return true;
+    }
+
+    size_t MolecularGraph::collect_bonds(ConversionWorkspace &workspace) const
+    {
+        PERCOLATION_STAT(percolation::PhaseClock clock(statistics);)
+        PERCOLATION_STAT(percolation::BufferWatch buffers;)
+        PERCOLATION_STAT(buffers.add(workspace.coeff_x); buffers.add(workspace.coeff_y); buffers.add(workspace.coeff_z); buffers.add(workspace.block_offsets);)
+        PERCOLATION_STAT(buffers.add(workspace.bond_base); buffers.add(workspace.bond_head);)
+        PERCOLATION_STAT(buffers.add(workspace.trans_x); buffers.add(workspace.trans_y); buffers.add(workspace.trans_z);)
+
+        // The atoms are processed in blocks, which are distributed among the threads
+        const size_t num_blocks = (n_atoms + conversion_block_size - 1) / conversion_block_size;
+
+        // Transform all positions into normalized basis components
+        // This is equivalent to moving them all into one pbc cell and transforming the coordinates
+        // into cuboid shape, which makes everything simpler.
+        // At the same time count the bonds of each block, considering every bond only once
+        workspace.coeff_x.resize(n_atoms);
+        workspace.coeff_y.resize(n_atoms);
+        workspace.coeff_z.resize(n_atoms);
+        workspace.block_offsets.assign(num_blocks + 1, 0);
+        percolation::parallel_for_dynamic(num_blocks, num_threads, 1, [&](size_t block, size_t) {
+            size_t begin = block * conversion_block_size;
+            size_t end = std::min(n_atoms, begin + conversion_block_size);
+            normalize_positions(atom_positions.data() + begin, end - begin, triclinic_basis,
+                                workspace.coeff_x.data() + begin, workspace.coeff_y.data() + begin, workspace.coeff_z.data() + begin);
+
+            size_t num_block_bonds = 0;
+            for (size_t base = begin; base < end; base++)
+            {
+                for (size_t head : bonds[base])
+                {
+                    // Both directions of the edge were created, we only need to consider one.
+                    num_block_bonds += (head >= base ? 1 : 0);
+                }
+            }
+            workspace.block_offsets[block + 1] = num_block_bonds;
+        });
+
+        // The bonds of each block start after the ones of all previous blocks, so the edge order does not depend on the threads
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            workspace.block_offsets[block + 1] += workspace.block_offsets[block];
+        }
+        const size_t num_bonds = workspace.block_offsets[num_blocks];
+        PERCOLATION_STAT(clock.stop(&percolation::AnalysisStatistics::normalization_time);)
+
+        workspace.bond_base.resize(num_bonds);
+        workspace.bond_head.resize(num_bonds);
+        workspace.trans_x.resize(num_bonds);
+        workspace.trans_y.resize(num_bonds);
+        workspace.trans_z.resize(num_bonds);
+
+        percolation::parallel_for_dynamic(num_blocks, num_threads, 1, [&](size_t block, size_t) {
+            size_t begin = block * conversion_block_size;
+            size_t end = std::min(n_atoms, begin + conversion_block_size);
+            const size_t bonds_begin = workspace.block_offsets[block];
+            const size_t bonds_end = workspace.block_offsets[block + 1];
+
+            // Collect every bond once
+            size_t curr_bond = bonds_begin;
+            for (size_t base = begin; base < end; base++)
+            {
+                for (size_t head : bonds[base])
+                {
+                    if (head < base)
+                    {
+                        continue;
+                    }
+                    workspace.bond_base[curr_bond] = base;
+                    workspace.bond_head[curr_bond] = head;
+                    curr_bond++;
+                }
+            }
+
+            // Let us build the correct translation vectors
+            compute_bond_translations(workspace.coeff_x.data(), workspace.coeff_y.data(), workspace.coeff_z.data(), workspace.bond_base.data() + bonds_begin, workspace.bond_head.data() + bonds_begin,
+                                      bonds_end - bonds_begin, workspace.trans_x.data() + bonds_begin, workspace.trans_y.data() + bonds_begin, workspace.trans_z.data() + bonds_begin);
+        });
+        PERCOLATION_STAT(clock.stop(&percolation::AnalysisStatistics::translation_time);)
+#ifdef PERCOLATION_STATISTICS
+        if (statistics != nullptr)
+        {
+            statistics->num_bonds_converted += num_bonds;
+            statistics->allocations += buffers.count_allocations();
+        }
+#endif
+        return num_bonds;
+    }
 }
\ No newline at end of file
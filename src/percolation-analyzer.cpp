@@ -29,11 +29,15 @@
 #include "percolation-analyzer.h"
 #include "percolation-detection.hpp"
 
+#include <algorithm>
+
 extern "C"
 {
     struct PercolationAnalyzer
     {
         percolation::PercolationGraph graph;
+        percolation::PercolationGraph::AnalysisWorkspace workspace;
+        percolation::ComponentLabels labels;
     };
 
     struct PercolationAnalyzer *create_PercolationAnalyzer()
@@ -48,6 +52,12 @@ extern "C"
             delete ptr;
     }
 
+    void reset_PercolationAnalyzer(struct PercolationAnalyzer *ptr)
+    {
+        if (ptr != nullptr)
+            ptr->graph.reset();
+    }
+
     void add_edge(struct PercolationAnalyzer *ptr, size_t source_node, size_t head_node, struct EdgeData *edge)
     {
         if (ptr == nullptr || edge == nullptr)
@@ -80,6 +90,38 @@ extern "C"
         graph.add_edge(source_node, head_node, tv);
     }
 
+    int add_edges(struct PercolationAnalyzer *ptr, size_t num_edges, const int64_t *source_nodes, const int64_t *head_nodes, const int64_t *translations)
+    {
+        if (ptr == nullptr || (num_edges > 0 && (source_nodes == nullptr || head_nodes == nullptr || translations == nullptr)))
+        {
+            return 0;
+        }
+
+        int64_t max_index = -1;
+        for (size_t e = 0; e < num_edges; e++)
+        {
+            if (source_nodes[e] < 0 || head_nodes[e] < 0)
+            {
+                return 0;
+            }
+            max_index = (source_nodes[e] > max_index ? source_nodes[e] : max_index);
+            max_index = (head_nodes[e] > max_index ? head_nodes[e] : max_index);
+        }
+
+        percolation::PercolationGraph &graph = ptr->graph;
+        graph.reserve_vertices(size_t(max_index + 1));
+        percolation::TranslationVector tv;
+        for (size_t e = 0; e < num_edges; e++)
+        {
+            for (size_t i = 0; i < vector_space_dimension; i++)
+            {
+                tv[i] = translations[3 * e + i];
+            }
+            graph.add_edge(size_t(source_nodes[e]), size_t(head_nodes[e]), tv);
+        }
+        return 1;
+    }
+
     void reserve_memory(struct PercolationAnalyzer *ptr, size_t num_vertices)
     {
         if (ptr != nullptr)
@@ -99,6 +141,28 @@ extern "C"
         graph.add_vertex(vertex_index, vd);
     }
 
+    size_t get_component_labels(struct PercolationAnalyzer *ptr, size_t num_vertices, int64_t *component_label, size_t max_components, int64_t *component_dim)
+    {
+        if (ptr == nullptr)
+            return 0;
+
+        percolation::ComponentLabels &labels = ptr->labels;
+        ptr->graph.get_component_labels(labels, ptr->workspace);
+        const size_t num_components = labels.get_num_components();
+        if (component_label != nullptr)
+        {
+            size_t num_labeled = (num_vertices < labels.component_of.size() ? num_vertices : labels.component_of.size());
+            std::copy(labels.component_of.begin(), labels.component_of.begin() + num_labeled, component_label);
+            std::fill(component_label + num_labeled, component_label + num_vertices, int64_t(-1));
+        }
+        if (component_dim != nullptr)
+        {
+            size_t num_written = (max_components < num_components ? max_components : num_components);
+            std::copy(labels.percolation_dims.begin(), labels.percolation_dims.begin() + num_written, component_dim);
+        }
+        return num_components;
+    }
+
     struct PercolationInfo
     {
         std::vector<percolation::ComponentInfo> components;
@@ -106,20 +170,20 @@ extern "C"
         size_t next_component;
     };
 
-    struct PercolationInfo *getPercolationInfo(struct PercolationAnalyzer *ptr)
+    struct PercolationInfo *get_PercolationInfo(struct PercolationAnalyzer *ptr)
     {
         if (ptr == nullptr)
             return nullptr;
 
         struct PercolationInfo *res = new struct PercolationInfo;
 
-        res->components = ptr->graph.get_component_percolation_info();
+        res->components = ptr->graph.get_component_percolation_info(ptr->workspace);
         res->num_comps = res->components.size();
         res->next_component = 0;
         return res;
     }
 
-    void freePercolationInfo(struct PercolationInfo *ptr)
+    void free_PercolationInfo(struct PercolationInfo *ptr)
     {
         if (ptr != nullptr)
         {
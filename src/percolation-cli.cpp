@@ -0,0 +1,319 @@
+/*
+ * SPDX-FileCopyrightText: 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ *
+ * SPDX-License-Identifier: MIT
+ * 
+ * Copyright (c) 2020 Kevin Höllring for PULS Group <kevin.hoellring@fau.de>
+ * 
+ * Authors: 2020 Kevin Höllring <kevin.hoellring@fau.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the “Software”), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next paragraph) 
+ * shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, 
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE. 
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "frame-analysis.hpp"
+#include "frame-file.hpp"
+#include "lammps-reader.hpp"
+
+namespace
+{
+    const char *usage = R"(Usage: percolation-cli [options] (--data FILE | --dump FILE | --frames FILE)
+
+Streams the frames of a trajectory through a pipeline of reading, conversion, analysis and output and writes one line or record per frame.
+
+Input:
+  --data FILE             LAMMPS data file (a single frame)
+  --dump FILE             LAMMPS custom dump with the columns id and x y z (or xu yu zu, xs ys zs, xsu ysu zsu)
+  --bond-dump FILE        Local dump with the bonds of every timestep of --dump
+  --frames FILE           Binary frame file written by mol::FrameFileWriter
+  --cutoff R              Add bonds between all atoms closer than R
+
+Output:
+  --output FILE           Output file, standard output if not given
+  --format csv|binary     Output format (default csv)
+
+Pipeline:
+  --build-threads N       Threads converting frames into percolation graphs (default 1, 0 for all hardware threads)
+  --analysis-threads N    Threads analyzing percolation graphs (default 1, 0 for all hardware threads)
+  --queue N               Maximum number of frames waiting between two stages (default 4)
+
+Every frame produces the values
+  frame, timestep, num_atoms, num_components, max_percolation_dim, num_percolating_components, largest_component_size
+The csv format writes them as a header line followed by one line per frame. The binary format writes the 8 bytes "PERCRES1"
+followed by the values of every frame as 64 bit integers in the byte order of the machine.
+)";
+
+    /**
+     * @brief Parse a non-negative integer argument
+     */
+    bool parse_count(const char *text, size_t &value)
+    {
+        char *end;
+        unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || text[0] == '-')
+        {
+            return false;
+        }
+        value = size_t(parsed);
+        return true;
+    }
+}
+
+/**
+ * @brief Command line tool to analyze the percolation of every frame of a trajectory
+ * 
+ * @param argc 
+ * @param argv 
+ * @return int 
+ */
+int main(int argc, char *argv[])
+{
+    std::string data_path, dump_path, bond_dump_path, frames_path, output_path;
+    std::string format = "csv";
+    double cutoff = 0.0;
+    mol::PipelineOptions options;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::string name = argv[arg];
+        if (name == "--help" || name == "-h")
+        {
+            std::cout << usage;
+            return 0;
+        }
+        if (arg + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << name << std::endl
+                      << usage;
+            return 1;
+        }
+
+        const char *value = argv[++arg];
+        bool valid = true;
+        if (name == "--data")
+        {
+            data_path = value;
+        }
+        else if (name == "--dump")
+        {
+            dump_path = value;
+        }
+        else if (name == "--bond-dump")
+        {
+            bond_dump_path = value;
+        }
+        else if (name == "--frames")
+        {
+            frames_path = value;
+        }
+        else if (name == "--cutoff")
+        {
+            char *end;
+            cutoff = std::strtod(value, &end);
+            valid = (end != value && *end == '\0' && cutoff > 0.0);
+        }
+        else if (name == "--output")
+        {
+            output_path = value;
+        }
+        else if (name == "--format")
+        {
+            format = value;
+            valid = (format == "csv" || format == "binary");
+        }
+        else if (name == "--build-threads")
+        {
+            valid = parse_count(value, options.num_build_threads);
+        }
+        else if (name == "--analysis-threads")
+        {
+            valid = parse_count(value, options.num_analysis_threads);
+        }
+        else if (name == "--queue")
+        {
+            valid = parse_count(value, options.queue_capacity) && options.queue_capacity > 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << name << std::endl
+                      << usage;
+            return 1;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid value '" << value << "' for " << name << std::endl;
+            return 1;
+        }
+    }
+
+    if (int(!data_path.empty()) + int(!dump_path.empty()) + int(!frames_path.empty()) != 1)
+    {
+        std::cerr << "Exactly one of --data, --dump and --frames is required" << std::endl
+                  << usage;
+        return 1;
+    }
+
+    if (!bond_dump_path.empty() && dump_path.empty())
+    {
+        std::cerr << "--bond-dump can only be used together with --dump" << std::endl
+                  << usage;
+        return 1;
+    }
+
+    // Set up the source of the frames
+    mol::FrameSource source;
+    mol::LammpsDumpReader dump_reader;
+    mol::FrameFileReader frame_file_reader;
+    size_t next_frame = 0;
+    if (!data_path.empty())
+    {
+        source = [&](mol::MolecularGraph &frame, int64_t &timestep) {
+            if (next_frame++ > 0)
+            {
+                return false;
+            }
+            std::string error;
+            if (!mol::read_lammps_data(data_path, frame, nullptr, &error))
+            {
+                throw std::runtime_error(data_path + ": " + error);
+            }
+            timestep = 0;
+            return true;
+        };
+    }
+    else if (!dump_path.empty())
+    {
+        if (!dump_reader.open(dump_path, bond_dump_path))
+        {
+            std::cerr << dump_reader.get_error() << std::endl;
+            return 1;
+        }
+        source = [&](mol::MolecularGraph &frame, int64_t &timestep) {
+            mol::LammpsAtomInfo info;
+            if (!dump_reader.read_next_frame(frame, &info))
+            {
+                if (!dump_reader.get_error().empty())
+                {
+                    throw std::runtime_error(dump_path + ": " + dump_reader.get_error());
+                }
+                return false;
+            }
+            timestep = info.timestep;
+            return true;
+        };
+    }
+    else
+    {
+        if (!frame_file_reader.open(frames_path))
+        {
+            std::cerr << "Could not open the frame file " << frames_path << std::endl;
+            return 1;
+        }
+        source = [&](mol::MolecularGraph &frame, int64_t &) {
+            if (next_frame >= frame_file_reader.get_num_frames())
+            {
+                return false;
+            }
+            if (!frame_file_reader.read_frame(next_frame++, frame))
+            {
+                throw std::runtime_error(frames_path + ": invalid frame " + std::to_string(next_frame - 1));
+            }
+            return true;
+        };
+    }
+
+    if (cutoff > 0.0)
+    {
+        options.prepare_frame = [cutoff](mol::MolecularGraph &frame) {
+            if (!frame.add_bonds_within_cutoff(cutoff))
+            {
+                throw std::runtime_error("The cutoff needs to be smaller than half the width of the periodic cell");
+            }
+        };
+    }
+
+    // Set up the output
+    std::ofstream output_file;
+    if (!output_path.empty())
+    {
+        output_file.open(output_path, format == "binary" ? std::ios::binary : std::ios::out);
+        if (!output_file)
+        {
+            std::cerr << "Could not open the output file " << output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = (output_path.empty() ? std::cout : output_file);
+
+    if (format == "csv")
+    {
+        out << "frame,timestep,num_atoms,num_components,max_percolation_dim,num_percolating_components,largest_component_size\n";
+    }
+    else
+    {
+        out.write("PERCRES1", 8);
+    }
+
+    mol::FrameSink sink = [&](const mol::FrameResult &result, const mol::MolecularGraph &frame, int64_t timestep) {
+        int64_t values[7] = {int64_t(result.frame_index), timestep, int64_t(frame.get_atom_count()), int64_t(result.components.size()), int64_t(result.max_percolation_dim), 0, 0};
+        for (const percolation::ComponentInfo &component : result.components)
+        {
+            values[5] += (component.percolation_dim > 0 ? 1 : 0);
+            values[6] = std::max(values[6], int64_t(component.vertices.size()));
+        }
+
+        if (format == "csv")
+        {
+            for (size_t v = 0; v < 7; v++)
+            {
+                out << values[v] << (v + 1 < 7 ? ',' : '\n');
+            }
+        }
+        else
+        {
+            out.write(reinterpret_cast<const char *>(values), sizeof(values));
+        }
+        if (!out)
+        {
+            throw std::runtime_error("Could not write the output");
+        }
+    };
+
+    try
+    {
+        size_t num_frames = mol::run_frame_pipeline(source, sink, options);
+        out.flush();
+        std::cerr << "Analyzed " << num_frames << " frames" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
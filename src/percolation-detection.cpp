@@ -27,70 +27,105 @@
  */
 
 #include "percolation-detection.hpp"
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <limits>
 #include <queue>
 #include <set>
 #include <cassert>
 #include <sstream>
+#include <type_traits>
 namespace percolation
 {
-
-    struct TranslationVector TranslationVector::operator-() const
+    namespace
     {
-        TranslationVector res;
-        for (size_t i = 0; i < vector_space_dimension; i++)
-        {
-            res.vec[i] = -vec[i];
-        }
-        return res;
-    }
+        /**
+         * @brief Number of consecutive vertices handed to a thread at once by the parallel labeling
+         */
+        const size_t vertex_block_size = 4096;
 
-    struct TranslationVector TranslationVector::operator+(struct TranslationVector const &other) const
-    {
-        TranslationVector res;
-        for (size_t i = 0; i < vector_space_dimension; i++)
+        /**
+         * @brief Components below this size are never searched by more than one thread
+         */
+        const size_t parallel_bfs_min_size = 1024;
+
+        /**
+         * @brief Levels of the parallel bfs below this size are expanded by a single thread
+         */
+        const size_t parallel_level_min_size = 256;
+
+        /**
+         * @brief Number of consecutive vertices of a level of the parallel bfs handed to a thread at once
+         */
+        const size_t frontier_grain_size = 64;
+
+        /**
+         * @brief Find the root of a vertex in a concurrently modified union-find forest
+         * 
+         * Parents always have a smaller index than their children and are only ever replaced by one of their ancestors, 
+         * so the path halving below is safe even if other threads link or compress the same path.
+         */
+        size_t find_root(AtomicArray<size_t> &parents, size_t vertex)
         {
-            res.vec[i] = vec[i] + other.vec[i];
+            while (true)
+            {
+                size_t parent = parents[vertex].load(std::memory_order_relaxed);
+                if (parent == vertex)
+                {
+                    return vertex;
+                }
+                size_t grandparent = parents[parent].load(std::memory_order_relaxed);
+                if (grandparent != parent)
+                {
+                    parents[vertex].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                }
+                vertex = grandparent;
+            }
         }
-        return res;
-    }
 
-    struct TranslationVector TranslationVector::operator-(struct TranslationVector const &other) const
-    {
-        TranslationVector res;
-        for (size_t i = 0; i < vector_space_dimension; i++)
+        /**
+         * @brief Merge the trees of two vertices by hooking the larger root below the smaller one
+         */
+        void link_roots(AtomicArray<size_t> &parents, size_t vertex_a, size_t vertex_b)
         {
-            res.vec[i] = vec[i] - other.vec[i];
+            while (true)
+            {
+                size_t root_a = find_root(parents, vertex_a);
+                size_t root_b = find_root(parents, vertex_b);
+                if (root_a == root_b)
+                {
+                    return;
+                }
+                if (root_a < root_b)
+                {
+                    std::swap(root_a, root_b);
+                }
+
+                // Fails if another thread has linked root_a in the meantime, then try again from the new roots
+                size_t expected = root_a;
+                if (parents[root_a].compare_exchange_strong(expected, root_b, std::memory_order_relaxed))
+                {
+                    return;
+                }
+            }
         }
-        return res;
     }
 
-    bool TranslationVector::operator==(struct TranslationVector const &other) const
+    std::vector<ComponentInfo> ComponentLabels::to_component_info() const
     {
-        for (size_t i = 0; i < vector_space_dimension; i++)
+        std::vector<ComponentInfo> component_info(get_num_components());
+        for (size_t c = 0; c < component_info.size(); c++)
         {
-            if (vec[i] != other.vec[i])
+            component_info[c].component_index = c;
+            component_info[c].percolation_dim = percolation_dims[c];
+            component_info[c].vertices.resize(sizes[c]);
+            const size_t *comp_members = members.data() + offsets[c];
+            for (size_t m = 0; m < sizes[c]; m++)
             {
-                return false;
+                component_info[c].vertices[m].index = comp_members[m];
             }
         }
-        return true;
-    }
-
-    translation_coordinate_type &TranslationVector::operator[](size_t i)
-    {
-        return vec[i];
-    }
-
-    translation_coordinate_type TranslationVector::operator[](size_t i) const
-    {
-        return vec[i];
-    }
-
-    struct EdgeData EdgeData::inverse() const
-    {
-        EdgeData res(*this);
-        res.translation = -this->translation;
-        return res;
+        return component_info;
     }
 
     translation_coordinate_type det(const std::vector<std::vector<translation_coordinate_type>> &matrix)
@@ -135,182 +170,1158 @@ namespace percolation
         return res;
     }
 
-    bool check_translation_independent(const std::vector<TranslationVector> &existing_base, const TranslationVector &new_vector)
+    template <size_t Dim, typename Coord>
+    BasicPercolationGraph<Dim, Coord>::BasicPercolationGraph(std::pmr::memory_resource *resource) : vertices(resource), pending_edges(resource), adjacency_offsets(resource), adjacency(resource)
     {
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::reserve_vertices(size_t num_vertices)
+    {
+        if (this->vertices.size() >= num_vertices)
+        {
+            return true;
+        }
+        size_t curr_size = this->vertices.size();
+        this->vertices.resize(num_vertices);
+        for (size_t i = curr_size; i < num_vertices; i++)
+        {
+            this->vertices[i].index = i;
+        }
+        return true;
+    }
 
-        size_t existing_dim = existing_base.size();
-        size_t matrix_dim = existing_dim + 1;
-        if (matrix_dim > vector_space_dimension)
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::add_vertex(size_t vertex_index, const VertexData &vertex_data)
+    {
+        if (!reserve_vertices(vertex_index+1))
         {
             return false;
         }
+        vertices[vertex_index] = vertex_data;
+        vertices[vertex_index].index = vertex_index;
 
-        // Construct the basic matrix
-        std::vector<std::vector<translation_coordinate_type>> base_matrix(matrix_dim, std::vector<translation_coordinate_type>(vector_space_dimension));
-        for (size_t i = 0; i < existing_dim; i++)
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data)
+    {
+        size_t max_index = (vertex_index_base > vertex_index_head ? vertex_index_base : vertex_index_head);
+        if (!reserve_vertices(max_index+1))
+        {
+            return false;
+        }
+        pending_edges.push_back({vertex_index_base, vertex_index_head, edge_data});
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::add_edge(size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        return add_edge(vertex_index_base, vertex_index_head, edge_data_type(edge_trans));
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::build_from_edges(const edge_type *edge_list, size_t num_edges)
+    {
+        size_t max_index = 0;
+        for (size_t e = 0; e < num_edges; e++)
+        {
+            max_index = (edge_list[e].base > max_index ? edge_list[e].base : max_index);
+            max_index = (edge_list[e].head > max_index ? edge_list[e].head : max_index);
+        }
+        if (num_edges > 0 && !reserve_vertices(max_index + 1))
+        {
+            return false;
+        }
+
+        pending_edges.clear();
+        adjacency_offsets.clear();
+        adjacency.clear();
+        Span<edge_type> edges(edge_list, num_edges);
+        merge_edges(&edges, 1);
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::build_from_edges(const std::vector<edge_type> &edge_list)
+    {
+        return build_from_edges(edge_list.data(), edge_list.size());
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::build_from_edge_arrays(const size_t *edge_base, const size_t *edge_head, const int8_t *const *edge_translations, size_t num_edges)
+    {
+        size_t max_index = 0;
+        for (size_t e = 0; e < num_edges; e++)
+        {
+            max_index = (edge_base[e] > max_index ? edge_base[e] : max_index);
+            max_index = (edge_head[e] > max_index ? edge_head[e] : max_index);
+        }
+        if (num_edges > 0 && !reserve_vertices(max_index + 1))
         {
-            for (size_t j = 0; j < vector_space_dimension; j++)
+            return false;
+        }
+
+        pending_edges.clear();
+        adjacency.clear();
+        build_adjacency([&](auto &&body) {
+            translation_type trans;
+            for (size_t e = 0; e < num_edges; e++)
             {
-                base_matrix[i][j] = existing_base[i].vec[j];
+                for (size_t i = 0; i < Dim; i++)
+                {
+                    trans[i] = Coord(edge_translations[i][e]);
+                }
+                body(edge_base[e], edge_head[e], edge_data_type(trans));
+            }
+        });
+        return true;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::begin_concurrent_insertion(size_t num_slots)
+    {
+        edge_slots.resize(num_slots);
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::add_edge_concurrent(size_t slot, size_t vertex_index_base, size_t vertex_index_head, const edge_data_type &edge_data)
+    {
+        // Vertices cannot be reserved here, as that would resize the vertices shared by all threads
+        EdgeSlot &edge_slot = edge_slots[slot];
+        edge_slot.max_index = std::max(edge_slot.max_index, std::max(vertex_index_base, vertex_index_head));
+        edge_slot.edges.push_back({vertex_index_base, vertex_index_head, edge_data});
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::add_edge_concurrent(size_t slot, size_t vertex_index_base, size_t vertex_index_head, const translation_type &edge_trans)
+    {
+        add_edge_concurrent(slot, vertex_index_base, vertex_index_head, edge_data_type(edge_trans));
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::finalize()
+    {
+        std::vector<Span<edge_type>> &edge_lists = merge_lists;
+        edge_lists.clear();
+        edge_lists.emplace_back(pending_edges.data(), pending_edges.size());
+        for (const EdgeSlot &edge_slot : edge_slots)
+        {
+            if (!edge_slot.edges.empty())
+            {
+                reserve_vertices(edge_slot.max_index + 1);
+                edge_lists.emplace_back(edge_slot.edges.data(), edge_slot.edges.size());
             }
         }
 
-        for (size_t j = 0; j < vector_space_dimension; j++)
+        if (edge_lists.size() == 1)
         {
-            base_matrix[existing_dim][j] = new_vector.vec[j];
+            update_adjacency();
+            return;
         }
 
-        std::vector<std::vector<translation_coordinate_type>> Mt_M(matrix_dim, std::vector<translation_coordinate_type>(matrix_dim, 0));
+        // All buffers are merged in one pass, so the adjacency structure is only rebuilt once
+        size_t thread_count = resolve_thread_count(num_threads);
+        if (thread_count > 1)
+        {
+            merge_edges_parallel(edge_lists.data(), edge_lists.size(), thread_count);
+        }
+        else
+        {
+            merge_edges(edge_lists.data(), edge_lists.size());
+        }
+        pending_edges.clear();
+        for (EdgeSlot &edge_slot : edge_slots)
+        {
+            edge_slot.edges.clear();
+            edge_slot.max_index = 0;
+        }
+    }
 
-        //#pragma omp parallel for
-        for (size_t i = 0; i < matrix_dim; i++)
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::merge_edges(const Span<edge_type> *edge_lists, size_t num_lists) const
+    {
+        const size_t num_vertices = this->vertices.size();
+        const size_t num_old_vertices = (adjacency_offsets.empty() ? 0 : adjacency_offsets.size() - 1);
+        auto for_each_edge = [&](auto &&body) {
+            for (size_t l = 0; l < num_lists; l++)
+            {
+                for (const edge_type &edge : edge_lists[l])
+                {
+                    body(edge.base, edge.head, edge.data);
+                }
+            }
+        };
+
+        if (adjacency.empty())
+        {
+            build_adjacency(for_each_edge);
+            return;
+        }
+
+        // Count the outgoing edges of each vertex, shifted by one for the prefix sum
+        std::pmr::vector<size_t> new_offsets(num_vertices + 1, 0, adjacency_offsets.get_allocator());
+        for (size_t v = 0; v < num_old_vertices; v++)
+        {
+            new_offsets[v + 1] = adjacency_offsets[v + 1] - adjacency_offsets[v];
+        }
+        for_each_edge([&](size_t base, size_t head, const edge_data_type &) {
+            new_offsets[base + 1]++;
+            // A loop is stored only once, as the inverse direction spans the same translation
+            if (head != base)
+            {
+                new_offsets[head + 1]++;
+            }
+        });
+        for (size_t v = 0; v < num_vertices; v++)
+        {
+            new_offsets[v + 1] += new_offsets[v];
+        }
+
+        std::pmr::vector<std::pair<size_t, edge_data_type>> new_adjacency(new_offsets[num_vertices], adjacency.get_allocator());
+        std::pmr::vector<size_t> insert_position(new_offsets.begin(), new_offsets.end() - 1, adjacency_offsets.get_allocator());
+
+        // Edges already present stay in front of the new ones
+        for (size_t v = 0; v < num_old_vertices; v++)
         {
-            for (size_t j = 0; j < matrix_dim; j++)
+            for (size_t e = adjacency_offsets[v]; e < adjacency_offsets[v + 1]; e++)
+            {
+                new_adjacency[insert_position[v]++] = adjacency[e];
+            }
+        }
+
+        for_each_edge([&](size_t base, size_t head, const edge_data_type &data) {
+            new_adjacency[insert_position[base]++] = {head, data};
+            if (head != base)
             {
-                for (size_t k = 0; k < vector_space_dimension; k++)
+                new_adjacency[insert_position[head]++] = {base, data.inverse()};
+            }
+        });
+
+        adjacency_offsets.swap(new_offsets);
+        adjacency.swap(new_adjacency);
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::merge_edges_parallel(const Span<edge_type> *edge_lists, size_t num_lists, size_t thread_count) const
+    {
+        const size_t num_vertices = this->vertices.size();
+        const size_t num_old_vertices = (adjacency_offsets.empty() ? 0 : adjacency_offsets.size() - 1);
+        const size_t num_blocks = (num_vertices + vertex_block_size - 1) / vertex_block_size;
+
+        // Without edges to keep, the member arrays are filled directly to reuse their memory
+        const bool keep_old = !adjacency.empty();
+        std::pmr::vector<size_t> new_offsets(adjacency_offsets.get_allocator());
+        std::pmr::vector<std::pair<size_t, edge_data_type>> new_adjacency(adjacency.get_allocator());
+        std::pmr::vector<size_t> &offsets = (keep_old ? new_offsets : adjacency_offsets);
+        std::pmr::vector<std::pair<size_t, edge_data_type>> &target = (keep_old ? new_adjacency : adjacency);
+        auto old_degree = [&](size_t v) {
+            return (keep_old && v < num_old_vertices ? adjacency_offsets[v + 1] - adjacency_offsets[v] : 0);
+        };
+
+        // Count the new edges of each block of vertices in each list
+        merge_block_counts.resize(num_lists * num_blocks);
+        parallel_for_dynamic(num_lists, thread_count, 1, [&](size_t l, size_t) {
+            size_t *counts = merge_block_counts.data() + l * num_blocks;
+            std::fill(counts, counts + num_blocks, 0);
+            for (const edge_type &edge : edge_lists[l])
+            {
+                counts[edge.base / vertex_block_size]++;
+                // A loop is stored only once, as the inverse direction spans the same translation
+                if (edge.head != edge.base)
                 {
-                    Mt_M[i][j] += base_matrix[i][k] * base_matrix[j][k];
+                    counts[edge.head / vertex_block_size]++;
                 }
             }
+        });
+
+        // The new edges are staged by block and, within each block, by list. The blocks keep the edges already present in front.
+        merge_stage_offsets.resize(num_blocks + 1);
+        merge_block_offsets.resize(num_blocks + 1);
+        merge_stage_offsets[0] = 0;
+        merge_block_offsets[0] = 0;
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            size_t num_block_edges = 0;
+            if (keep_old && block * vertex_block_size < num_old_vertices)
+            {
+                num_block_edges = adjacency_offsets[std::min(num_old_vertices, (block + 1) * vertex_block_size)] - adjacency_offsets[block * vertex_block_size];
+            }
+            size_t stage_position = merge_stage_offsets[block];
+            for (size_t l = 0; l < num_lists; l++)
+            {
+                size_t count = merge_block_counts[l * num_blocks + block];
+                merge_block_counts[l * num_blocks + block] = stage_position;
+                stage_position += count;
+            }
+            merge_stage_offsets[block + 1] = stage_position;
+            merge_block_offsets[block + 1] = merge_block_offsets[block] + num_block_edges + (stage_position - merge_stage_offsets[block]);
         }
 
-        translation_coordinate_type MT_M_determinant = det(Mt_M);
+        // Every list writes to its own positions within each block
+        std::pmr::vector<MergeEntry> staged(merge_stage_offsets[num_blocks], std::pmr::polymorphic_allocator<MergeEntry>(adjacency.get_allocator().resource()));
+        parallel_for_dynamic(num_lists, thread_count, 1, [&](size_t l, size_t) {
+            size_t *positions = merge_block_counts.data() + l * num_blocks;
+            for (const edge_type &edge : edge_lists[l])
+            {
+                staged[positions[edge.base / vertex_block_size]++] = {edge.head, edge.data, uint32_t(edge.base % vertex_block_size)};
+                if (edge.head != edge.base)
+                {
+                    staged[positions[edge.head / vertex_block_size]++] = {edge.base, edge.data.inverse(), uint32_t(edge.head % vertex_block_size)};
+                }
+            }
+        });
+
+        offsets.resize(num_vertices + 1);
+        offsets[num_vertices] = merge_block_offsets[num_blocks];
+        target.resize(merge_block_offsets[num_blocks]);
+
+        // Sort the staged edges of each block by vertex, which keeps their order within each vertex
+        merge_vertex_positions.resize(thread_count * vertex_block_size);
+        parallel_for_dynamic(num_blocks, thread_count, 1, [&](size_t block, size_t thread_index) {
+            size_t begin = block * vertex_block_size;
+            size_t end = std::min(num_vertices, begin + vertex_block_size);
+            size_t *positions = merge_vertex_positions.data() + thread_index * vertex_block_size;
+            std::fill(positions, positions + (end - begin), 0);
+            for (size_t i = merge_stage_offsets[block]; i < merge_stage_offsets[block + 1]; i++)
+            {
+                positions[staged[i].block_vertex]++;
+            }
 
-        // If the absolute determinant result is below the threshold, then the vectors are linearly dependent
-        if (translation_abs_function(MT_M_determinant) <= translation_coordinate_precision)
+            size_t position = merge_block_offsets[block];
+            for (size_t v = begin; v < end; v++)
+            {
+                offsets[v] = position;
+                for (size_t e = 0; e < old_degree(v); e++)
+                {
+                    target[position++] = adjacency[adjacency_offsets[v] + e];
+                }
+                size_t count = positions[v - begin];
+                positions[v - begin] = position;
+                position += count;
+            }
+
+            for (size_t i = merge_stage_offsets[block]; i < merge_stage_offsets[block + 1]; i++)
+            {
+                target[positions[staged[i].block_vertex]++] = {staged[i].head, staged[i].data};
+            }
+        });
+
+        if (keep_old)
         {
-            return false;
+            adjacency_offsets.swap(new_offsets);
+            adjacency.swap(new_adjacency);
         }
+    }
 
-        // Vectors are linearly independent
-        return true;
+    template <size_t Dim, typename Coord>
+    template <typename EdgeVisitor>
+    void BasicPercolationGraph<Dim, Coord>::build_adjacency(const EdgeVisitor &for_each_edge) const
+    {
+        // Nothing to keep, so build directly in the member arrays to reuse their memory
+        const size_t num_vertices = this->vertices.size();
+        adjacency_offsets.assign(num_vertices + 1, 0);
+        for_each_edge([&](size_t base, size_t head, const edge_data_type &) {
+            adjacency_offsets[base + 1]++;
+            if (head != base)
+            {
+                adjacency_offsets[head + 1]++;
+            }
+        });
+        for (size_t v = 0; v < num_vertices; v++)
+        {
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        }
+        adjacency.resize(adjacency_offsets[num_vertices]);
+
+        // Use the start offsets as insert positions, which moves each of them to the start of the next vertex
+        for_each_edge([&](size_t base, size_t head, const edge_data_type &data) {
+            adjacency[adjacency_offsets[base]++] = {head, data};
+            if (head != base)
+            {
+                adjacency[adjacency_offsets[head]++] = {base, data.inverse()};
+            }
+        });
+        for (size_t v = num_vertices; v > 0; v--)
+        {
+            adjacency_offsets[v] = adjacency_offsets[v - 1];
+        }
+        adjacency_offsets[0] = 0;
     }
 
-    bool PercolationGraph::reserve_vertices(size_t num_vertices)
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::update_adjacency() const
     {
-        if (this->vertices.size() >= num_vertices)
+        if (!pending_edges.empty())
         {
-            return true;
+            Span<edge_type> edges(pending_edges.data(), pending_edges.size());
+            merge_edges(&edges, 1);
+            pending_edges.clear();
         }
-        size_t curr_size = this->vertices.size();
-        this->vertices.resize(num_vertices);
-        for (size_t i = curr_size; i < num_vertices; i++)
+        else if (adjacency_offsets.size() < this->vertices.size() + 1)
         {
-            this->vertices[i].index = i;
+            // Only vertices without edges have been added
+            size_t num_half_edges = adjacency.size();
+            adjacency_offsets.resize(this->vertices.size() + 1, num_half_edges);
         }
-        this->edges.resize(num_vertices);
-        return true;
     }
 
-    bool PercolationGraph::add_vertex(size_t vertex_index, const VertexData &vertex_data)
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::reset()
     {
-        if (!reserve_vertices(vertex_index+1))
+        vertices.clear();
+        pending_edges.clear();
+        for (EdgeSlot &edge_slot : edge_slots)
+        {
+            edge_slot.edges.clear();
+            edge_slot.max_index = 0;
+        }
+        adjacency_offsets.clear();
+        adjacency.clear();
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::set_num_threads(size_t num_threads)
+    {
+        this->num_threads = num_threads;
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::get_num_threads() const
+    {
+        return num_threads;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::set_statistics(AnalysisStatistics *statistics)
+    {
+        this->statistics = statistics;
+    }
+
+    template <size_t Dim, typename Coord>
+    std::vector<ComponentInfo> BasicPercolationGraph<Dim, Coord>::get_component_percolation_info() const
+    {
+        AnalysisWorkspace workspace;
+        return get_component_percolation_info(workspace);
+    }
+
+    template <size_t Dim, typename Coord>
+    std::vector<ComponentInfo> BasicPercolationGraph<Dim, Coord>::get_component_percolation_info(AnalysisWorkspace &workspace) const
+    {
+        const ComponentLabels &labels = workspace.labels;
+        get_component_labels(workspace.labels, workspace);
+        PERCOLATION_STAT(PhaseClock clock(statistics);)
+
+        // Same as ComponentLabels::to_component_info(), but with the full data of the vertices
+        std::vector<ComponentInfo> component_info(labels.get_num_components());
+        for (size_t c = 0; c < component_info.size(); c++)
+        {
+            component_info[c].component_index = c;
+            component_info[c].percolation_dim = labels.percolation_dims[c];
+            component_info[c].vertices.reserve(labels.sizes[c]);
+            for (size_t vertex : labels.get_members(c))
+            {
+                component_info[c].vertices.push_back(this->vertices[vertex]);
+            }
+        }
+        PERCOLATION_STAT(clock.stop(&AnalysisStatistics::result_time);)
+        return component_info;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::get_component_labels(ComponentLabels &labels) const
+    {
+        AnalysisWorkspace workspace;
+        get_component_labels(labels, workspace);
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::get_component_labels(ComponentLabels &labels, AnalysisWorkspace &workspace) const
+    {
+        PERCOLATION_STAT(PhaseClock clock(statistics);)
+        PERCOLATION_STAT(BufferWatch buffers;)
+        PERCOLATION_STAT(buffers.add(adjacency); buffers.add(adjacency_offsets); buffers.add(workspace.visited); buffers.add(workspace.positions);)
+        PERCOLATION_STAT(buffers.add(labels.component_of); buffers.add(labels.members); buffers.add(labels.offsets);)
+        PERCOLATION_STAT(buffers.add(labels.percolation_dims); buffers.add(labels.sizes);)
+        update_adjacency();
+        PERCOLATION_STAT(clock.stop(&AnalysisStatistics::adjacency_time);)
+
+        const size_t num_vertices = this->vertices.size();
+
+        // Components are disjoint, so concurrent analyses never touch the same entries.
+        // A byte per vertex instead of std::vector<bool> avoids sharing bits between threads.
+        std::vector<uint8_t> &visited = workspace.visited;
+        std::vector<position_type> &positions = workspace.positions;
+        visited.assign(num_vertices, 0);
+        positions.resize(num_vertices);
+
+        // Every vertex belongs to exactly one component, so the members of all components fill the array exactly
+        labels.component_of.resize(num_vertices);
+        labels.members.resize(num_vertices);
+        labels.offsets.assign(1, 0);
+        labels.percolation_dims.clear();
+        labels.sizes.clear();
+
+#ifdef PERCOLATION_STATISTICS
+        // Counters of the components analyzed on each thread, summed up at the end
+        std::vector<BfsCounters> &thread_counters = workspace.thread_counters;
+        thread_counters.assign(resolve_thread_count(num_threads), BfsCounters());
+        auto counters_of = [&](size_t thread_index) { return &thread_counters[thread_index]; };
+        auto record_statistics = [&]() {
+            clock.stop(&AnalysisStatistics::analysis_time);
+            if (statistics == nullptr)
+            {
+                return;
+            }
+            for (const BfsCounters &counters : thread_counters)
+            {
+                counters.add_to(*statistics);
+            }
+            statistics->num_components += labels.get_num_components();
+            for (size_t size : labels.sizes)
+            {
+                statistics->add_component_size(size);
+            }
+            statistics->allocations += buffers.count_allocations();
+        };
+#else
+        auto counters_of = [](size_t) { return static_cast<BfsCounters *>(nullptr); };
+#endif
+
+        if (resolve_thread_count(num_threads) <= 1)
+        {
+            // Discover and analyze the components in one pass
+            for (size_t curr_vertex = 0; curr_vertex < num_vertices; curr_vertex++)
+            {
+                if (visited[curr_vertex])
+                {
+                    continue;
+                }
+
+                size_t comp_index = labels.percolation_dims.size();
+                size_t offset = labels.offsets.back();
+                size_t comp_size = 0;
+                labels.percolation_dims.push_back(analyze_component(curr_vertex, true, labels.members.data() + offset, comp_size, visited, positions, counters_of(0)));
+                labels.sizes.push_back(comp_size);
+                labels.offsets.push_back(offset + comp_size);
+                for (size_t m = offset; m < offset + comp_size; m++)
+                {
+                    labels.component_of[labels.members[m]] = comp_index;
+                }
+            }
+            PERCOLATION_STAT(record_statistics();)
+            return;
+        }
+
+        label_components_parallel(labels, workspace);
+        PERCOLATION_STAT(clock.stop(&AnalysisStatistics::labeling_time);)
+
+        const size_t comp_count = labels.sizes.size();
+        const size_t thread_count = resolve_thread_count(num_threads);
+        const std::vector<size_t> &start_vertices = workspace.start_vertices;
+        const std::vector<size_t> &component_sizes = labels.sizes;
+        const std::vector<size_t> &component_edges = workspace.component_edges;
+        labels.percolation_dims.resize(comp_count);
+
+        // A tree (#edges = #vertices - 1) cannot contain any cycle with a net translation
+        auto is_tree = [&](size_t c) {
+            return component_edges[c] == 2 * (component_sizes[c] - 1);
+        };
+
+        // A component holding more than a thread's share of the vertices is searched by all threads together.
+        // The others are handed out to the threads, largest first, so that a large one does not end up last on one thread.
+        std::vector<size_t> &component_order = workspace.component_order;
+        component_order.clear();
+        for (size_t c = 0; c < comp_count; c++)
+        {
+            if (component_sizes[c] >= parallel_bfs_min_size && component_sizes[c] * thread_count > num_vertices)
+            {
+                labels.percolation_dims[c] = analyze_component_parallel(c, !is_tree(c), labels, workspace, counters_of(0));
+            }
+            else
+            {
+                component_order.push_back(c);
+            }
+        }
+        std::stable_sort(component_order.begin(), component_order.end(), [&](size_t a, size_t b) {
+            return component_sizes[a] > component_sizes[b];
+        });
+
+        parallel_for_dynamic(component_order.size(), num_threads, 1, [&](size_t task, size_t thread_index) {
+            size_t c = component_order[task];
+            size_t comp_size = 0;
+            labels.percolation_dims[c] = analyze_component(start_vertices[c], !is_tree(c), labels.members.data() + labels.offsets[c], comp_size, visited, positions, counters_of(thread_index));
+        });
+        PERCOLATION_STAT(record_statistics();)
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::max_percolation_dim(size_t min_component_size) const
+    {
+        AnalysisWorkspace workspace;
+        return max_percolation_dim(min_component_size, workspace);
+    }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::max_percolation_dim(size_t min_component_size, AnalysisWorkspace &workspace) const
+    {
+        // Nothing can exceed a percolation in all directions, so only that ends the search early
+        QueryTarget target;
+        target.min_dim = Dim;
+        return run_query(target, min_component_size, workspace);
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::any_component_reaches(size_t dim, size_t min_component_size) const
+    {
+        AnalysisWorkspace workspace;
+        return any_component_reaches(dim, min_component_size, workspace);
+    }
+
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::any_component_reaches(size_t dim, size_t min_component_size, AnalysisWorkspace &workspace) const
+    {
+        if (dim > Dim)
         {
             return false;
         }
-        vertices[vertex_index] = vertex_data;
-        vertices[vertex_index].index = vertex_index;
+        QueryTarget target;
+        target.min_dim = dim;
+        run_query(target, min_component_size, workspace);
+        return target.reached;
+    }
 
-        return true;
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::percolates_along(unsigned axis_mask, size_t min_component_size) const
+    {
+        AnalysisWorkspace workspace;
+        return percolates_along(axis_mask, min_component_size, workspace);
     }
 
-    bool PercolationGraph::add_edge(size_t vertex_index_base, size_t vertex_index_head, const EdgeData &edge_data)
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::percolates_along(unsigned axis_mask, size_t min_component_size, AnalysisWorkspace &workspace) const
     {
-        size_t max_index = (vertex_index_base > vertex_index_head ? vertex_index_base : vertex_index_head);
-        if (!reserve_vertices(max_index+1))
+        if ((axis_mask >> Dim) != 0)
         {
             return false;
         }
-        edges[vertex_index_base].push_back({vertex_index_head, edge_data});
-        edges[vertex_index_head].push_back({vertex_index_base, edge_data.inverse()});
-        return true;
+        QueryTarget target;
+        target.axis_mask = axis_mask;
+        run_query(target, min_component_size, workspace);
+        return target.reached;
     }
 
-    bool PercolationGraph::add_edge(size_t vertex_index_base, size_t vertex_index_head, const TranslationVector &edge_trans)
+    template <size_t Dim, typename Coord>
+    bool BasicPercolationGraph<Dim, Coord>::is_target_reached(const basis_type &basis, const QueryTarget &target)
     {
-        return add_edge(vertex_index_base, vertex_index_head, EdgeData(edge_trans));
+        if (basis.size() < target.min_dim)
+        {
+            return false;
+        }
+
+        // The axes along which the lattice extends are the non-zero entries of its basis vectors
+        unsigned axes = 0;
+        for (size_t i = 0; i < basis.size(); i++)
+        {
+            for (size_t a = 0; a < Dim; a++)
+            {
+                if (!CoordinateTraits<typename CoordinateTraits<Coord>::accumulator_type>::is_zero(basis[i][a]))
+                {
+                    axes |= 1u << a;
+                }
+            }
+        }
+        return (axes & target.axis_mask) == target.axis_mask;
     }
 
-    std::vector<ComponentInfo> PercolationGraph::get_component_percolation_info() const
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::run_query(QueryTarget &target, size_t min_component_size, AnalysisWorkspace &workspace) const
     {
-        // Obtain component decomposition
-        std::vector<ComponentInfo> component_info = get_components();
+        update_adjacency();
 
-        const int64_t comp_count = component_info.size();
         const size_t num_vertices = this->vertices.size();
-        std::vector<bool> visited(num_vertices, false);
-        std::vector<struct TranslationVector> original_positions(num_vertices);
+        std::vector<uint8_t> &visited = workspace.visited;
+        std::vector<position_type> &positions = workspace.positions;
+        std::vector<size_t> &query_queue = workspace.query_queue;
+        visited.assign(num_vertices, 0);
+        positions.resize(num_vertices);
+        query_queue.resize(num_vertices);
 
-        TranslationVector origin;
-        for (size_t i = 0; i < vector_space_dimension; i++)
+        target.reached = false;
+        size_t max_dim = 0;
+        BfsCounters counters;
+
+        // Returns true once the query is answered
+        auto analyze = [&](size_t start_vertex, bool check_cycles) {
+            size_t comp_size = 0;
+            max_dim = std::max(max_dim, analyze_component(start_vertex, check_cycles, query_queue.data(), comp_size, visited, positions, &counters, &target));
+            return target.reached;
+        };
+
+        if (min_component_size <= 1)
         {
-            origin.vec[i] = 0;
+            // Discover the components on the fly, so that the search ends without visiting the rest of the graph
+            for (size_t curr_vertex = 0; curr_vertex < num_vertices; curr_vertex++)
+            {
+                if (!visited[curr_vertex] && analyze(curr_vertex, true))
+                {
+                    break;
+                }
+            }
         }
+        else
+        {
+            std::vector<size_t> &start_vertices = workspace.start_vertices;
+            std::vector<size_t> &component_sizes = workspace.component_sizes;
+            std::vector<size_t> &component_edges = workspace.component_edges;
+            start_vertices.clear();
+            component_sizes.clear();
+            component_edges.clear();
+            label_components(start_vertices, component_sizes, component_edges, visited);
+            std::fill(visited.begin(), visited.end(), 0);
 
-#pragma omp parallel for
-        for (int64_t curr_component = 0; curr_component < comp_count; curr_component++)
+            // Only the components above the threshold are analyzed, largest first as they are the most likely to percolate
+            std::vector<size_t> &component_order = workspace.component_order;
+            component_order.clear();
+            for (size_t c = 0; c < start_vertices.size(); c++)
+            {
+                if (component_sizes[c] >= min_component_size)
+                {
+                    component_order.push_back(c);
+                }
+            }
+            std::stable_sort(component_order.begin(), component_order.end(), [&](size_t a, size_t b) {
+                return component_sizes[a] > component_sizes[b];
+            });
+
+            const bool trees_qualify = is_target_reached(basis_type(), target);
+            for (size_t c : component_order)
+            {
+                // A tree (#edges = #vertices - 1) has percolation dimension 0
+                bool is_tree = (component_edges[c] == 2 * (component_sizes[c] - 1));
+                if (is_tree && !trees_qualify)
+                {
+                    continue;
+                }
+                if (analyze(start_vertices[c], !is_tree))
+                {
+                    break;
+                }
+            }
+        }
+
+        PERCOLATION_STAT(if (statistics != nullptr) { counters.add_to(*statistics); })
+        return max_dim;
+    }
+
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::label_components_parallel(ComponentLabels &labels, AnalysisWorkspace &workspace) const
+    {
+        const size_t num_vertices = this->vertices.size();
+        const size_t num_blocks = (num_vertices + vertex_block_size - 1) / vertex_block_size;
+        AtomicArray<size_t> &parents = workspace.parents;
+        parents.resize(num_vertices);
+
+        // Calls body(begin, end, block) for blocks of consecutive vertices on all threads
+        auto for_vertex_blocks = [&](auto &&body) {
+            parallel_for_dynamic(num_blocks, num_threads, 1, [&](size_t block, size_t) {
+                size_t begin = block * vertex_block_size;
+                body(begin, std::min(num_vertices, begin + vertex_block_size), block);
+            });
+        };
+        auto compress = [&](size_t begin, size_t end, size_t) {
+            for (size_t v = begin; v < end; v++)
+            {
+                parents[v].store(find_root(parents, v), std::memory_order_relaxed);
+            }
+        };
+
+        for_vertex_blocks([&](size_t begin, size_t end, size_t) {
+            for (size_t v = begin; v < end; v++)
+            {
+                parents[v].store(v, std::memory_order_relaxed);
+            }
+        });
+
+        // Link every vertex to its first neighbor only
+        for_vertex_blocks([&](size_t begin, size_t end, size_t) {
+            for (size_t v = begin; v < end; v++)
+            {
+                if (adjacency_offsets[v] < adjacency_offsets[v + 1])
+                {
+                    link_roots(parents, v, this->adjacency[adjacency_offsets[v]].first);
+                }
+            }
+        });
+        for_vertex_blocks(compress);
+
+        // The most frequent root among a fixed sample of vertices is most likely the root of the largest component
+        size_t frequent_root = std::numeric_limits<size_t>::max();
+        if (num_vertices > 0)
         {
-            // Determine percolation dimension for each of the
+            const size_t num_samples = 1024;
+            std::vector<size_t> sample(num_samples);
+            uint64_t state = 0x9E3779B97F4A7C15ull;
+            for (size_t &sampled_root : sample)
+            {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                sampled_root = parents[(state >> 16) % num_vertices].load(std::memory_order_relaxed);
+            }
+            std::sort(sample.begin(), sample.end());
+            size_t best_count = 0;
+            for (size_t i = 0, run; i < num_samples; i += run)
+            {
+                for (run = 1; i + run < num_samples && sample[i + run] == sample[i]; run++)
+                {
+                }
+                if (run > best_count)
+                {
+                    best_count = run;
+                    frequent_root = sample[i];
+                }
+            }
+        }
 
-            ComponentInfo &curr_info = component_info[curr_component];
-            size_t start_vertex = curr_info.vertices[0].index;
+        // Process the remaining edges. An edge between two vertices of the sampled component needs no linking, and every
+        // other edge is stored at an endpoint outside of that component as well, so its vertices can be skipped.
+        for_vertex_blocks([&](size_t begin, size_t end, size_t) {
+            for (size_t v = begin; v < end; v++)
+            {
+                if (find_root(parents, v) == frequent_root)
+                {
+                    continue;
+                }
+                for (size_t e = adjacency_offsets[v] + 1; e < adjacency_offsets[v + 1]; e++)
+                {
+                    link_roots(parents, v, this->adjacency[e].first);
+                }
+            }
+        });
+        for_vertex_blocks(compress);
 
-            std::vector<TranslationVector> basis_set;
+        // Number the roots in increasing order: count them per block, then enumerate them from the block's offset on
+        std::vector<size_t> &block_offsets = workspace.block_offsets;
+        block_offsets.assign(num_blocks + 1, 0);
+        for_vertex_blocks([&](size_t begin, size_t end, size_t block) {
+            size_t num_roots = 0;
+            for (size_t v = begin; v < end; v++)
+            {
+                num_roots += (parents[v].load(std::memory_order_relaxed) == v);
+            }
+            block_offsets[block + 1] = num_roots;
+        });
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            block_offsets[block + 1] += block_offsets[block];
+        }
 
-            std::queue<std::pair<size_t, TranslationVector>> vertex_queue;
-            vertex_queue.push({start_vertex, origin});
+        const size_t comp_count = block_offsets[num_blocks];
+        std::vector<size_t> &start_vertices = workspace.start_vertices;
+        start_vertices.resize(comp_count);
+        for_vertex_blocks([&](size_t begin, size_t end, size_t block) {
+            size_t comp_index = block_offsets[block];
+            for (size_t v = begin; v < end; v++)
+            {
+                if (parents[v].load(std::memory_order_relaxed) == v)
+                {
+                    labels.component_of[v] = comp_index;
+                    start_vertices[comp_index++] = v;
+                }
+            }
+        });
+        for_vertex_blocks([&](size_t begin, size_t end, size_t) {
+            for (size_t v = begin; v < end; v++)
+            {
+                // The entries of the roots are read by other threads, so they must not be written again
+                size_t root = parents[v].load(std::memory_order_relaxed);
+                if (root != v)
+                {
+                    labels.component_of[v] = labels.component_of[root];
+                }
+            }
+        });
 
-            while (!vertex_queue.empty())
+        // Sum up sizes and edge counts. Consecutive vertices mostly belong to the same component, so they are added up
+        // locally first and only written once per run, which avoids contention on the counters of a giant component.
+        AtomicArray<size_t> &component_counts = workspace.component_counts;
+        component_counts.resize(2 * comp_count);
+        for (size_t i = 0; i < 2 * comp_count; i++)
+        {
+            component_counts[i].store(0, std::memory_order_relaxed);
+        }
+        for_vertex_blocks([&](size_t begin, size_t end, size_t) {
+            size_t v = begin;
+            while (v < end)
             {
-                auto vertex_position = vertex_queue.front();
-                vertex_queue.pop();
+                size_t comp_index = labels.component_of[v];
+                size_t run_vertices = 0;
+                size_t run_edges = 0;
+                for (; v < end && labels.component_of[v] == comp_index; v++)
+                {
+                    run_vertices++;
+                    run_edges += adjacency_offsets[v + 1] - adjacency_offsets[v];
+                }
+                component_counts[2 * comp_index].fetch_add(run_vertices, std::memory_order_relaxed);
+                component_counts[2 * comp_index + 1].fetch_add(run_edges, std::memory_order_relaxed);
+            }
+        });
+
+        std::vector<size_t> &component_edges = workspace.component_edges;
+        labels.sizes.resize(comp_count);
+        component_edges.resize(comp_count);
+        labels.offsets.resize(comp_count + 1);
+        labels.offsets[0] = 0;
+        for (size_t c = 0; c < comp_count; c++)
+        {
+            labels.sizes[c] = component_counts[2 * c].load(std::memory_order_relaxed);
+            component_edges[c] = component_counts[2 * c + 1].load(std::memory_order_relaxed);
+            labels.offsets[c + 1] = labels.offsets[c] + labels.sizes[c];
+        }
+    }
 
-                size_t vert_index = vertex_position.first;
-                const TranslationVector &curr_position = vertex_position.second;
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::analyze_component_parallel(size_t component_index, bool check_cycles, ComponentLabels &labels, AnalysisWorkspace &workspace, BfsCounters *thread_counters) const
+    {
+        (void)thread_counters;
 
-                // Possibly encountered different copy of vertex
-                if (visited[vert_index])
+        const size_t thread_count = resolve_thread_count(num_threads);
+        const size_t root = workspace.start_vertices[component_index];
+        const size_t comp_size = labels.sizes[component_index];
+        AtomicArray<size_t> &parents = workspace.parents;
+        std::vector<position_type> &positions = workspace.positions;
+        std::vector<std::vector<size_t>> &thread_frontiers = workspace.thread_frontiers;
+        std::vector<size_t> &level_chunks = workspace.level_chunks;
+        thread_frontiers.resize(thread_count);
+        level_chunks.resize(3 * ((comp_size + frontier_grain_size - 1) / frontier_grain_size));
+
+        // After the labeling, the entry of every vertex of the component is the root. The bfs marks vertices as discovered by replacing it.
+        // Within a level searched by all threads, the vertex at index i of the queue claims its neighbors first by writing discovered - 1 - i,
+        // which is larger than any vertex index, so the largest claim comes from the first vertex in the queue.
+        const size_t discovered = std::numeric_limits<size_t>::max();
+
+        // The members of the component serve as the bfs queue, each level follows the previous one
+        size_t *component_vertices = labels.members.data() + labels.offsets[component_index];
+        parents[root].store(discovered, std::memory_order_relaxed);
+        positions[root] = position_type::zero();
+        component_vertices[0] = root;
+
+        std::vector<basis_type> &thread_bases = workspace.thread_bases;
+        thread_bases.assign(thread_count, basis_type());
+
+        // The same threads work through all levels and the cycle translations, separated by barriers
+        ThreadBarrier barrier(thread_count);
+        std::atomic<size_t> next_task(0);
+        std::atomic<size_t> next_chunk(0);
+        std::atomic<bool> basis_full(false);
+        size_t shared_level_begin = 0;
+        size_t shared_level_end = 1;
+
+        // Discover the neighbors of a queue entry whose entry in parents is the given mark, in the order of its edges
+        auto expand = [&](size_t queue_index, size_t mark, size_t thread_index, auto &&push) {
+            (void)thread_index;
+            size_t vert_index = component_vertices[queue_index];
+            PERCOLATION_STAT(thread_counters[thread_index].vertices_visited++; thread_counters[thread_index].edges_visited += adjacency_offsets[vert_index + 1] - adjacency_offsets[vert_index];)
+            const position_type &curr_position = positions[vert_index];
+            for (size_t e = adjacency_offsets[vert_index]; e < adjacency_offsets[vert_index + 1]; e++)
+            {
+                const auto &edge = this->adjacency[e];
+                size_t neighbor = edge.first;
+                if (parents[neighbor].load(std::memory_order_relaxed) == mark)
                 {
-                    TranslationVector difference = curr_position - original_positions[vert_index];
-                    // got new entry to basis set
-                    if (check_translation_independent(basis_set, difference))
-                    {
-                        basis_set.push_back(difference);
+                    parents[neighbor].store(discovered, std::memory_order_relaxed);
+                    positions[neighbor] = curr_position + position_type(edge.second.translation);
+                    push(neighbor);
+                    PERCOLATION_STAT(thread_counters[thread_index].queue_pushes++;)
+                }
+            }
+        };
+
+        auto claim = [&](size_t queue_index) {
+            size_t vert_index = component_vertices[queue_index];
+            size_t mark = discovered - 1 - queue_index;
+            for (size_t e = adjacency_offsets[vert_index]; e < adjacency_offsets[vert_index + 1]; e++)
+            {
+                std::atomic<size_t> &entry = parents[this->adjacency[e].first];
+                size_t curr_mark = entry.load(std::memory_order_relaxed);
+                while (curr_mark < mark && !entry.compare_exchange_weak(curr_mark, mark, std::memory_order_relaxed))
+                {
+                }
+            }
+        };
 
-                        // Maximum dimension attained, stop analysis
-                        if (basis_set.size() >= vector_space_dimension)
+        parallel_run(thread_count, [&](size_t thread_index) {
+            std::vector<size_t> &frontier = thread_frontiers[thread_index];
+            frontier.clear();
+            size_t level_begin = 0;
+            size_t level_end = 1;
+            while (true)
+            {
+                if (level_end - level_begin < parallel_level_min_size)
+                {
+                    // Splitting a narrow level costs more than it saves, so the first thread expands levels on its own until they
+                    // get wide enough, while the others wait. This keeps long chains from paying for barriers on every level.
+                    if (thread_index == 0)
+                    {
+                        while (level_begin < level_end && level_end - level_begin < parallel_level_min_size)
                         {
-                            break;
+                            size_t next_end = level_end;
+                            for (size_t i = level_begin; i < level_end; i++)
+                            {
+                                expand(i, root, 0, [&](size_t neighbor) { component_vertices[next_end++] = neighbor; });
+                            }
+                            PERCOLATION_STAT(thread_counters[0].peak_queue_length = std::max(thread_counters[0].peak_queue_length, next_end - level_end);)
+                            level_begin = level_end;
+                            level_end = next_end;
                         }
+                        shared_level_begin = level_begin;
+                        shared_level_end = level_end;
+                    }
+                    barrier.arrive_and_wait();
+                    level_begin = shared_level_begin;
+                    level_end = shared_level_end;
+                    if (level_begin == level_end)
+                    {
+                        break;
                     }
-                    continue;
                 }
 
-                // Deal with first copy of vertex
-                visited[vert_index] = true;
-                original_positions[vert_index] = curr_position;
-                for (auto edge : this->edges[vert_index])
+                // Every neighbor is claimed first, so that it is discovered from the same vertex as in the serial bfs
+                while (true)
+                {
+                    size_t begin = level_begin + next_task.fetch_add(frontier_grain_size, std::memory_order_relaxed);
+                    if (begin >= level_end)
+                    {
+                        break;
+                    }
+                    size_t end = std::min(level_end, begin + frontier_grain_size);
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        claim(i);
+                    }
+                }
+                barrier.arrive_and_wait();
+                if (thread_index == 0)
+                {
+                    next_task.store(0, std::memory_order_relaxed);
+                }
+
+                // The chunks of the level are expanded in any order, but each one records where its neighbors are
+                const size_t num_chunks = (level_end - level_begin + frontier_grain_size - 1) / frontier_grain_size;
+                while (true)
+                {
+                    size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+                    if (chunk >= num_chunks)
+                    {
+                        break;
+                    }
+                    size_t begin = level_begin + chunk * frontier_grain_size;
+                    size_t end = std::min(level_end, begin + frontier_grain_size);
+                    size_t chunk_begin = frontier.size();
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        expand(i, discovered - 1 - i, thread_index, [&](size_t neighbor) { frontier.push_back(neighbor); });
+                    }
+                    level_chunks[3 * chunk] = frontier.size() - chunk_begin;
+                    level_chunks[3 * chunk + 1] = thread_index;
+                    level_chunks[3 * chunk + 2] = chunk_begin;
+                }
+                barrier.arrive_and_wait();
+
+                // The next level lists the neighbors chunk after chunk, so its order does not depend on the thread timing
+                size_t next_end = level_end;
+                for (size_t chunk = 0; chunk < num_chunks; chunk++)
+                {
+                    if (level_chunks[3 * chunk + 1] == thread_index)
+                    {
+                        const size_t *chunk_vertices = frontier.data() + level_chunks[3 * chunk + 2];
+                        std::copy(chunk_vertices, chunk_vertices + level_chunks[3 * chunk], component_vertices + next_end);
+                    }
+                    next_end += level_chunks[3 * chunk];
+                }
+                if (thread_index == 0)
+                {
+                    next_chunk.store(0, std::memory_order_relaxed);
+                    PERCOLATION_STAT(thread_counters[0].peak_queue_length = std::max(thread_counters[0].peak_queue_length, next_end - level_end);)
+                }
+                barrier.arrive_and_wait();
+
+                frontier.clear();
+                level_begin = level_end;
+                level_end = next_end;
+                if (level_begin == level_end)
+                {
+                    break;
+                }
+            }
+
+            if (!check_cycles)
+            {
+                return;
+            }
+
+            // Edges of the bfs tree have a zero net translation, every other edge is evaluated once from its endpoint with the smaller index
+            basis_type &basis_set = thread_bases[thread_index];
+            while (!basis_full.load(std::memory_order_relaxed))
+            {
+                size_t begin = next_task.fetch_add(vertex_block_size, std::memory_order_relaxed);
+                if (begin >= comp_size)
+                {
+                    break;
+                }
+                size_t end = std::min(comp_size, begin + vertex_block_size);
+                for (size_t i = begin; i < end && !basis_full.load(std::memory_order_relaxed); i++)
                 {
-                    size_t neighbor = edge.first;
-                    TranslationVector target_position = curr_position + edge.second.translation;
-                    if (!visited[neighbor] || !(original_positions[vert_index] == target_position))
+                    size_t vert_index = component_vertices[i];
+                    const position_type &curr_position = positions[vert_index];
+                    for (size_t e = adjacency_offsets[vert_index]; e < adjacency_offsets[vert_index + 1]; e++)
                     {
-                        vertex_queue.push({neighbor, target_position});
+                        const auto &edge = this->adjacency[e];
+                        size_t neighbor = edge.first;
+                        if (neighbor < vert_index)
+                        {
+                            continue;
+                        }
+
+                        position_type difference = curr_position + position_type(edge.second.translation) - positions[neighbor];
+                        if (difference == position_type::zero())
+                        {
+                            continue;
+                        }
+
+                        PERCOLATION_STAT(thread_counters[thread_index].independence_checks++;)
+                        if (basis_set.insert(difference) && basis_set.size() >= Dim)
+                        {
+                            basis_full.store(true, std::memory_order_relaxed);
+                            break;
+                        }
                     }
                 }
             }
-            curr_info.percolation_dim = basis_set.size();
+        });
+
+        if (!check_cycles)
+        {
+            return 0;
         }
 
-        return component_info;
+        basis_type basis_set;
+        for (const basis_type &thread_basis : thread_bases)
+        {
+            for (size_t i = 0; i < thread_basis.size(); i++)
+            {
+                basis_set.insert(thread_basis[i]);
+            }
+        }
+        return basis_set.size();
     }
 
-    std::vector<ComponentInfo> PercolationGraph::get_components() const
+    template <size_t Dim, typename Coord>
+    void BasicPercolationGraph<Dim, Coord>::label_components(std::vector<size_t> &start_vertices, std::vector<size_t> &component_sizes, std::vector<size_t> &component_edges, std::vector<uint8_t> &visited) const
     {
-        std::vector<ComponentInfo> component_info;
-        size_t curr_comp = 0;
         size_t num_vertices = this->vertices.size();
-        std::vector<bool> visited(num_vertices, false);
+        std::queue<size_t> vertex_queue;
 
         for (size_t curr_vertex = 0; curr_vertex < num_vertices; curr_vertex++)
         {
@@ -319,13 +1330,11 @@ namespace percolation
                 continue;
             }
 
-            std::queue<size_t> vertex_queue;
-            vertex_queue.push(curr_vertex);
+            size_t num_comp_vertices = 0;
+            size_t num_comp_edges = 0;
 
-            // Create new component metadata
-            ComponentInfo new_comp;
-            new_comp.component_index = curr_comp++;
-            new_comp.percolation_dim = (size_t)-1;
+            visited[curr_vertex] = 1;
+            vertex_queue.push(curr_vertex);
 
             // Find all vertices in component via BFS
             while (!vertex_queue.empty())
@@ -333,24 +1342,110 @@ namespace percolation
                 size_t vert_index = vertex_queue.front();
                 vertex_queue.pop();
 
-                if (visited[vert_index])
+                num_comp_vertices++;
+                num_comp_edges += adjacency_offsets[vert_index + 1] - adjacency_offsets[vert_index];
+                for (size_t e = adjacency_offsets[vert_index]; e < adjacency_offsets[vert_index + 1]; e++)
                 {
-                    continue;
-                }
-
-                new_comp.vertices.push_back(vertices[vert_index]);
-                visited[vert_index] = true;
-                for (auto edge : this->edges[vert_index])
-                {
-                    size_t neighbor = edge.first;
+                    size_t neighbor = this->adjacency[e].first;
                     if (!visited[neighbor])
                     {
+                        visited[neighbor] = 1;
                         vertex_queue.push(neighbor);
                     }
                 }
             }
-            component_info.push_back(new_comp);
+            start_vertices.push_back(curr_vertex);
+            component_sizes.push_back(num_comp_vertices);
+            component_edges.push_back(num_comp_edges);
         }
-        return component_info;
     }
+
+    template <size_t Dim, typename Coord>
+    size_t BasicPercolationGraph<Dim, Coord>::analyze_component(size_t start_vertex, bool check_cycles, size_t *component_vertices, size_t &num_component_vertices, std::vector<uint8_t> &visited, std::vector<position_type> &positions, BfsCounters *counters, QueryTarget *target) const
+    {
+        (void)counters;
+
+        // Vertex states: not reached yet, reached and waiting in the queue, all edges examined
+        const uint8_t discovered = 1;
+        const uint8_t finished = 2;
+
+        const position_type origin = position_type::zero();
+
+        basis_type basis_set;
+
+        // Every vertex is appended exactly once when it is reached, so the component list itself serves as the bfs queue
+        size_t num_queued = 0;
+        visited[start_vertex] = discovered;
+        positions[start_vertex] = origin;
+        component_vertices[num_queued++] = start_vertex;
+
+        // A query without any requirement on the translations is satisfied by every component
+        if (target != nullptr && is_target_reached(basis_set, *target))
+        {
+            target->reached = true;
+            num_component_vertices = num_queued;
+            return 0;
+        }
+
+        for (size_t queue_pos = 0; queue_pos < num_queued; queue_pos++)
+        {
+            size_t vert_index = component_vertices[queue_pos];
+            PERCOLATION_STAT(counters->vertices_visited++; counters->edges_visited += adjacency_offsets[vert_index + 1] - adjacency_offsets[vert_index];)
+            PERCOLATION_STAT(counters->peak_queue_length = std::max(counters->peak_queue_length, num_queued - queue_pos);)
+
+            const position_type &curr_position = positions[vert_index];
+            for (size_t e = adjacency_offsets[vert_index]; e < adjacency_offsets[vert_index + 1]; e++)
+            {
+                const auto &edge = this->adjacency[e];
+                size_t neighbor = edge.first;
+
+                // Deal with first copy of vertex: the edge becomes part of the spanning tree
+                if (!visited[neighbor])
+                {
+                    visited[neighbor] = discovered;
+                    positions[neighbor] = curr_position + position_type(edge.second.translation);
+                    component_vertices[num_queued++] = neighbor;
+                    PERCOLATION_STAT(counters->queue_pushes++;)
+                    continue;
+                }
+
+                // The edge has already been examined from the side of the neighbor (this includes the edge to the bfs parent).
+                // Maximum dimension attained, only the component discovery needs to be finished.
+                if (visited[neighbor] == finished || !check_cycles || basis_set.size() >= Dim)
+                {
+                    continue;
+                }
+
+                // Each edge outside of the spanning tree is evaluated exactly once as a candidate lattice vector
+                position_type difference = curr_position + position_type(edge.second.translation) - positions[neighbor];
+                if (difference == origin)
+                {
+                    continue;
+                }
+
+                // got new entry to basis set
+                PERCOLATION_STAT(counters->independence_checks++;)
+                if (basis_set.insert(difference) && target != nullptr && is_target_reached(basis_set, *target))
+                {
+                    target->reached = true;
+                    num_component_vertices = num_queued;
+                    return basis_set.size();
+                }
+            }
+            visited[vert_index] = finished;
+        }
+        num_component_vertices = num_queued;
+        return basis_set.size();
+    }
+
+    static_assert((vector_space_dimension == 2 || vector_space_dimension == 3) &&
+                      (std::is_same<translation_coordinate_type, int8_t>::value || std::is_same<translation_coordinate_type, int32_t>::value || std::is_same<translation_coordinate_type, int64_t>::value),
+                  "The default dimension and coordinate type need to be one of the explicit instantiations");
+
+    template class BasicPercolationGraph<2, int8_t>;
+    template class BasicPercolationGraph<2, int32_t>;
+    template class BasicPercolationGraph<2, int64_t>;
+    template class BasicPercolationGraph<3, int8_t>;
+    template class BasicPercolationGraph<3, int32_t>;
+    template class BasicPercolationGraph<3, int64_t>;
 }
\ No newline at end of file
@@ -0,0 +1,414 @@
+#define CATCH_CONFIG_RUNNER // The benchmark parameters are added to the command line of Catch
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+#include "percolation-detection.hpp"
+#include "molecular-graph.hpp"
+#include "percolation-analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     * @brief Parameters of the synthetic graphs, set from the command line
+     */
+    struct BenchmarkParameters
+    {
+        size_t num_vertices = 100000;
+
+        /**
+         * @brief Average number of edges per vertex (counting each edge once)
+         */
+        double edges_per_vertex = 1.2;
+
+        /**
+         * @brief Fraction of the edges with a non-zero translation, i.e. that cross the periodic boundary
+         */
+        double cycle_density = 0.05;
+
+        /**
+         * @brief Size of the clusters the edges are confined to, 0 for a single cluster of all vertices
+         */
+        size_t component_size = 0;
+
+        /**
+         * @brief "fixed" for clusters of component_size vertices, "powerlaw" for sizes distributed as s^-2.5 up to component_size
+         */
+        std::string size_distribution = "fixed";
+
+        unsigned int seed = 42;
+    };
+
+    BenchmarkParameters parameters;
+
+    /**
+     * @brief Edge list of the synthetic graph, generated once for all benchmarks
+     * 
+     * The vertices are split into clusters. Each cluster is connected by a random tree, the remaining edges connect random 
+     * vertices of the same cluster and close cycles. Every edge crosses the periodic boundary with probability cycle_density.
+     */
+    const std::vector<percolation::Edge> &get_edges()
+    {
+        static std::vector<percolation::Edge> edges;
+        static bool generated = false;
+        if (generated)
+        {
+            return edges;
+        }
+        generated = true;
+
+        const size_t num_vertices = parameters.num_vertices;
+        const size_t max_size = (parameters.component_size == 0 ? num_vertices : std::min(parameters.component_size, num_vertices));
+        std::mt19937_64 engine(parameters.seed);
+        std::uniform_real_distribution<double> unit_distr(0.0, 1.0);
+        std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+        std::vector<size_t> cluster_begin(1, 0);
+        while (cluster_begin.back() < num_vertices)
+        {
+            size_t size = max_size;
+            if (parameters.size_distribution == "powerlaw")
+            {
+                // Inverse transform sampling of a discretized power law with exponent -2.5
+                double s = std::pow(1.0 - unit_distr(engine), -1.0 / 1.5);
+                size = std::min(max_size, size_t(s));
+            }
+            cluster_begin.push_back(std::min(num_vertices, cluster_begin.back() + std::max<size_t>(1, size)));
+        }
+
+        auto random_translation = [&]() {
+            percolation::EdgeData data;
+            for (size_t i = 0; i < vector_space_dimension; i++)
+            {
+                data.translation[i] = 0;
+            }
+            if (unit_distr(engine) < parameters.cycle_density)
+            {
+                data.translation[std::uniform_int_distribution<size_t>(0, vector_space_dimension - 1)(engine)] = (trans_distr(engine) >= 0 ? 1 : -1);
+            }
+            return data;
+        };
+
+        const size_t num_edges = size_t(parameters.edges_per_vertex * double(num_vertices));
+        edges.reserve(num_edges);
+        for (size_t c = 0; c + 1 < cluster_begin.size(); c++)
+        {
+            for (size_t v = cluster_begin[c] + 1; v < cluster_begin[c + 1]; v++)
+            {
+                size_t parent = std::uniform_int_distribution<size_t>(cluster_begin[c], v - 1)(engine);
+                edges.push_back({parent, v, random_translation()});
+            }
+        }
+
+        // Extra edges within clusters of at least two vertices, picked proportionally to the cluster size
+        std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+        size_t attempts = 0;
+        while (edges.size() < num_edges && attempts++ < 4 * num_edges)
+        {
+            size_t base = vertex_distr(engine);
+            size_t c = std::upper_bound(cluster_begin.begin(), cluster_begin.end(), base) - cluster_begin.begin() - 1;
+            if (cluster_begin[c + 1] - cluster_begin[c] < 2)
+            {
+                continue;
+            }
+            size_t head = std::uniform_int_distribution<size_t>(cluster_begin[c], cluster_begin[c + 1] - 1)(engine);
+            edges.push_back({base, head, random_translation()});
+        }
+        return edges;
+    }
+
+    /**
+     * @brief Exposes the component discovery without the percolation analysis
+     */
+    class InspectablePercolationGraph : public percolation::PercolationGraph
+    {
+    public:
+        size_t find_components(std::vector<size_t> &start_vertices, std::vector<size_t> &sizes, std::vector<size_t> &num_edges, std::vector<uint8_t> &visited) const
+        {
+            start_vertices.clear();
+            sizes.clear();
+            num_edges.clear();
+            visited.assign(vertices.size(), 0);
+            label_components(start_vertices, sizes, num_edges, visited);
+            return start_vertices.size();
+        }
+    };
+
+    /**
+     * @brief Writes the results of all benchmarks and the benchmark parameters as one JSON document
+     */
+    class JsonReporter : public Catch::StreamingReporterBase<JsonReporter>
+    {
+    public:
+        using StreamingReporterBase::StreamingReporterBase;
+
+        static std::string getDescription()
+        {
+            return "Reports the benchmark results as JSON";
+        }
+
+        void testRunStarting(Catch::TestRunInfo const &run_info) override
+        {
+            StreamingReporterBase::testRunStarting(run_info);
+            stream << "{\n  \"parameters\": {\"vertices\": " << parameters.num_vertices << ", \"edges_per_vertex\": " << parameters.edges_per_vertex
+                   << ", \"cycle_density\": " << parameters.cycle_density << ", \"component_size\": " << parameters.component_size
+                   << ", \"size_distribution\": \"" << parameters.size_distribution << "\", \"seed\": " << parameters.seed << "},\n  \"benchmarks\": [";
+        }
+
+        void benchmarkEnded(Catch::BenchmarkStats<> const &stats) override
+        {
+            stream << (num_benchmarks++ > 0 ? ",\n" : "\n") << "    {\"name\": \"" << stats.info.name << "\", \"mean_ns\": " << stats.mean.point.count()
+                   << ", \"mean_lower_ns\": " << stats.mean.lower_bound.count() << ", \"mean_upper_ns\": " << stats.mean.upper_bound.count()
+                   << ", \"std_dev_ns\": " << stats.standardDeviation.point.count() << ", \"samples\": " << stats.samples.size()
+                   << ", \"iterations\": " << stats.info.iterations << "}";
+        }
+
+        void testRunEnded(Catch::TestRunStats const &run_stats) override
+        {
+            stream << "\n  ]\n}" << std::endl;
+            StreamingReporterBase::testRunEnded(run_stats);
+        }
+
+        void assertionStarting(Catch::AssertionInfo const &) override {}
+
+        bool assertionEnded(Catch::AssertionStats const &) override
+        {
+            return true;
+        }
+
+    protected:
+        size_t num_benchmarks = 0;
+    };
+}
+
+CATCH_REGISTER_REPORTER("json", JsonReporter)
+
+TEST_CASE("Graph construction", "[bench build]")
+{
+    const std::vector<percolation::Edge> &edges = get_edges();
+    percolation::PercolationGraph graph;
+
+    BENCHMARK("build_from_edges")
+    {
+        graph.reset();
+        graph.reserve_vertices(parameters.num_vertices);
+        return graph.build_from_edges(edges);
+    };
+
+    BENCHMARK("add_edge and finalize")
+    {
+        graph.reset();
+        graph.reserve_vertices(parameters.num_vertices);
+        for (const percolation::Edge &edge : edges)
+        {
+            graph.add_edge(edge.base, edge.head, edge.data);
+        }
+        graph.finalize();
+    };
+}
+
+TEST_CASE("Component discovery and percolation analysis", "[bench analysis]")
+{
+    InspectablePercolationGraph graph;
+    graph.reserve_vertices(parameters.num_vertices);
+    graph.build_from_edges(get_edges());
+    graph.finalize();
+
+    std::vector<size_t> start_vertices, sizes, num_edges;
+    std::vector<uint8_t> visited;
+    BENCHMARK("get_components")
+    {
+        return graph.find_components(start_vertices, sizes, num_edges, visited);
+    };
+
+    percolation::PercolationGraph::AnalysisWorkspace workspace;
+    BENCHMARK("percolation bfs (get_component_percolation_info)")
+    {
+        return graph.get_component_percolation_info(workspace);
+    };
+
+    percolation::ComponentLabels labels;
+    BENCHMARK("percolation bfs (get_component_labels)")
+    {
+        graph.get_component_labels(labels, workspace);
+        return labels.get_num_components();
+    };
+
+    graph.set_num_threads(0);
+    BENCHMARK("parallel percolation bfs (get_component_labels)")
+    {
+        graph.get_component_labels(labels, workspace);
+        return labels.get_num_components();
+    };
+}
+
+TEST_CASE("Linear independence of translations", "[bench translation basis]")
+{
+    // Random bases of 0 to 2 vectors and a candidate, as they occur during the bfs
+    const size_t num_checks = 10000;
+    std::mt19937 engine(parameters.seed);
+    std::uniform_int_distribution<int> coord_distr(-3, 3);
+    std::vector<std::vector<percolation::TranslationVector>> bases(num_checks);
+    std::vector<percolation::TranslationVector> candidates(num_checks);
+    for (size_t c = 0; c < num_checks; c++)
+    {
+        bases[c].resize(c % vector_space_dimension);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            candidates[c][i] = coord_distr(engine);
+        }
+        for (percolation::TranslationVector &base_vector : bases[c])
+        {
+            for (size_t i = 0; i < vector_space_dimension; i++)
+            {
+                base_vector[i] = coord_distr(engine);
+            }
+        }
+    }
+
+    BENCHMARK("check_translation_independent x10000")
+    {
+        size_t num_independent = 0;
+        for (size_t c = 0; c < num_checks; c++)
+        {
+            num_independent += (percolation::check_translation_independent(bases[c], candidates[c]) ? 1 : 0);
+        }
+        return num_independent;
+    };
+}
+
+TEST_CASE("Conversion of a molecular graph", "[bench molecular graph]")
+{
+    // Random atoms at unit density, with the cutoff chosen for the requested average number of bonds per atom
+    const double side = std::cbrt(double(parameters.num_vertices));
+    const double cutoff = std::min(0.45 * side, std::cbrt(3.0 * 2.0 * parameters.edges_per_vertex / (4.0 * std::acos(-1.0))));
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = basis[1][1] = basis[2][2] = side;
+
+    std::mt19937 engine(parameters.seed);
+    std::uniform_real_distribution<double> coord_distr(0.0, side);
+    mol::MolecularGraph frame;
+    frame.set_atom_count(parameters.num_vertices);
+    frame.set_basis(basis);
+    for (size_t i = 0; i < parameters.num_vertices; i++)
+    {
+        vec<double> pos;
+        pos.x = coord_distr(engine);
+        pos.y = coord_distr(engine);
+        pos.z = coord_distr(engine);
+        frame.set_atom_position(i, pos);
+    }
+
+    BENCHMARK("add_bonds_within_cutoff")
+    {
+        frame.clear_bonds();
+        return frame.add_bonds_within_cutoff(cutoff);
+    };
+
+    BENCHMARK("get_percolation_graph")
+    {
+        return frame.get_percolation_graph();
+    };
+
+    percolation::PercolationGraph graph;
+    mol::ConversionWorkspace workspace;
+    BENCHMARK("fill_percolation_graph")
+    {
+        frame.fill_percolation_graph(graph, workspace);
+    };
+}
+
+TEST_CASE("C interface", "[bench c interface]")
+{
+    const std::vector<percolation::Edge> &edges = get_edges();
+    std::vector<int64_t> sources(edges.size()), heads(edges.size()), translations(3 * edges.size(), 0);
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        sources[e] = int64_t(edges[e].base);
+        heads[e] = int64_t(edges[e].head);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            translations[3 * e + i] = edges[e].data.translation[i];
+        }
+    }
+    std::vector<int64_t> labels(parameters.num_vertices), dims(parameters.num_vertices);
+
+    PercolationAnalyzer *analyzer = create_PercolationAnalyzer();
+    BENCHMARK("add_edge_translation per edge")
+    {
+        reset_PercolationAnalyzer(analyzer);
+        reserve_memory(analyzer, parameters.num_vertices);
+        TranslationVector trans;
+        for (size_t e = 0; e < edges.size(); e++)
+        {
+            trans.x = translations[3 * e];
+            trans.y = translations[3 * e + 1];
+            trans.z = translations[3 * e + 2];
+            add_edge_translation(analyzer, sources[e], heads[e], &trans);
+        }
+    };
+
+    BENCHMARK("add_edges")
+    {
+        reset_PercolationAnalyzer(analyzer);
+        reserve_memory(analyzer, parameters.num_vertices);
+        return add_edges(analyzer, edges.size(), sources.data(), heads.data(), translations.data());
+    };
+
+    BENCHMARK("get_component_labels")
+    {
+        return get_component_labels(analyzer, labels.size(), labels.data(), dims.size(), dims.data());
+    };
+
+    BENCHMARK("get_PercolationInfo with vertex iteration")
+    {
+        PercolationInfo *info = get_PercolationInfo(analyzer);
+        size_t num_vertices = 0;
+        ComponentInfo *component;
+        while ((component = get_next_component(info)) != nullptr)
+        {
+            VertexList *list = get_component_vertices(component);
+            VertexData vertex;
+            while (get_next_VertexData(list, &vertex))
+            {
+                num_vertices++;
+            }
+            free_component_vertices(list);
+        }
+        free_PercolationInfo(info);
+        return num_vertices;
+    };
+    free_PercolationAnalyzer(analyzer);
+}
+
+int main(int argc, char *argv[])
+{
+    Catch::Session session;
+
+    using namespace Catch::clara;
+    auto cli = session.cli() |
+               Opt(parameters.num_vertices, "count")["--vertices"]("number of vertices (atoms) of the synthetic graphs") |
+               Opt(parameters.edges_per_vertex, "ratio")["--edges-per-vertex"]("average number of edges per vertex") |
+               Opt(parameters.cycle_density, "fraction")["--cycle-density"]("fraction of edges crossing the periodic boundary") |
+               Opt(parameters.component_size, "count")["--component-size"]("maximum component size, 0 for one component") |
+               Opt(parameters.size_distribution, "fixed|powerlaw")["--size-distribution"]("distribution of the component sizes") |
+               Opt(parameters.seed, "seed")["--seed"]("seed of the random graphs");
+    session.cli(cli);
+
+    int result = session.applyCommandLine(argc, argv);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (parameters.num_vertices == 0 || (parameters.size_distribution != "fixed" && parameters.size_distribution != "powerlaw"))
+    {
+        std::cerr << "Invalid benchmark parameters" << std::endl;
+        return 1;
+    }
+    return session.run();
+}
\ No newline at end of file
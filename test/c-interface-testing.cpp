@@ -0,0 +1,75 @@
+#include "catch.hpp"
+#include "percolation-analyzer.h"
+#include "percolation-detection.hpp"
+
+#include <random>
+#include <vector>
+
+// The C interface declares structs of the same names as the c++ library, so it is tested in its own translation unit
+
+TEST_CASE("The bulk C interface should match the c++ analysis", "[c interface]")
+{
+    const size_t num_vertices = 400;
+    const size_t num_edges = 500;
+
+    std::mt19937 engine(17u);
+    std::uniform_int_distribution<int64_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int64_t> trans_distr(-1, 1);
+
+    std::vector<int64_t> sources(num_edges), heads(num_edges), translations(3 * num_edges);
+    percolation::PercolationGraph graph;
+    graph.reserve_vertices(num_vertices);
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        sources[e] = vertex_distr(engine);
+        heads[e] = vertex_distr(engine);
+        percolation::TranslationVector trans;
+        for (size_t i = 0; i < 3; i++)
+        {
+            translations[3 * e + i] = trans_distr(engine);
+            trans[i] = translations[3 * e + i];
+        }
+        graph.add_edge(sources[e], heads[e], trans);
+    }
+    std::vector<percolation::ComponentInfo> expected = graph.get_component_percolation_info();
+
+    PercolationAnalyzer *analyzer = create_PercolationAnalyzer();
+    reserve_memory(analyzer, num_vertices);
+    REQUIRE(add_edges(analyzer, num_edges, sources.data(), heads.data(), translations.data()) == 1);
+
+    // One more entry than vertices in the graph, which is not part of any component
+    std::vector<int64_t> labels(num_vertices + 1, 42);
+    std::vector<int64_t> dims(num_vertices + 1, 42);
+    REQUIRE(get_component_labels(analyzer, labels.size(), labels.data(), dims.size(), dims.data()) == expected.size());
+    REQUIRE(labels[num_vertices] == -1);
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(dims[c] == int64_t(expected[c].percolation_dim));
+        for (const percolation::VertexData &vertex : expected[c].vertices)
+        {
+            REQUIRE(labels[vertex.index] == int64_t(c));
+        }
+    }
+
+    // The iterator interface reports the same components
+    PercolationInfo *info = get_PercolationInfo(analyzer);
+    REQUIRE(get_num_components(info) == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        ComponentInfo *component = get_next_component(info);
+        REQUIRE(get_component_percolation_dimension(component) == expected[c].percolation_dim);
+    }
+    REQUIRE(get_next_component(info) == nullptr);
+    free_PercolationInfo(info);
+
+    // Invalid input adds nothing
+    int64_t negative = -1;
+    REQUIRE(add_edges(analyzer, 1, &negative, heads.data(), translations.data()) == 0);
+    REQUIRE(add_edges(analyzer, 1, nullptr, heads.data(), translations.data()) == 0);
+    REQUIRE(get_component_labels(analyzer, 0, nullptr, 0, nullptr) == expected.size());
+
+    reset_PercolationAnalyzer(analyzer);
+    REQUIRE(get_component_labels(analyzer, labels.size(), labels.data(), dims.size(), dims.data()) == 0);
+    REQUIRE(labels[0] == -1);
+    free_PercolationAnalyzer(analyzer);
+}
\ No newline at end of file
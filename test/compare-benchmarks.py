@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Compare the JSON output of bench_runner (-r json) against a stored baseline.
+
+Usage: compare-benchmarks.py baseline.json current.json [--threshold 0.1]
+
+Prints the relative change of the mean time of every benchmark and exits with status 1 if any benchmark
+became slower than the baseline by more than the threshold (default 10%) beyond the confidence intervals.
+"""
+
+import argparse
+import json
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare bench_runner results against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.1, help="tolerated relative slowdown")
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+
+    if baseline["parameters"] != current["parameters"]:
+        print("Warning: the benchmark parameters differ")
+        print("  baseline: {}".format(baseline["parameters"]))
+        print("  current:  {}".format(current["parameters"]))
+
+    baseline_results = {bench["name"]: bench for bench in baseline["benchmarks"]}
+    regressions = []
+    print("{:<55} {:>14} {:>14} {:>9}".format("benchmark", "baseline [us]", "current [us]", "change"))
+    for bench in current["benchmarks"]:
+        name = bench["name"]
+        if name not in baseline_results:
+            print("{:<55} {:>14} {:>14.1f} {:>9}".format(name, "-", bench["mean_ns"] / 1000.0, "new"))
+            continue
+
+        reference = baseline_results[name]
+        change = bench["mean_ns"] / reference["mean_ns"] - 1.0
+        # Only count a slowdown if the confidence intervals do not overlap
+        slower = change > args.threshold and bench["mean_lower_ns"] > reference["mean_upper_ns"]
+        if slower:
+            regressions.append(name)
+        print("{:<55} {:>14.1f} {:>14.1f} {:>+8.1f}%{}".format(
+            name, reference["mean_ns"] / 1000.0, bench["mean_ns"] / 1000.0, 100.0 * change, " !" if slower else ""))
+
+    if regressions:
+        print("\n{} benchmark(s) slower than the baseline by more than {:.0f}%".format(len(regressions), 100.0 * args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
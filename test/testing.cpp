@@ -1,9 +1,87 @@
 #define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 #include "percolation-detection.hpp"
+#include "incremental-percolation.hpp"
+#include "dynamic-percolation.hpp"
+#include "frame-analysis.hpp"
+#include "coordinate-kernels.hpp"
+#include "frame-file.hpp"
+#include "lammps-reader.hpp"
+#include "frame-arena.hpp"
+#include "compact-percolation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <thread>
 
 using namespace percolation;
 
+namespace
+{
+    // Number of calls of the global operator new, to check that code paths do not allocate memory
+    std::atomic<size_t> num_global_allocations(0);
+
+    // Heap resource that counts its allocations, to also catch pmr containers falling back to the default resource
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t num_allocations = 0;
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            num_allocations++;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *ptr, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+void *operator new(std::size_t size)
+{
+    num_global_allocations++;
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+// GCC warns about free() on memory from operator new once the replacements are inlined, although they match
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 TEST_CASE("The graph should automatically allocate memory for entries", "[graph allocation]")
 {
     PercolationGraph graph;
@@ -266,4 +344,1678 @@ TEST_CASE("Deal with more complex 1d situations", "[graph 1d complex]")
     REQUIRE(component.vertices.size() == 11);
     REQUIRE(component.percolation_dim == 0);
     REQUIRE(component.component_index == 0);
+}
+
+TEST_CASE("The incremental graph should detect loop dimensions while edges are added", "[incremental loop]")
+{
+    IncrementalPercolationGraph graph;
+
+    TranslationVector trans0, trans1, trans2, trans3;
+
+    trans0.vec[0] = 0;
+    trans0.vec[1] = 0;
+    trans0.vec[2] = 0;
+
+    trans1.vec[0] = 1;
+    trans1.vec[1] = 0;
+    trans1.vec[2] = 0;
+
+    trans2.vec[0] = 0;
+    trans2.vec[1] = 1;
+    trans2.vec[2] = 0;
+
+    trans3.vec[0] = 0;
+    trans3.vec[1] = 0;
+    trans3.vec[2] = 1;
+
+    graph.reserve_vertices(4);
+    REQUIRE(graph.get_num_components() == 4);
+
+    graph.add_edge(0, 1, trans1);
+    graph.add_edge(1, 2, trans0);
+    REQUIRE(graph.get_num_components() == 2);
+    REQUIRE(graph.get_percolation_dim(0) == 0);
+
+    // Closing the cycle without net translation does not percolate
+    graph.add_edge(2, 0, trans0 - trans1);
+    REQUIRE(graph.get_percolation_dim(2) == 0);
+
+    graph.add_edge(2, 0, trans0);
+    REQUIRE(graph.get_percolation_dim(0) == 1);
+
+    graph.add_edge(3, 3, trans2);
+    REQUIRE(graph.get_percolation_dim(3) == 1);
+
+    // Merging two 1d components with different directions
+    graph.add_edge(3, 1, trans3);
+    REQUIRE(graph.get_num_components() == 1);
+    REQUIRE(graph.get_percolation_dim(0) == 2);
+
+    graph.add_edge(0, 3, trans3);
+    REQUIRE(graph.get_percolation_dim(1) == 3);
+
+    std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+    REQUIRE(components.size() == 1);
+    REQUIRE(components[0].vertices.size() == 4);
+    REQUIRE(components[0].percolation_dim == 3);
+}
+
+TEST_CASE("The incremental graph should agree with the full analysis", "[incremental random]")
+{
+    const size_t num_vertices = 200;
+    const size_t num_edges = 260;
+
+    std::mt19937 engine(GENERATE(1u, 2u, 3u));
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+    PercolationGraph graph;
+    IncrementalPercolationGraph incremental;
+    graph.reserve_vertices(num_vertices);
+    incremental.reserve_vertices(num_vertices);
+
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        size_t base = vertex_distr(engine);
+        size_t head = vertex_distr(engine);
+        TranslationVector trans;
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        graph.add_edge(base, head, trans);
+        incremental.add_edge(base, head, trans);
+
+        if (e % 20 != 19)
+        {
+            continue;
+        }
+
+        std::vector<ComponentInfo> expected = graph.get_component_percolation_info();
+        std::vector<ComponentInfo> components = incremental.get_component_percolation_info();
+
+        REQUIRE(components.size() == expected.size());
+        REQUIRE(incremental.get_num_components() == expected.size());
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(components[c].component_index == expected[c].component_index);
+            REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+            REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+            REQUIRE(components[c].vertices[0].index == expected[c].vertices[0].index);
+        }
+    }
+}
+
+TEST_CASE("The dynamic graph should agree with the full analysis while edges are added and removed", "[dynamic random]")
+{
+    const size_t num_vertices = 200;
+    const size_t num_edges = 240;
+    const size_t num_frames = 30;
+    const size_t changes_per_frame = 12;
+
+    std::mt19937 engine(GENERATE(4u, 5u, 6u));
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+    auto random_edge = [&]() {
+        Edge edge;
+        edge.base = vertex_distr(engine);
+        edge.head = vertex_distr(engine);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            edge.data.translation.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        return edge;
+    };
+
+    DynamicPercolationGraph dynamic;
+    dynamic.reserve_vertices(num_vertices);
+
+    std::vector<Edge> edges;
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        edges.push_back(random_edge());
+        REQUIRE(dynamic.add_edge(edges.back().base, edges.back().head, edges.back().data));
+    }
+
+    for (size_t frame = 0; frame < num_frames; frame++)
+    {
+        std::vector<Edge> added, removed;
+        for (size_t c = 0; c < changes_per_frame; c++)
+        {
+            // Remove a random existing edge, sometimes given in the opposite direction
+            size_t removed_index = std::uniform_int_distribution<size_t>(0, edges.size() - 1)(engine);
+            Edge edge = edges[removed_index];
+            edges[removed_index] = edges.back();
+            edges.pop_back();
+            if (c % 2 == 0)
+            {
+                edge = {edge.head, edge.base, edge.data.inverse()};
+            }
+            removed.push_back(edge);
+
+            added.push_back(random_edge());
+        }
+        edges.insert(edges.end(), added.begin(), added.end());
+
+        if (frame % 2 == 0)
+        {
+            REQUIRE(dynamic.apply_bond_delta(added, removed));
+        }
+        else
+        {
+            for (const Edge &edge : removed)
+            {
+                REQUIRE(dynamic.remove_edge(edge.base, edge.head, edge.data));
+            }
+            for (const Edge &edge : added)
+            {
+                REQUIRE(dynamic.add_edge(edge.base, edge.head, edge.data));
+            }
+        }
+
+        PercolationGraph graph;
+        graph.reserve_vertices(num_vertices);
+        graph.build_from_edges(edges);
+
+        std::vector<ComponentInfo> expected = graph.get_component_percolation_info();
+        std::vector<ComponentInfo> components = dynamic.get_component_percolation_info();
+
+        REQUIRE(components.size() == expected.size());
+        REQUIRE(dynamic.get_num_components() == expected.size());
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(components[c].component_index == expected[c].component_index);
+            REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+            REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+            REQUIRE(components[c].vertices[0].index == expected[c].vertices[0].index);
+            REQUIRE(dynamic.get_percolation_dim(expected[c].vertices[0].index) == expected[c].percolation_dim);
+        }
+    }
+
+    // Edges that are not part of the graph cannot be removed
+    REQUIRE(!dynamic.remove_edge(num_vertices + 1, 0, TranslationVector()));
+}
+
+namespace
+{
+    // Gives the tests access to the spanning forest and the search marks
+    struct InspectableDynamicGraph : public DynamicPercolationGraph
+    {
+        using DynamicPercolationGraph::curr_stamp;
+        using DynamicPercolationGraph::tree_parent;
+        using DynamicPercolationGraph::tree_translation;
+        using DynamicPercolationGraph::visit_stamp;
+    };
+}
+
+TEST_CASE("Removing a tree edge from a large cyclic component should only search around the edge", "[dynamic local]")
+{
+    // Periodic simple cubic lattice
+    const size_t side_length = 16;
+    const size_t num_vertices = side_length * side_length * side_length;
+
+    InspectableDynamicGraph dynamic;
+    dynamic.reserve_vertices(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++)
+    {
+        size_t coords[3] = {v % side_length, (v / side_length) % side_length, v / (side_length * side_length)};
+        size_t stride = 1;
+        for (size_t d = 0; d < 3; d++)
+        {
+            TranslationVector trans = TranslationVector::zero();
+            size_t neighbor = v + stride;
+            if (coords[d] + 1 == side_length)
+            {
+                trans[d] = 1;
+                neighbor -= side_length * stride;
+            }
+            REQUIRE(dynamic.add_edge(v, neighbor, trans));
+            stride *= side_length;
+        }
+    }
+    REQUIRE(dynamic.get_num_components() == 1);
+    REQUIRE(dynamic.get_percolation_dim(0) == 3);
+
+    size_t max_searched = 0;
+    for (size_t v = 0; v < num_vertices; v++)
+    {
+        size_t parent = dynamic.tree_parent[v];
+        if (parent == v)
+        {
+            continue;
+        }
+        TranslationVector trans = dynamic.tree_translation[v];
+
+        size_t prev_stamp = dynamic.curr_stamp;
+        REQUIRE(dynamic.remove_edge(parent, v, trans));
+        size_t num_searched = std::count_if(dynamic.visit_stamp.begin(), dynamic.visit_stamp.end(), [&](size_t stamp) { return stamp > prev_stamp; });
+        max_searched = std::max(max_searched, num_searched);
+
+        REQUIRE(dynamic.get_num_components() == 1);
+        REQUIRE(dynamic.get_percolation_dim(v) == 3);
+        REQUIRE(dynamic.add_edge(parent, v, trans));
+    }
+    INFO("max_searched = " << max_searched);
+    REQUIRE(max_searched < num_vertices / 64);
+}
+
+TEST_CASE("Building the graph from an edge list should match adding the edges one by one", "[graph bulk build]")
+{
+    const size_t num_vertices = 150;
+    const size_t num_edges = 180;
+
+    std::mt19937 engine(GENERATE(4u, 5u));
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+    std::vector<Edge> edge_list;
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        Edge edge;
+        edge.base = vertex_distr(engine);
+        edge.head = vertex_distr(engine);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            edge.data.translation.vec[i] = trans_distr(engine);
+        }
+        edge_list.push_back(edge);
+    }
+
+    PercolationGraph graph;
+    for (const Edge &edge : edge_list)
+    {
+        graph.add_edge(edge.base, edge.head, edge.data);
+    }
+
+    // Build the first half in bulk and add the rest afterwards
+    PercolationGraph bulk_graph;
+    bulk_graph.build_from_edges(edge_list.data(), num_edges / 2);
+    for (size_t e = num_edges / 2; e < num_edges; e++)
+    {
+        bulk_graph.add_edge(edge_list[e].base, edge_list[e].head, edge_list[e].data);
+    }
+    bulk_graph.finalize();
+
+    std::vector<ComponentInfo> expected = graph.get_component_percolation_info();
+    std::vector<ComponentInfo> components = bulk_graph.get_component_percolation_info();
+
+    REQUIRE(components.size() == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+        REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+        for (size_t v = 0; v < expected[c].vertices.size(); v++)
+        {
+            REQUIRE(components[c].vertices[v].index == expected[c].vertices[v].index);
+        }
+    }
+
+    // The same edges in structure-of-arrays layout
+    std::vector<size_t> edge_base, edge_head;
+    std::vector<int8_t> edge_trans[vector_space_dimension];
+    for (const Edge &edge : edge_list)
+    {
+        edge_base.push_back(edge.base);
+        edge_head.push_back(edge.head);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            edge_trans[i].push_back(int8_t(edge.data.translation[i]));
+        }
+    }
+    const int8_t *trans_arrays[vector_space_dimension];
+    for (size_t i = 0; i < vector_space_dimension; i++)
+    {
+        trans_arrays[i] = edge_trans[i].data();
+    }
+    PercolationGraph array_graph;
+    REQUIRE(array_graph.build_from_edge_arrays(edge_base.data(), edge_head.data(), trans_arrays, num_edges));
+    components = array_graph.get_component_percolation_info();
+    REQUIRE(components.size() == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+        REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+        REQUIRE(components[c].vertices[0].index == expected[c].vertices[0].index);
+    }
+}
+
+TEST_CASE("Edges added concurrently should yield the same graph as edges added in slot order", "[concurrent edges]")
+{
+    const size_t num_slots = 4;
+    const size_t edges_per_slot = 2000;
+    const size_t num_vertices = 6000;
+
+    // Every slot gets its own list of edges, as if each thread owned a spatial domain
+    std::vector<std::vector<Edge>> slot_edges(num_slots);
+    std::mt19937 engine(15u);
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+    for (std::vector<Edge> &edges : slot_edges)
+    {
+        for (size_t e = 0; e < edges_per_slot; e++)
+        {
+            TranslationVector trans;
+            for (size_t i = 0; i < vector_space_dimension; i++)
+            {
+                trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+            }
+            edges.push_back({vertex_distr(engine), vertex_distr(engine), EdgeData(trans)});
+        }
+    }
+
+    PercolationGraph expected_graph;
+    for (const std::vector<Edge> &edges : slot_edges)
+    {
+        for (const Edge &edge : edges)
+        {
+            expected_graph.add_edge(edge.base, edge.head, edge.data);
+        }
+    }
+    ComponentLabels expected;
+    expected_graph.get_component_labels(expected);
+
+    // The same graph object is filled repeatedly to check that reset() keeps it usable.
+    // The edges of the first slot are added concurrently, via add_edge() or via add_edge() and merged before the others.
+    PercolationGraph graph;
+    const size_t merge_threads = GENERATE(1, 3);
+    graph.begin_concurrent_insertion(num_slots);
+    for (size_t repetition = 0; repetition < 3; repetition++)
+    {
+        graph.reset();
+        graph.set_num_threads(merge_threads);
+        size_t first_concurrent_slot = (repetition == 0 ? 0 : 1);
+        for (size_t e = 0; e < edges_per_slot && repetition > 0; e++)
+        {
+            graph.add_edge(slot_edges[0][e].base, slot_edges[0][e].head, slot_edges[0][e].data);
+        }
+        if (repetition == 2)
+        {
+            graph.finalize();
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t slot = first_concurrent_slot; slot < num_slots; slot++)
+        {
+            threads.emplace_back([&, slot]() {
+                for (const Edge &edge : slot_edges[slot])
+                {
+                    graph.add_edge_concurrent(slot, edge.base, edge.head, edge.data);
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        graph.finalize();
+
+        // The serial bfs visits the neighbors in the order of the adjacency structure, so the members also check that order
+        graph.set_num_threads(1);
+        ComponentLabels labels;
+        graph.get_component_labels(labels);
+        REQUIRE(labels.component_of == expected.component_of);
+        REQUIRE(labels.members == expected.members);
+        REQUIRE(labels.percolation_dims == expected.percolation_dims);
+    }
+}
+
+TEST_CASE("The parallel analysis should yield the same results as the serial one", "[graph parallel]")
+{
+    const size_t num_vertices = 2000;
+    const size_t num_edges = 1800;
+
+    std::mt19937 engine(GENERATE(6u, 7u));
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+    PercolationGraph graph;
+    graph.reserve_vertices(num_vertices + 500);
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        TranslationVector trans;
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        graph.add_edge(vertex_distr(engine), vertex_distr(engine), trans);
+    }
+
+    std::vector<ComponentInfo> expected = graph.get_component_percolation_info();
+
+    graph.set_num_threads(GENERATE(0, 2, 4));
+    std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+
+    REQUIRE(components.size() == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(components[c].component_index == expected[c].component_index);
+        REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+        REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+        for (size_t v = 0; v < expected[c].vertices.size(); v++)
+        {
+            REQUIRE(components[c].vertices[v].index == expected[c].vertices[v].index);
+        }
+    }
+}
+
+TEST_CASE("The parallel search should handle components with narrow and wide bfs levels", "[graph parallel]")
+{
+    // A long chain ending in a periodic cubic lattice, so the bfs switches from single vertices to wide levels
+    const size_t chain_length = 5000;
+    const size_t lattice_size = 24;
+
+    TranslationVector zero;
+    PercolationGraph graph;
+    for (size_t v = 0; v + 1 < chain_length; v++)
+    {
+        graph.add_edge(v, v + 1, zero);
+    }
+    for (size_t x = 0; x < lattice_size; x++)
+    {
+        for (size_t y = 0; y < lattice_size; y++)
+        {
+            for (size_t z = 0; z < lattice_size; z++)
+            {
+                size_t coords[3] = {x, y, z};
+                size_t vertex = chain_length + (x * lattice_size + y) * lattice_size + z;
+                for (size_t i = 0; i < 3; i++)
+                {
+                    // Neighbor along axis i, wrapping around the cell boundary
+                    size_t neighbor_coords[3] = {x, y, z};
+                    neighbor_coords[i] = (coords[i] + 1) % lattice_size;
+                    TranslationVector trans;
+                    trans.vec[i] = (coords[i] + 1 == lattice_size ? 1 : 0);
+                    size_t neighbor = chain_length + (neighbor_coords[0] * lattice_size + neighbor_coords[1]) * lattice_size + neighbor_coords[2];
+                    graph.add_edge(vertex, neighbor, trans);
+                }
+            }
+        }
+    }
+    graph.add_edge(chain_length - 1, chain_length, zero);
+
+    ComponentLabels expected;
+    graph.get_component_labels(expected);
+    REQUIRE(expected.get_num_components() == 1);
+    REQUIRE(expected.percolation_dims[0] == 3);
+
+    ComponentLabels labels;
+    graph.set_num_threads(GENERATE(2, 4));
+    graph.get_component_labels(labels);
+    REQUIRE(labels.get_num_components() == 1);
+    REQUIRE(labels.percolation_dims == expected.percolation_dims);
+
+    // The members are in the order of the serial bfs, whatever the thread timing
+    REQUIRE(labels.members == expected.members);
+}
+
+TEST_CASE("The parallel labeling should number large graphs like the serial analysis", "[graph parallel]")
+{
+    const size_t num_vertices = 40000;
+
+    std::mt19937 engine(GENERATE(13u, 14u));
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+
+    // Around the percolation threshold of the random graph, there is a giant component next to many small ones
+    PercolationGraph graph;
+    const size_t num_edges = GENERATE(20000, 40000);
+    for (size_t e = 0; e < num_edges; e++)
+    {
+        TranslationVector trans;
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        graph.add_edge(vertex_distr(engine), vertex_distr(engine), trans);
+    }
+
+    ComponentLabels expected;
+    graph.get_component_labels(expected);
+
+    ComponentLabels labels;
+    graph.set_num_threads(GENERATE(2, 4, 8));
+    graph.get_component_labels(labels);
+
+    REQUIRE(labels.get_num_components() == expected.get_num_components());
+    REQUIRE(labels.component_of == expected.component_of);
+    REQUIRE(labels.offsets == expected.offsets);
+    REQUIRE(labels.sizes == expected.sizes);
+    REQUIRE(labels.percolation_dims == expected.percolation_dims);
+    REQUIRE(labels.members == expected.members);
+}
+
+TEST_CASE("The label representation should describe the same components as the incremental analysis", "[graph labels]")
+{
+    const size_t num_vertices = 1500;
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+    std::mt19937 engine(GENERATE(8u, 9u));
+
+    // The same labels object is reused for graphs of decreasing size
+    ComponentLabels labels;
+    const size_t num_threads = GENERATE(1, 3);
+    for (size_t graph_vertices : {num_vertices, num_vertices / 3})
+    {
+        std::uniform_int_distribution<size_t> vertex_distr(0, graph_vertices - 1);
+        PercolationGraph graph;
+        IncrementalPercolationGraph incremental;
+        graph.set_num_threads(num_threads);
+        graph.reserve_vertices(graph_vertices);
+        incremental.reserve_vertices(graph_vertices);
+        for (size_t e = 0; e < graph_vertices; e++)
+        {
+            size_t base = vertex_distr(engine);
+            size_t head = vertex_distr(engine);
+            TranslationVector trans;
+            for (size_t i = 0; i < vector_space_dimension; i++)
+            {
+                trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+            }
+            graph.add_edge(base, head, trans);
+            incremental.add_edge(base, head, trans);
+        }
+
+        graph.get_component_labels(labels);
+        std::vector<ComponentInfo> expected = incremental.get_component_percolation_info();
+
+        REQUIRE(labels.get_num_components() == expected.size());
+        REQUIRE(labels.component_of.size() == graph_vertices);
+        REQUIRE(labels.offsets.size() == expected.size() + 1);
+        REQUIRE(labels.offsets.back() == graph_vertices);
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(labels.percolation_dims[c] == expected[c].percolation_dim);
+            REQUIRE(labels.sizes[c] == expected[c].vertices.size());
+            Span<size_t> members = labels.get_members(c);
+            REQUIRE(members.size() == expected[c].vertices.size());
+            REQUIRE(members[0] == expected[c].vertices[0].index);
+            for (size_t vertex : members)
+            {
+                REQUIRE(labels.component_of[vertex] == c);
+            }
+        }
+
+        // The adapter yields the same components
+        std::vector<ComponentInfo> components = labels.to_component_info();
+        REQUIRE(components.size() == expected.size());
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(components[c].component_index == c);
+            REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+            REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+            REQUIRE(components[c].vertices[0].index == labels.get_members(c)[0]);
+        }
+    }
+}
+
+TEST_CASE("The early-exit queries should agree with the full analysis", "[graph queries]")
+{
+    const size_t num_vertices = 1500;
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+    std::mt19937 engine(GENERATE(10u, 11u, 12u));
+
+    PercolationGraph graph;
+    graph.reserve_vertices(num_vertices);
+    for (size_t e = 0; e < num_vertices; e++)
+    {
+        TranslationVector trans;
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        graph.add_edge(vertex_distr(engine), vertex_distr(engine), trans);
+    }
+
+    ComponentLabels labels;
+    graph.get_component_labels(labels);
+
+    PercolationGraph::AnalysisWorkspace workspace;
+    for (size_t min_size : {0, 2, 10, 100, 2000})
+    {
+        size_t expected_max = 0;
+        for (size_t c = 0; c < labels.get_num_components(); c++)
+        {
+            if (labels.sizes[c] >= min_size)
+            {
+                expected_max = std::max(expected_max, labels.percolation_dims[c]);
+            }
+        }
+
+        REQUIRE(graph.max_percolation_dim(min_size) == expected_max);
+        REQUIRE(graph.max_percolation_dim(min_size, workspace) == expected_max);
+        for (size_t dim = 0; dim <= vector_space_dimension + 1; dim++)
+        {
+            bool expected_reach = (dim <= expected_max) && (min_size <= num_vertices);
+            REQUIRE(graph.any_component_reaches(dim, min_size, workspace) == expected_reach);
+        }
+    }
+}
+
+TEST_CASE("The axis query should check the directions of a single component", "[graph queries]")
+{
+    PercolationGraph graph;
+
+    TranslationVector trans_z, trans_xy, trans_zero;
+
+    trans_z.vec[0] = 0;
+    trans_z.vec[1] = 0;
+    trans_z.vec[2] = 1;
+
+    trans_xy.vec[0] = 1;
+    trans_xy.vec[1] = 1;
+    trans_xy.vec[2] = 0;
+
+    trans_zero.vec[0] = 0;
+    trans_zero.vec[1] = 0;
+    trans_zero.vec[2] = 0;
+
+    // A chain along z made of a single vertex
+    graph.add_edge(0, 0, trans_z);
+
+    // A diagonal chain in the xy plane made of three vertices
+    graph.add_edge(1, 2, trans_zero);
+    graph.add_edge(2, 3, trans_zero);
+    graph.add_edge(3, 1, trans_xy);
+
+    REQUIRE(graph.percolates_along(0b000));
+    REQUIRE(graph.percolates_along(0b100));
+    REQUIRE(graph.percolates_along(0b011));
+    REQUIRE(graph.percolates_along(0b001));
+    REQUIRE_FALSE(graph.percolates_along(0b101));
+    REQUIRE_FALSE(graph.percolates_along(0b111));
+    REQUIRE_FALSE(graph.percolates_along(0b1000));
+
+    // The chain along z is too small
+    REQUIRE_FALSE(graph.percolates_along(0b100, 2));
+    REQUIRE(graph.percolates_along(0b010, 2));
+    REQUIRE_FALSE(graph.percolates_along(0b000, 4));
+
+    REQUIRE(graph.max_percolation_dim() == 1);
+    REQUIRE_FALSE(graph.any_component_reaches(2));
+}
+
+TEST_CASE("Graphs built in a frame arena should not allocate memory after the first frame", "[frame arena]")
+{
+    const size_t num_vertices = 3000;
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+    std::mt19937 engine(16u);
+
+    FrameArena arena;
+    ComponentLabels labels;
+    ComponentLabels expected;
+    PercolationGraph::AnalysisWorkspace workspace;
+    const size_t *members_data = nullptr;
+    for (size_t frame = 0; frame < 4; frame++)
+    {
+        arena.reset();
+        REQUIRE(arena.get_used() == 0);
+        size_t upstream_allocations = arena.get_num_upstream_allocations();
+        {
+            PercolationGraph graph(&arena);
+            PercolationGraph heap_graph;
+            for (size_t e = 0; e < num_vertices; e++)
+            {
+                size_t base = vertex_distr(engine);
+                size_t head = vertex_distr(engine);
+                TranslationVector trans;
+                for (size_t i = 0; i < vector_space_dimension; i++)
+                {
+                    trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+                }
+                graph.add_edge(base, head, trans);
+                heap_graph.add_edge(base, head, trans);
+            }
+            graph.reserve_vertices(num_vertices);
+            heap_graph.reserve_vertices(num_vertices);
+
+            graph.get_component_labels(labels, workspace);
+            heap_graph.get_component_labels(expected);
+            REQUIRE(labels.component_of == expected.component_of);
+            REQUIRE(labels.percolation_dims == expected.percolation_dims);
+        }
+
+        // The first frame takes memory from upstream, the next reset enlarges the buffer to hold all of it
+        if (frame > 0)
+        {
+            REQUIRE(arena.get_num_upstream_allocations() == upstream_allocations);
+            REQUIRE(labels.members.data() == members_data);
+        }
+        REQUIRE(arena.get_used() > 0);
+        members_data = labels.members.data();
+    }
+    REQUIRE(arena.get_capacity() > 0);
+}
+
+TEST_CASE("Converting a molecular graph in a frame arena should not allocate memory after the first frame", "[frame arena]")
+{
+    const size_t num_atoms = 3000;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 15.0;
+    basis[1][0] = 2.0;
+    basis[1][1] = 15.0;
+    basis[2][2] = 15.0;
+
+    std::mt19937 engine(19u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+
+    mol::MolecularGraph frame(num_atoms);
+    REQUIRE(frame.set_basis(basis));
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        frame.set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+    }
+    REQUIRE(frame.add_bonds_within_cutoff(1.0));
+
+    FrameArena arena;
+    ComponentLabels labels;
+    ComponentLabels expected;
+    frame.get_percolation_graph().get_component_labels(expected);
+    PercolationGraph::AnalysisWorkspace workspace;
+    CountingResource default_resource;
+    for (size_t f = 0; f < 4; f++)
+    {
+        arena.reset();
+        size_t allocations_before = num_global_allocations;
+        std::pmr::memory_resource *previous_resource = std::pmr::set_default_resource(&default_resource);
+        {
+            PercolationGraph graph = frame.get_percolation_graph(&arena);
+            graph.get_component_labels(labels, workspace);
+        }
+        std::pmr::set_default_resource(previous_resource);
+        size_t allocations = num_global_allocations - allocations_before + default_resource.num_allocations;
+        default_resource.num_allocations = 0;
+
+        REQUIRE(labels.component_of == expected.component_of);
+        REQUIRE(labels.percolation_dims == expected.percolation_dims);
+        if (f > 0)
+        {
+            REQUIRE(allocations == 0);
+        }
+    }
+}
+
+TEST_CASE("The compact graph should store edges in packed form and agree with the full analysis", "[compact graph]")
+{
+    // Packing keeps every representable entry and rejects the others
+    TranslationVector trans;
+    BasicPackedTranslation<3, 2> packed;
+    for (int x = -2; x <= 1; x++)
+    {
+        trans.vec[0] = x;
+        trans.vec[1] = -1 - x;
+        trans.vec[2] = 1;
+        REQUIRE(BasicPackedTranslation<3, 2>::pack(trans, packed));
+        REQUIRE(packed.unpack<int64_t>() == trans);
+    }
+    trans.vec[2] = 2;
+    REQUIRE_FALSE(BasicPackedTranslation<3, 2>::pack(trans, packed));
+    BasicPackedTranslation<3, 4> wide_packed;
+    REQUIRE(BasicPackedTranslation<3, 4>::pack(trans, wide_packed));
+    REQUIRE(wide_packed.unpack<int64_t>() == trans);
+    REQUIRE(sizeof(packed) == 1);
+    REQUIRE(sizeof(wide_packed) == 2);
+
+    // Limits wider than the coordinate type of the input
+    BasicTranslationVector<3, int8_t> narrow_trans;
+    narrow_trans.vec[0] = -128;
+    narrow_trans.vec[1] = 0;
+    narrow_trans.vec[2] = 127;
+    BasicPackedTranslation<3, 16> narrow_packed;
+    REQUIRE(BasicPackedTranslation<3, 16>::pack(narrow_trans, narrow_packed));
+    REQUIRE(narrow_packed.unpack<int8_t>() == narrow_trans);
+
+    const size_t num_vertices = 2000;
+    std::uniform_int_distribution<size_t> vertex_distr(0, num_vertices - 1);
+    std::uniform_int_distribution<int> trans_distr(-1, 1);
+    std::mt19937 engine(GENERATE(17u, 18u));
+
+    PercolationGraph graph;
+    CompactPercolationGraph compact;
+    for (size_t e = 0; e < num_vertices; e++)
+    {
+        size_t base = vertex_distr(engine);
+        size_t head = vertex_distr(engine);
+        for (size_t i = 0; i < vector_space_dimension; i++)
+        {
+            trans.vec[i] = (trans_distr(engine) == 1 ? trans_distr(engine) : 0);
+        }
+        graph.add_edge(base, head, trans);
+        REQUIRE(compact.add_edge(base, head, trans));
+    }
+    REQUIRE(compact.get_num_edges() == num_vertices);
+    REQUIRE(compact.get_edge_memory() == 9 * num_vertices);
+
+    size_t base, head;
+    CompactPercolationGraph::translation_type stored_trans;
+    compact.get_edge(num_vertices - 1, base, head, stored_trans);
+    REQUIRE(TranslationVector(stored_trans) == trans);
+
+    // Indices beyond 32 bits are rejected
+    REQUIRE_FALSE(compact.reserve_vertices(size_t(1) << 33));
+
+    // The analysis takes Index parents and basis slots, a one byte rank and 32 bit offsets per vertex
+    REQUIRE(CompactPercolationGraph::analysis_graph_type::get_vertex_memory() == 21);
+
+    std::vector<ComponentInfo> expected = graph.get_component_percolation_info();
+    CompactPercolationGraph::analysis_graph_type analysis_graph;
+    for (size_t run = 0; run < 2; run++)
+    {
+        std::vector<ComponentInfo> components = compact.get_component_percolation_info(analysis_graph);
+        REQUIRE(components.size() == expected.size());
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(components[c].component_index == expected[c].component_index);
+            REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+            REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+            // The bfs lists the members in discovery order, the union-find in increasing index order
+            std::vector<size_t> expected_members, members;
+            for (size_t v = 0; v < expected[c].vertices.size(); v++)
+            {
+                expected_members.push_back(expected[c].vertices[v].index);
+                members.push_back(components[c].vertices[v].index);
+            }
+            std::sort(expected_members.begin(), expected_members.end());
+            REQUIRE(members == expected_members);
+        }
+    }
+}
+
+TEST_CASE("Translation bases should detect linear independence", "[translation basis]")
+{
+    auto make_vector = [](translation_coordinate_type x, translation_coordinate_type y, translation_coordinate_type z) {
+        TranslationVector res;
+        res.vec[0] = x;
+        res.vec[1] = y;
+        res.vec[2] = z;
+        return res;
+    };
+
+    TranslationBasis basis;
+    REQUIRE(!basis.insert(make_vector(0, 0, 0)));
+    REQUIRE(basis.insert(make_vector(2, 4, 0)));
+    REQUIRE(!basis.insert(make_vector(-1, -2, 0)));
+    REQUIRE(basis.insert(make_vector(1, 1, 0)));
+    REQUIRE(!basis.is_independent(make_vector(3, -7, 0)));
+    REQUIRE(basis.is_independent(make_vector(3, -7, 1)));
+    REQUIRE(basis.size() == 2);
+    REQUIRE(basis.insert(make_vector(0, 0, -3)));
+    REQUIRE(!basis.insert(make_vector(5, 1, 2)));
+    REQUIRE(basis.size() == 3);
+    REQUIRE(basis[0] == make_vector(2, 4, 0));
+
+    // Entries large enough to overflow the squared entries of a Gram matrix
+    const translation_coordinate_type large = 3000000000;
+    std::vector<TranslationVector> existing_base;
+    existing_base.push_back(make_vector(large, 1, 0));
+    REQUIRE(check_translation_independent(existing_base, make_vector(large, 2, 0)));
+    REQUIRE(!check_translation_independent(existing_base, make_vector(-2 * large, -2, 0)));
+}
+
+TEST_CASE("Graphs of other dimensions and coordinate types should be supported", "[graph templates]")
+{
+    using Graph2D = BasicPercolationGraph<2, int8_t>;
+    using Translation2D = Graph2D::translation_type;
+
+    Translation2D step_x = Translation2D::zero();
+    step_x[0] = 1;
+    Translation2D step_y = Translation2D::zero();
+    step_y[1] = 1;
+
+    // A ring crossing the boundary more often than the coordinate type can count
+    const size_t ring_size = 300;
+    Graph2D graph;
+    BasicIncrementalPercolationGraph<2, int8_t> incremental;
+    for (size_t i = 0; i < ring_size; i++)
+    {
+        graph.add_edge(i, (i + 1) % ring_size, step_x);
+        incremental.add_edge(i, (i + 1) % ring_size, step_x);
+    }
+    // A sheet in the xy plane
+    graph.add_edge(ring_size, ring_size, step_x);
+    graph.add_edge(ring_size, ring_size + 1, step_y);
+    graph.add_edge(ring_size + 1, ring_size, Translation2D::zero());
+
+    std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+    REQUIRE(components.size() == 2);
+    REQUIRE(components[0].vertices.size() == ring_size);
+    REQUIRE(components[0].percolation_dim == 1);
+    REQUIRE(components[1].percolation_dim == 2);
+    REQUIRE(incremental.get_percolation_dim(0) == 1);
+
+    // Dependent translations far beyond the 8 bit range
+    std::vector<BasicTranslationVector<2, int32_t>> existing_base(1);
+    existing_base[0][0] = 100000;
+    existing_base[0][1] = 30000;
+    BasicTranslationVector<2, int32_t> multiple;
+    multiple[0] = 300000;
+    multiple[1] = 90000;
+    REQUIRE(!check_translation_independent(existing_base, multiple));
+}
+
+TEST_CASE("The batch frame analysis should match the analysis of the single frames", "[frame analysis]")
+{
+    const size_t num_frames = 12;
+    const size_t num_atoms = 20;
+
+    // Frame f is a chain of atoms along the axis f % 3, closed across the periodic boundary for even frames
+    auto fill_frame = [&](size_t frame_index, mol::MolecularGraph &frame) {
+        std::vector<vec<double>> basis(3);
+        basis[0][0] = basis[1][1] = basis[2][2] = 10.0;
+        frame.set_atom_count(num_atoms);
+        frame.set_basis(basis);
+        for (size_t a = 0; a < num_atoms; a++)
+        {
+            vec<double> pos;
+            pos[frame_index % 3] = 10.0 * double(a) / double(num_atoms);
+            frame.set_atom_position(a, pos);
+        }
+        for (size_t a = 1; a < num_atoms; a++)
+        {
+            frame.add_bond(a - 1, a);
+        }
+        if (frame_index % 2 == 0)
+        {
+            frame.add_bond(num_atoms - 1, 0);
+        }
+    };
+
+    std::vector<mol::MolecularGraph> frames(num_frames);
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        fill_frame(f, frames[f]);
+    }
+
+    mol::FrameAnalysisOptions options;
+    options.num_threads = GENERATE(1, 3);
+
+    std::vector<mol::FrameResult> from_provider = mol::analyze_frames(num_frames, fill_frame, options);
+    std::vector<mol::FrameResult> from_memory = mol::analyze_frames(frames, options);
+
+    REQUIRE(from_provider.size() == num_frames);
+    REQUIRE(from_memory.size() == num_frames);
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        std::vector<ComponentInfo> expected = frames[f].get_percolation_graph().get_component_percolation_info();
+        for (const std::vector<mol::FrameResult> *results : {&from_provider, &from_memory})
+        {
+            const mol::FrameResult &result = (*results)[f];
+            REQUIRE(result.frame_index == f);
+            REQUIRE(result.max_percolation_dim == (f % 2 == 0 ? 1 : 0));
+            REQUIRE(result.components.size() == expected.size());
+            for (size_t c = 0; c < expected.size(); c++)
+            {
+                REQUIRE(result.components[c].percolation_dim == expected[c].percolation_dim);
+                REQUIRE(result.components[c].vertices.size() == expected[c].vertices.size());
+            }
+        }
+    }
+}
+
+TEST_CASE("The gel point search should find the onset of every percolation dimension", "[gel points]")
+{
+    const size_t num_frames = 100;
+    const size_t chain_length = 10;
+    const std::vector<size_t> thresholds = GENERATE(std::vector<size_t>{13, 40, 77}, std::vector<size_t>{0, 0, 99}, std::vector<size_t>{5, 50, 200});
+
+    // Three chains along the axes sharing atom 0. The chain along axis a is closed across the periodic boundary from frame thresholds[a] on
+    auto fill_frame = [&](size_t frame_index, mol::MolecularGraph &frame) {
+        std::vector<vec<double>> basis(3);
+        basis[0][0] = basis[1][1] = basis[2][2] = 10.0;
+        frame.set_atom_count(1 + 3 * (chain_length - 1));
+        frame.set_basis(basis);
+        frame.set_atom_position(0, vec<double>());
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            size_t previous = 0;
+            for (size_t a = 1; a < chain_length; a++)
+            {
+                size_t atom = 1 + axis * (chain_length - 1) + (a - 1);
+                vec<double> pos;
+                pos[axis] = 10.0 * double(a) / double(chain_length);
+                frame.set_atom_position(atom, pos);
+                frame.add_bond(previous, atom);
+                previous = atom;
+            }
+            if (frame_index >= thresholds[axis])
+            {
+                frame.add_bond(previous, 0);
+            }
+        }
+    };
+
+    std::vector<size_t> expected;
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        expected.push_back(thresholds[axis] < num_frames ? thresholds[axis] : mol::no_gel_point);
+    }
+
+    mol::GelPointOptions options;
+    options.coarse_stride = GENERATE(0, 8);
+    options.num_threads = 2;
+    mol::GelPointResult result = mol::find_gel_points(num_frames, fill_frame, options);
+
+    REQUIRE(result.onset_frames == expected);
+    if (options.coarse_stride == 0)
+    {
+        // At most one bisection over the trajectory per dimension
+        REQUIRE(result.num_analyzed_frames <= 3 * 8);
+    }
+    else
+    {
+        REQUIRE(result.num_analyzed_frames <= num_frames / options.coarse_stride + 2 + 3 * 3);
+    }
+}
+
+namespace
+{
+    // Gives the tests access to the bond lists
+    struct InspectableMolecularGraph : public mol::MolecularGraph
+    {
+        using mol::MolecularGraph::bonds;
+    };
+}
+
+TEST_CASE("Bonds within a cutoff should match the all-pairs search", "[cutoff bonds]")
+{
+    const size_t num_atoms = 600;
+    const double cutoff = 1.8;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 10.0;
+    basis[1][0] = 2.0;
+    basis[1][1] = 9.0;
+    basis[2][0] = 1.0;
+    basis[2][1] = 1.5;
+    basis[2][2] = 11.0;
+
+    std::mt19937 engine(8u);
+    std::uniform_real_distribution<double> coeff_distr(-0.2, 1.2);
+
+    const bool use_filter = GENERATE(false, true);
+    mol::BondFilter filter;
+    if (use_filter)
+    {
+        filter = [](size_t atom_index_1, size_t atom_index_2) { return (atom_index_1 + atom_index_2) % 3 != 0; };
+    }
+
+    InspectableMolecularGraph expected, cell_list;
+    expected.set_atom_count(num_atoms);
+    cell_list.set_atom_count(num_atoms);
+    REQUIRE(expected.set_basis(basis));
+    REQUIRE(cell_list.set_basis(basis));
+
+    std::vector<vec<double>> positions(num_atoms);
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        positions[i] = basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine);
+        expected.set_atom_position(i, positions[i]);
+        cell_list.set_atom_position(i, positions[i]);
+        for (size_t prev = 0; prev < i; prev++)
+        {
+            vec<double> coeff = normalize_basis_coefficients(decompose(positions[i] - positions[prev], basis));
+            vec<double> per_diff = basis[0] * coeff[0] + basis[1] * coeff[1] + basis[2] * coeff[2];
+            if (per_diff.norm2() < cutoff * cutoff && (!filter || filter(prev, i)))
+            {
+                expected.add_bond(prev, i);
+            }
+        }
+    }
+
+    cell_list.set_num_threads(GENERATE(1, 3));
+    REQUIRE(cell_list.add_bonds_within_cutoff(cutoff, filter));
+
+    size_t num_bonds = 0;
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        std::vector<size_t> expected_bonds = expected.bonds[i];
+        std::vector<size_t> bonds = cell_list.bonds[i];
+        std::sort(expected_bonds.begin(), expected_bonds.end());
+        std::sort(bonds.begin(), bonds.end());
+        REQUIRE(bonds == expected_bonds);
+        num_bonds += bonds.size();
+    }
+    REQUIRE(num_bonds > 0);
+
+    // The cutoff needs to be less than half the cell width
+    REQUIRE(!cell_list.add_bonds_within_cutoff(5.0));
+    REQUIRE(!cell_list.add_bonds_within_cutoff(0.0));
+}
+
+TEST_CASE("The vectorized coordinate kernels should match the scalar reference", "[coordinate kernels]")
+{
+    // Not a multiple of the vector width to cover the remainder loops
+    const size_t num_atoms = 1003;
+    const size_t num_bonds = 2005;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 12.0;
+    basis[1][0] = -3.0;
+    basis[1][1] = 10.0;
+    basis[2][0] = 2.5;
+    basis[2][1] = 1.0;
+    basis[2][2] = 9.0;
+
+    std::mt19937 engine(9u);
+    std::uniform_real_distribution<double> pos_distr(-30.0, 30.0);
+    std::uniform_int_distribution<size_t> atom_distr(0, num_atoms - 1);
+
+    std::vector<vec<double>> positions(num_atoms);
+    for (vec<double> &pos : positions)
+    {
+        pos.x = pos_distr(engine);
+        pos.y = pos_distr(engine);
+        pos.z = pos_distr(engine);
+    }
+    std::vector<size_t> bond_base(num_bonds), bond_head(num_bonds);
+    for (size_t b = 0; b < num_bonds; b++)
+    {
+        bond_base[b] = atom_distr(engine);
+        bond_head[b] = atom_distr(engine);
+    }
+
+    std::vector<double> ref_x(num_atoms), ref_y(num_atoms), ref_z(num_atoms);
+    mol::normalize_positions(positions.data(), num_atoms, basis, ref_x.data(), ref_y.data(), ref_z.data(), mol::KernelLevel::scalar);
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        vec<double> coeff = normalize_basis_coefficients(decompose(positions[i], basis));
+        REQUIRE(ref_x[i] == coeff.x);
+        REQUIRE(ref_y[i] == coeff.y);
+        REQUIRE(ref_z[i] == coeff.z);
+    }
+    std::vector<int8_t> ref_tx(num_bonds), ref_ty(num_bonds), ref_tz(num_bonds);
+    mol::compute_bond_translations(ref_x.data(), ref_y.data(), ref_z.data(), bond_base.data(), bond_head.data(), num_bonds,
+                                   ref_tx.data(), ref_ty.data(), ref_tz.data(), mol::KernelLevel::scalar);
+
+    // Only check the instruction sets the machine supports
+    for (mol::KernelLevel level : {mol::KernelLevel::avx2, mol::KernelLevel::avx512})
+    {
+        if (int(level) > int(mol::get_supported_kernel_level()))
+        {
+            continue;
+        }
+
+        std::vector<double> coeff_x(num_atoms), coeff_y(num_atoms), coeff_z(num_atoms);
+        mol::normalize_positions(positions.data(), num_atoms, basis, coeff_x.data(), coeff_y.data(), coeff_z.data(), level);
+        REQUIRE(coeff_x == ref_x);
+        REQUIRE(coeff_y == ref_y);
+        REQUIRE(coeff_z == ref_z);
+
+        std::vector<int8_t> trans_x(num_bonds), trans_y(num_bonds), trans_z(num_bonds);
+        mol::compute_bond_translations(coeff_x.data(), coeff_y.data(), coeff_z.data(), bond_base.data(), bond_head.data(), num_bonds,
+                                       trans_x.data(), trans_y.data(), trans_z.data(), level);
+        REQUIRE(trans_x == ref_tx);
+        REQUIRE(trans_y == ref_ty);
+        REQUIRE(trans_z == ref_tz);
+    }
+}
+
+TEST_CASE("The parallel conversion into a percolation graph should match the serial one", "[parallel conversion]")
+{
+    // Enough atoms for several conversion blocks
+    const size_t num_atoms = 10000;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 20.0;
+    basis[1][0] = 3.0;
+    basis[1][1] = 20.0;
+    basis[2][2] = 20.0;
+
+    std::mt19937 engine(10u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+
+    mol::MolecularGraph frame(num_atoms);
+    REQUIRE(frame.set_basis(basis));
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        frame.set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+    }
+    REQUIRE(frame.add_bonds_within_cutoff(1.0));
+
+    std::vector<ComponentInfo> expected = frame.get_percolation_graph().get_component_percolation_info();
+
+    frame.set_num_threads(GENERATE(0, 3));
+    PercolationGraph graph;
+    mol::ConversionWorkspace workspace;
+    frame.fill_percolation_graph(graph, workspace);
+    std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+
+    REQUIRE(components.size() == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+        REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+    }
+
+    // The compact graph holds the same bonds
+    CompactPercolationGraph compact;
+    REQUIRE(frame.fill_percolation_graph(compact, workspace));
+    std::vector<ComponentInfo> compact_components = compact.get_component_percolation_info();
+    REQUIRE(compact_components.size() == expected.size());
+    for (size_t c = 0; c < expected.size(); c++)
+    {
+        REQUIRE(compact_components[c].percolation_dim == expected[c].percolation_dim);
+        REQUIRE(compact_components[c].vertices.size() == expected[c].vertices.size());
+    }
+}
+
+TEST_CASE("Frames written to a binary frame file should be read back identically", "[frame file]")
+{
+    const std::string path = "frame_file_test.bin";
+    const size_t num_frames = 4;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 8.0;
+    basis[1][0] = 1.0;
+    basis[1][1] = 7.0;
+    basis[2][2] = 9.0;
+
+    std::mt19937 engine(11u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+
+    std::vector<mol::MolecularGraph> frames(num_frames);
+    mol::FrameFileWriter writer;
+    REQUIRE(writer.open(path));
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        frames[f].set_atom_count(300 + 50 * f);
+        frames[f].set_basis(basis);
+        for (size_t i = 0; i < frames[f].get_atom_count(); i++)
+        {
+            frames[f].set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+        }
+        frames[f].add_bonds_within_cutoff(1.6);
+        REQUIRE(writer.write_frame(frames[f], f % 2 == 1));
+    }
+    REQUIRE(writer.close());
+
+    mol::FrameFileReader reader;
+    REQUIRE(reader.open(path));
+    REQUIRE(reader.get_num_frames() == num_frames);
+
+    mol::MolecularGraph frame;
+    PercolationGraph graph;
+    mol::ConversionWorkspace workspace;
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        mol::FrameView view;
+        REQUIRE(reader.get_frame(f, view));
+        REQUIRE(view.num_atoms == frames[f].get_atom_count());
+        REQUIRE((view.trans_x != nullptr) == (f % 2 == 1));
+        for (size_t i = 0; i < view.num_atoms; i++)
+        {
+            REQUIRE((view.positions[i] - frames[f].get_atom_positions()[i]).norm2() == 0.0);
+        }
+
+        REQUIRE(reader.read_frame(f, frame));
+        for (size_t i = 0; i < view.num_atoms; i++)
+        {
+            std::vector<size_t> bonds = frame.get_bonds(i);
+            std::vector<size_t> expected_bonds = frames[f].get_bonds(i);
+            std::sort(bonds.begin(), bonds.end());
+            std::sort(expected_bonds.begin(), expected_bonds.end());
+            REQUIRE(bonds == expected_bonds);
+        }
+
+        std::vector<ComponentInfo> expected = frames[f].get_percolation_graph().get_component_percolation_info();
+        REQUIRE(reader.fill_percolation_graph(f, graph, workspace));
+        std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+        REQUIRE(components.size() == expected.size());
+        for (size_t c = 0; c < expected.size(); c++)
+        {
+            REQUIRE(components[c].percolation_dim == expected[c].percolation_dim);
+            REQUIRE(components[c].vertices.size() == expected[c].vertices.size());
+        }
+    }
+    mol::FrameView view;
+    REQUIRE(!reader.get_frame(num_frames, view));
+    reader.close();
+    std::remove(path.c_str());
+
+    REQUIRE(!reader.open(path));
+}
+
+TEST_CASE("LAMMPS data and dump files should be read into the molecular graph", "[lammps reader]")
+{
+    const std::string data_path = "lammps_test.data";
+    const std::string dump_path = "lammps_test.dump";
+    const std::string bond_dump_path = "lammps_test_bonds.dump";
+    const size_t num_atoms = 3000;
+    const double xy = 1.5, xz = -1.0, yz = 0.5;
+
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = 30.0;
+    basis[1][0] = xy;
+    basis[1][1] = 28.0;
+    basis[2][0] = xz;
+    basis[2][1] = yz;
+    basis[2][2] = 29.0;
+
+    std::mt19937 engine(5u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+    std::uniform_int_distribution<int> image_distr(-2, 2);
+
+    mol::MolecularGraph expected;
+    expected.set_atom_count(num_atoms);
+    expected.set_basis(basis);
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        expected.set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+    }
+    expected.add_bonds_within_cutoff(1.4);
+
+    // Non-contiguous ids in shuffled order, the atom with index i has id stride * i + 7. 
+    // The large stride is too sparse for a dense lookup table, as in dumps restricted to a group of atoms.
+    const size_t id_stride = GENERATE(3, 1000);
+    auto atom_id = [&](size_t i) {
+        return id_stride * i + 7;
+    };
+    std::vector<size_t> file_order(num_atoms);
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        file_order[i] = i;
+    }
+    std::shuffle(file_order.begin(), file_order.end(), engine);
+    std::vector<std::pair<size_t, size_t>> bonds;
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        for (size_t j : expected.get_bonds(i))
+        {
+            if (i < j)
+            {
+                bonds.emplace_back(atom_id(i), atom_id(j));
+            }
+        }
+    }
+
+    std::vector<int> images(3 * num_atoms);
+    for (int &image : images)
+    {
+        image = image_distr(engine);
+    }
+    auto wrapped_position = [&](size_t i) {
+        return expected.get_atom_positions()[i] - basis[0] * double(images[3 * i]) - basis[1] * double(images[3 * i + 1]) - basis[2] * double(images[3 * i + 2]);
+    };
+
+    auto check_graph = [&](mol::MolecularGraph &graph, const mol::LammpsAtomInfo &info) {
+        REQUIRE(graph.get_atom_count() == num_atoms);
+        for (size_t i = 0; i < num_atoms; i++)
+        {
+            REQUIRE(info.ids[i] == int64_t(atom_id(i)));
+            REQUIRE(info.types[i] == int64_t(i % 3 + 1));
+            REQUIRE((graph.get_atom_positions()[i] - expected.get_atom_positions()[i]).norm2() < 1e-16);
+            std::vector<size_t> graph_bonds = graph.get_bonds(i);
+            std::vector<size_t> expected_bonds = expected.get_bonds(i);
+            std::sort(graph_bonds.begin(), graph_bonds.end());
+            std::sort(expected_bonds.begin(), expected_bonds.end());
+            REQUIRE(graph_bonds == expected_bonds);
+        }
+
+        std::vector<ComponentInfo> expected_components = expected.get_percolation_graph().get_component_percolation_info();
+        std::vector<ComponentInfo> components = graph.get_percolation_graph().get_component_percolation_info();
+        REQUIRE(components.size() == expected_components.size());
+        for (size_t c = 0; c < components.size(); c++)
+        {
+            REQUIRE(components[c].percolation_dim == expected_components[c].percolation_dim);
+            REQUIRE(components[c].vertices.size() == expected_components[c].vertices.size());
+        }
+    };
+
+    {
+        std::ofstream data(data_path);
+        data.precision(17);
+        data << "LAMMPS data file for testing\n\n"
+             << num_atoms << " atoms\n3 atom types\n"
+             << bonds.size() << " bonds\n1 bond types\n\n"
+             << "-2.0 28.0 xlo xhi\n1.0 29.0 ylo yhi\n0.0 29.0 zlo zhi\n"
+             << xy << " " << xz << " " << yz << " xy xz yz\n\n"
+             << "Masses\n\n1 12.0\n2 14.0\n3 16.0\n\n"
+             << "Atoms # full\n\n";
+        for (size_t i : file_order)
+        {
+            vec<double> pos = wrapped_position(i);
+            data << atom_id(i) << " " << i % 5 << " " << i % 3 + 1 << " 0.0 " << pos.x - 2.0 << " " << pos.y + 1.0 << " " << pos.z << " "
+                 << images[3 * i] << " " << images[3 * i + 1] << " " << images[3 * i + 2] << "\n";
+        }
+        data << "\nBonds\n\n";
+        for (size_t b = 0; b < bonds.size(); b++)
+        {
+            data << b + 1 << " 1 " << bonds[b].first << " " << bonds[b].second << "\n";
+        }
+    }
+
+    mol::MolecularGraph graph;
+    graph.set_num_threads(3);
+    mol::LammpsAtomInfo info;
+    std::string error;
+    REQUIRE(mol::read_lammps_data(data_path, graph, &info, &error));
+    REQUIRE(error.empty());
+    check_graph(graph, info);
+
+    // The same configuration as two dump frames, one with wrapped positions and image flags and one with scaled unwrapped positions
+    {
+        std::ofstream dump(dump_path);
+        std::ofstream bond_dump(bond_dump_path);
+        dump.precision(17);
+        for (size_t timestep = 0; timestep < 2; timestep++)
+        {
+            dump << "ITEM: TIMESTEP\n"
+                 << 100 * timestep << "\nITEM: NUMBER OF ATOMS\n"
+                 << num_atoms << "\nITEM: BOX BOUNDS xy xz yz pp pp pp\n"
+                 << "-2.0 30.5 " << xy << "\n0.0 28.5 " << xz << "\n0.0 29.0 " << yz << "\n";
+            if (timestep == 0)
+            {
+                dump << "ITEM: ATOMS id type x y z ix iy iz\n";
+            }
+            else
+            {
+                dump << "ITEM: ATOMS type xsu ysu zsu id\n";
+            }
+
+            for (size_t i : file_order)
+            {
+                if (timestep == 0)
+                {
+                    vec<double> pos = wrapped_position(i);
+                    dump << atom_id(i) << " " << i % 3 + 1 << " " << pos.x - 1.0 << " " << pos.y << " " << pos.z << " "
+                         << images[3 * i] << " " << images[3 * i + 1] << " " << images[3 * i + 2] << "\n";
+                }
+                else
+                {
+                    // Fractional coordinates with respect to the lower triangular basis
+                    vec<double> pos = expected.get_atom_positions()[i];
+                    double c = pos.z / basis[2][2];
+                    double b = (pos.y - c * yz) / basis[1][1];
+                    double a = (pos.x - b * xy - c * xz) / basis[0][0];
+                    dump << i % 3 + 1 << " " << a << " " << b << " " << c << " " << atom_id(i) << "\n";
+                }
+            }
+
+            bond_dump << "ITEM: TIMESTEP\n"
+                      << 100 * timestep << "\nITEM: NUMBER OF ENTRIES\n"
+                      << bonds.size() << "\nITEM: BOX BOUNDS xy xz yz pp pp pp\n-2.0 30.5 1.5\n0.0 28.5 -1.0\n0.0 29.0 0.5\n"
+                      << "ITEM: ENTRIES index c_bonds[1] c_bonds[2]\n";
+            for (size_t b = 0; b < bonds.size(); b++)
+            {
+                bond_dump << b + 1 << " " << bonds[b].second << " " << bonds[b].first << "\n";
+            }
+        }
+    }
+
+    mol::LammpsDumpReader reader;
+    REQUIRE(reader.open(dump_path, bond_dump_path));
+    for (size_t timestep = 0; timestep < 2; timestep++)
+    {
+        REQUIRE(reader.read_next_frame(graph, &info));
+        REQUIRE(info.timestep == int64_t(100 * timestep));
+        check_graph(graph, info);
+    }
+    REQUIRE(!reader.read_next_frame(graph, &info));
+    REQUIRE(reader.get_error().empty());
+
+    // Bonds to unknown atoms are rejected
+    {
+        std::ofstream data(data_path);
+        data << "Invalid bonds\n\n2 atoms\n1 bonds\n0.0 10.0 xlo xhi\n0.0 10.0 ylo yhi\n0.0 10.0 zlo zhi\n\n"
+             << "Atoms # atomic\n\n1 1 1.0 1.0 1.0\n2 1 2.0 2.0 2.0\n\nBonds\n\n1 1 1 3\n";
+    }
+    REQUIRE(!mol::read_lammps_data(data_path, graph, nullptr, &error));
+    REQUIRE(!error.empty());
+
+    // Also with sparse ids, which are looked up in the sorted ids
+    {
+        std::ofstream data(data_path);
+        data << "Invalid bonds\n\n2 atoms\n1 bonds\n0.0 10.0 xlo xhi\n0.0 10.0 ylo yhi\n0.0 10.0 zlo zhi\n\n"
+             << "Atoms # atomic\n\n1000000 1 1.0 1.0 1.0\n1 1 2.0 2.0 2.0\n\nBonds\n\n1 1 1000000 3\n";
+    }
+    error.clear();
+    REQUIRE(!mol::read_lammps_data(data_path, graph, nullptr, &error));
+    REQUIRE(error == "Bond to unknown atom id 3");
+
+    std::remove(data_path.c_str());
+    std::remove(dump_path.c_str());
+    std::remove(bond_dump_path.c_str());
+}
+
+TEST_CASE("The frame pipeline should deliver all results in frame order", "[frame pipeline]")
+{
+    const size_t num_frames = 40;
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = basis[1][1] = basis[2][2] = 6.0;
+
+    std::mt19937 engine(13u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+    std::vector<mol::MolecularGraph> frames(num_frames);
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        // Frames of very different size, so that later frames overtake earlier ones
+        frames[f].set_atom_count(f % 4 == 0 ? 2000 : 50);
+        frames[f].set_basis(basis);
+        for (size_t i = 0; i < frames[f].get_atom_count(); i++)
+        {
+            frames[f].set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+        }
+    }
+
+    mol::PipelineOptions options;
+    options.num_build_threads = GENERATE(1, 2);
+    options.num_analysis_threads = GENERATE(1, 3);
+    options.queue_capacity = 2;
+    options.prepare_frame = [](mol::MolecularGraph &frame) { frame.add_bonds_within_cutoff(0.8); };
+
+    size_t next_frame = 0;
+    mol::FrameSource source = [&](mol::MolecularGraph &frame, int64_t &timestep) {
+        if (next_frame == num_frames)
+        {
+            return false;
+        }
+        frame = frames[next_frame];
+        timestep = int64_t(10 * next_frame++);
+        return true;
+    };
+
+    std::vector<mol::FrameResult> results;
+    mol::FrameSink sink = [&](const mol::FrameResult &result, const mol::MolecularGraph &frame, int64_t timestep) {
+        REQUIRE(result.frame_index == results.size());
+        REQUIRE(timestep == int64_t(10 * result.frame_index));
+        REQUIRE(frame.get_atom_count() == frames[result.frame_index].get_atom_count());
+        results.push_back(result);
+    };
+    REQUIRE(mol::run_frame_pipeline(source, sink, options) == num_frames);
+
+    for (mol::MolecularGraph &frame : frames)
+    {
+        frame.add_bonds_within_cutoff(0.8);
+    }
+    std::vector<mol::FrameResult> expected = mol::analyze_frames(frames);
+    for (size_t f = 0; f < num_frames; f++)
+    {
+        REQUIRE(results[f].max_percolation_dim == expected[f].max_percolation_dim);
+        REQUIRE(results[f].components.size() == expected[f].components.size());
+        for (size_t c = 0; c < expected[f].components.size(); c++)
+        {
+            REQUIRE(results[f].components[c].percolation_dim == expected[f].components[c].percolation_dim);
+            REQUIRE(results[f].components[c].vertices.size() == expected[f].components[c].vertices.size());
+        }
+    }
+
+    // Exceptions of any stage stop the pipeline and reach the caller
+    next_frame = 0;
+    results.clear();
+    mol::FrameSink failing_sink = [&](const mol::FrameResult &result, const mol::MolecularGraph &, int64_t) {
+        if (result.frame_index == 5)
+        {
+            throw std::runtime_error("sink failed");
+        }
+    };
+    REQUIRE_THROWS_AS(mol::run_frame_pipeline(source, failing_sink, options), std::runtime_error);
+}
+
+TEST_CASE("Statistics should be collected if the library is built with them", "[statistics]")
+{
+    const size_t num_atoms = 800;
+    std::vector<vec<double>> basis(3);
+    basis[0][0] = basis[1][1] = basis[2][2] = 9.0;
+
+    std::mt19937 engine(21u);
+    std::uniform_real_distribution<double> coeff_distr(0.0, 1.0);
+    mol::MolecularGraph frame;
+    frame.set_atom_count(num_atoms);
+    frame.set_basis(basis);
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        frame.set_atom_position(i, basis[0] * coeff_distr(engine) + basis[1] * coeff_distr(engine) + basis[2] * coeff_distr(engine));
+    }
+    frame.add_bonds_within_cutoff(1.0);
+
+    AnalysisStatistics statistics;
+    frame.set_statistics(&statistics);
+    PercolationGraph graph = frame.get_percolation_graph();
+    graph.set_num_threads(GENERATE(1, 3));
+    graph.set_statistics(&statistics);
+    std::vector<ComponentInfo> components = graph.get_component_percolation_info();
+
+    if (!statistics_enabled())
+    {
+        REQUIRE(statistics.num_components == 0);
+        REQUIRE(statistics.vertices_visited == 0);
+        return;
+    }
+
+    size_t num_bonds = 0;
+    size_t max_size = 0;
+    for (size_t i = 0; i < num_atoms; i++)
+    {
+        num_bonds += frame.get_bonds(i).size();
+    }
+    for (const ComponentInfo &component : components)
+    {
+        max_size = std::max(max_size, component.vertices.size());
+    }
+
+    REQUIRE(statistics.num_bonds_converted == num_bonds / 2);
+    REQUIRE(statistics.num_components == components.size());
+    REQUIRE(statistics.vertices_visited == num_atoms);
+    REQUIRE(statistics.queue_pushes == num_atoms - components.size());
+    REQUIRE(statistics.edges_visited == num_bonds);
+    REQUIRE(statistics.peak_queue_length >= 1);
+    REQUIRE(statistics.peak_queue_length <= max_size);
+    REQUIRE(statistics.allocations > 0);
+
+    size_t histogram_total = 0;
+    for (size_t count : statistics.component_size_histogram)
+    {
+        histogram_total += count;
+    }
+    REQUIRE(histogram_total == components.size());
+
+    // A second analysis with a reused workspace does not allocate
+    PercolationGraph::AnalysisWorkspace workspace;
+    graph.get_component_percolation_info(workspace);
+    statistics.reset();
+    graph.get_component_percolation_info(workspace);
+    REQUIRE(statistics.allocations == 0);
+    REQUIRE(statistics.num_components == components.size());
 }
\ No newline at end of file